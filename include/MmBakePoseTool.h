@@ -0,0 +1,93 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_BAKE_POSE_TOOL_H__
+#define __MM_BAKE_POSE_TOOL_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreMesh.h>
+#	include <Ogre/OgreSkeleton.h>
+#	include <Ogre/OgreString.h>
+#	include <Ogre/OgreStringVector.h>
+#else
+#	include <OgreMesh.h>
+#	include <OgreSkeleton.h>
+#	include <OgreString.h>
+#	include <OgreStringVector.h>
+#endif
+
+#include "MmTool.h"
+
+#include <vector>
+
+namespace meshmagick
+{
+    /** Turns skinned meshes into static ones.
+    @par
+        A pose of the skeleton, the binding pose or a frame of one of its animations, is
+        applied to positions, normals, binormals and tangents. Afterwards bone assignments,
+        blend index and blend weight elements and the skeleton link are removed, so that
+        the mesh no longer costs any skinning at runtime.
+    @par
+        The binding pose maps every vertex onto itself, in that case vertex data is left as
+        it is and the skeleton is not loaded at all.
+    */
+    class _MeshMagickExport BakePoseTool : public Tool
+    {
+    public:
+        BakePoseTool();
+
+        Ogre::String getName() const;
+
+        /** Applies the current pose of skeleton to the vertex data of mesh.
+        @par
+            Vertices without bone assignment are left untouched. Bone assignments are
+            kept, use removeSkinning to get rid of them.
+        */
+        void bakePose(Ogre::Mesh* mesh, const Ogre::Skeleton* skeleton) const;
+
+        /// Removes bone assignments, blend elements and the skeleton link from mesh.
+        void removeSkinning(Ogre::Mesh* mesh) const;
+
+    protected:
+        virtual void doInvoke(const OptionList& toolOptions,
+            const Ogre::StringVector& inFileNames,
+            const Ogre::StringVector& outFileNames);
+
+    private:
+        Ogre::String mAnimationName;
+        Ogre::Real mTime;
+
+        void processMeshFile(const Ogre::String& inFile, const Ogre::String& outFile);
+
+        /// Skins vertexData with the given bone matrices, indexed by bone handle.
+        void bakeVertexData(Ogre::VertexData* vertexData,
+            const Ogre::Mesh::VertexBoneAssignmentList& assignments,
+            const std::vector<Ogre::Affine3>& boneMatrices) const;
+
+        static void removeBlendElements(Ogre::VertexData* vertexData);
+    };
+}
+#endif
@@ -0,0 +1,82 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_BUFFERED_FILE_WRITER_H__
+#define __MM_BUFFERED_FILE_WRITER_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreDataStream.h>
+#	include <Ogre/OgreString.h>
+#else
+#	include <OgreDataStream.h>
+#	include <OgreString.h>
+#endif
+
+#include <vector>
+
+namespace meshmagick
+{
+    /** Collects serialised output in memory and writes it to disk in one go.
+    @par
+        Serialisers write into the stream returned by BufferedFileWriter#getStream.
+        BufferedFileWriter#commit then compares the buffer against the current contents
+        of the target file and leaves the file untouched, if both are identical.
+        Otherwise the buffer is written to a temporary file next to the target, which is
+        renamed into place afterwards. This way the target is never left half written,
+        even if it is the input file that is being overwritten.
+    */
+    class _MeshMagickExport BufferedFileWriter
+    {
+    public:
+        /// @param initialCapacity number of bytes reserved upfront for the output buffer.
+        BufferedFileWriter(size_t initialCapacity = 4 * 1024 * 1024);
+        ~BufferedFileWriter();
+
+        /// Returns the stream to serialise into.
+        Ogre::DataStreamPtr getStream() const;
+
+        /// Returns the bytes written to the stream so far.
+        const std::vector<unsigned char>& getBuffer() const;
+
+        /** Writes the buffered output to the named file.
+        @return true, if the file has been written, false, if the file already had
+            identical contents and has not been touched.
+        */
+        bool commit(const Ogre::String& fileName);
+
+        /// Returns a 64 bit FNV-1a hash of the given bytes.
+        static Ogre::uint64 getHash(const unsigned char* data, size_t size,
+            Ogre::uint64 hash = FNV_OFFSET_BASIS);
+
+        static const Ogre::uint64 FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    private:
+        std::vector<unsigned char> mBuffer;
+        Ogre::DataStreamPtr mStream;
+
+        bool hasIdenticalContents(const Ogre::String& fileName) const;
+    };
+}
+#endif
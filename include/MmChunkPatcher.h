@@ -0,0 +1,92 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_CHUNK_PATCHER_H__
+#define __MM_CHUNK_PATCHER_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreString.h>
+#else
+#	include <OgreString.h>
+#endif
+
+#include <utility>
+#include <vector>
+
+#include "MmRenameMap.h"
+
+namespace meshmagick
+{
+    /** Renames elements of serialised meshes and skeletons without deserialising them.
+    @par
+        The file is walked chunk by chunk. Only chunks holding names that are renamed are
+        rewritten, all other chunks, geometry, indices and key frames in particular, are
+        copied byte by byte. Chunk lengths of rewritten chunks and their parents are
+        adjusted. Endianness and file version are kept.
+    @par
+        Only file versions, whose chunk lengths can be relied on, are patched.
+        If a file can't be patched, e.g. because a skeleton link would have to be added,
+        the patch methods return false and the file has to be reserialised instead.
+    */
+    class _MeshMagickExport ChunkPatcher
+    {
+    public:
+        ChunkPatcher();
+
+        /// Renames are applied in the order they are added, like the rename tool does.
+        void addMaterialRename(const Ogre::String& before, const Ogre::String& after);
+        void addSubMeshRename(const Ogre::String& before, const Ogre::String& after);
+        void addBoneRename(const Ogre::String& before, const Ogre::String& after);
+        void addAnimationRename(const Ogre::String& before, const Ogre::String& after);
+        /// Sets the name of the skeleton linked by meshes.
+        void setSkeletonName(const Ogre::String& name);
+        /// Sets rules applied after the renames added one by one. map must outlive the patcher.
+        void setRenameMap(const RenameMap* map);
+
+        /// Patches the .mesh file in contents into patched.
+        /// @return false, if the file can't be patched on chunk level.
+        bool patchMesh(const std::vector<unsigned char>& contents,
+            std::vector<unsigned char>& patched) const;
+        /// Patches the .skeleton file in contents into patched.
+        /// @return false, if the file can't be patched on chunk level.
+        bool patchSkeleton(const std::vector<unsigned char>& contents,
+            std::vector<unsigned char>& patched) const;
+
+    private:
+        typedef std::vector<std::pair<Ogre::String, Ogre::String> > RenameList;
+
+        RenameList mMaterialRenames;
+        RenameList mSubMeshRenames;
+        RenameList mBoneRenames;
+        RenameList mAnimationRenames;
+        Ogre::String mSkeletonName;
+        bool mSetSkeletonName;
+        const RenameMap* mRenameMap;
+
+        Ogre::String rename(const Ogre::String& name, const RenameList& renames,
+            RenameMap::RenameKind kind) const;
+    };
+}
+#endif
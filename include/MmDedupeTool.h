@@ -0,0 +1,152 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_DEDUPE_TOOL_H__
+#define __MM_DEDUPE_TOOL_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreMatrix3.h>
+#	include <Ogre/OgreMesh.h>
+#	include <Ogre/OgreSubMesh.h>
+#	include <Ogre/OgreVector.h>
+#else
+#	include <OgreMatrix3.h>
+#	include <OgreMesh.h>
+#	include <OgreSubMesh.h>
+#	include <OgreVector.h>
+#endif
+
+#include "MmTool.h"
+
+#include <vector>
+
+namespace meshmagick
+{
+    /** Finds meshes and submeshes with identical or nearly identical geometry.
+    @par
+        Vertex and index data of every submesh are brought into a canonical form and
+        hashed: Only vertices referenced by the index buffer are considered, in the order
+        of their first use, positions are taken relative to the centroid and all float
+        components are quantised. With -transform-invariant the positions are also
+        rotated into their principal axes and scaled to unit RMS radius, so that copies
+        placed with a different translation, rotation or uniform scale are found too.
+    @par
+        Files are read and hashed on worker threads, only parsing is done serially.
+    */
+    class _MeshMagickExport DedupeTool : public Tool
+    {
+    public:
+        DedupeTool();
+
+        Ogre::String getName() const;
+
+    protected:
+        virtual void doInvoke(const OptionList& toolOptions,
+            const Ogre::StringVector& inFileNames,
+            const Ogre::StringVector& outFileNames);
+
+    private:
+        /// Vertex and index data of a submesh, copied out of the hardware buffers, so
+        /// that it can be processed on worker threads.
+        struct SubMeshGeometry
+        {
+            Ogre::String name;
+            Ogre::String materialName;
+            int operationType;
+            /// Describes the vertex elements in canonical order
+            Ogre::String layout;
+            /// Indices remapped to the order of first vertex use
+            std::vector<Ogre::uint32> indices;
+            /// Positions of the referenced vertices
+            std::vector<Ogre::Vector3> positions;
+            /// Normals, tangents and binormals, numDirections per vertex
+            std::vector<Ogre::Vector3> directions;
+            size_t numDirections;
+            /// All other float components, numFloats per vertex
+            std::vector<float> floats;
+            size_t numFloats;
+            /// All other components, e.g. colours and blend indices, as raw bytes
+            std::vector<unsigned char> bytes;
+            /// Bytes this geometry takes in the file
+            size_t numBytes;
+        };
+
+        /// Normalised frame the geometry is hashed in.
+        struct Frame
+        {
+            Ogre::Vector3 origin;
+            /// Rows are the axes of the frame
+            Ogre::Matrix3 axes;
+            Ogre::Real scale;
+
+            Frame() : origin(Ogre::Vector3::ZERO), axes(Ogre::Matrix3::IDENTITY), scale(1) {}
+        };
+
+        struct MeshGeometry
+        {
+            Ogre::String fileName;
+            std::vector<SubMeshGeometry> submeshes;
+            size_t numBytes;
+
+            MeshGeometry() : fileName(), submeshes(), numBytes(0) {}
+        };
+
+        /// Hash of a mesh or submesh and what is needed to report it.
+        struct GeometryRecord
+        {
+            Ogre::String name;
+            Ogre::String fileName;
+            Ogre::uint64 hash;
+            size_t numBytes;
+            Frame frame;
+        };
+
+        Ogre::Real mTolerance;
+        bool mTransformInvariant;
+
+        Ogre::StringVector getInputFileNames(const Ogre::StringVector& inFileNames) const;
+
+        void extractGeometry(MeshGeometry& geometry, Ogre::MeshPtr mesh) const;
+        void extractGeometry(SubMeshGeometry& geometry, const Ogre::SubMesh* submesh) const;
+
+        Frame getFrame(const std::vector<const SubMeshGeometry*>& geometries) const;
+        Ogre::uint64 getHash(const SubMeshGeometry& geometry, const Frame& frame,
+            Ogre::uint64 hash) const;
+
+        /// Prints groups of records with equal hash, returns the bytes wasted by copies.
+        size_t reportDuplicates(const Ogre::String& title,
+            const std::vector<GeometryRecord>& records) const;
+        /// Writes a line per duplicate mesh file, naming the mesh to use instead and the
+        /// transform to place it with.
+        void writeManifest(const Ogre::String& fileName,
+            const std::vector<GeometryRecord>& records) const;
+
+        /// Returns the groups of records with equal hash and more than one member,
+        /// largest waste first.
+        static std::vector<std::vector<size_t> > getClusters(
+            const std::vector<GeometryRecord>& records);
+    };
+}
+#endif
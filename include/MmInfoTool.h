@@ -32,19 +32,44 @@ THE SOFTWARE.
 #include <OgreMesh.h>
 #include <OgreSubMesh.h>
 
+#include "MmMeshUtils.h"
 #include "MmTool.h"
 #include "MmOptionsParser.h"
 
 namespace meshmagick
 {
+	/// Memory use of a single vertex buffer
+	struct VertexBufferInfo
+	{
+		unsigned short source;
+		size_t numBytes;
+		size_t vertexSize;
+		/// Bytes per vertex not covered by any element
+		size_t padding;
+		/// Layout strings of elements, that are zero or constant for all vertices, or
+		/// redundant like a binormal next to a four component tangent.
+		Ogre::StringVector unusedElements;
+		/// Bytes per vertex taken by the unused elements
+		size_t unusedBytes;
+
+		VertexBufferInfo() : source(0), numBytes(0), vertexSize(0), padding(0),
+			unusedElements(), unusedBytes(0) {}
+	};
+
 	struct VertexInfo
 	{
 		size_t numVertices;
 		size_t numBoneAssignments;
 		size_t numBonesReferenced;
 		Ogre::String layout;
-
-		VertexInfo() : numVertices(0), numBoneAssignments(0), numBonesReferenced(0) {}
+		/// Sum of the vertex sizes of all buffers
+		size_t bytesPerVertex;
+		std::vector<VertexBufferInfo> buffers;
+		/// Number of vertices, whose data in all buffers equals that of an earlier vertex
+		size_t numDuplicateVertices;
+
+		VertexInfo() : numVertices(0), numBoneAssignments(0), numBonesReferenced(0),
+			layout(), bytesPerVertex(0), buffers(), numDuplicateVertices(0) {}
 	};
 
 	struct SubMeshInfo
@@ -57,10 +82,20 @@ namespace meshmagick
 		Ogre::String operationType;
 		size_t numElements;
 		Ogre::String elementType;
+		size_t numIndices;
 		size_t indexBitWidth;
+		/// Size of the index buffer including LOD levels
+		size_t indexBufferBytes;
+		/// Whether a 32 bit index buffer only references vertices a 16 bit index can address
+		bool indexWidthReducible;
+		/// Vertex cache metrics of the full detail index data, followed by those of
+		/// the LOD levels. Empty for non-triangle submeshes.
+		std::vector<VertexCacheMetrics> vertexCache;
 
 		SubMeshInfo() : name(), materialName(), usesSharedVertices(false),
-			vertices(), operationType(), numElements(0), elementType(), indexBitWidth(16) {}
+			vertices(), operationType(), numElements(0), elementType(), numIndices(0),
+			indexBitWidth(16), indexBufferBytes(0), indexWidthReducible(false),
+			vertexCache() {}
 	};
 
 	struct SkeletonInfo
@@ -83,6 +118,7 @@ namespace meshmagick
 		Ogre::AxisAlignedBox actualBoundingBox;
 
 		bool hasEdgeList;
+		/// Number of LOD levels besides the full detail level
 		unsigned short numLodLevels;
 
 		bool hasSharedVertices;
@@ -101,6 +137,12 @@ namespace meshmagick
 		size_t maxNumBoneAssignments;
 		size_t maxNumBonesReferenced;
 
+		size_t vertexBufferBytes;
+		size_t indexBufferBytes;
+		/// Bytes that could be saved by removing padding, unused elements and duplicate
+		/// vertices and by using 16 bit indices where possible
+		size_t potentialSavings;
+
 		bool hasSkeleton;
 		Ogre::String skeletonName;
 		bool skeletonValid;
@@ -113,6 +155,8 @@ namespace meshmagick
 			hasSharedVertices(false), sharedVertices(), submeshes(),
 			morphAnimations(), poseNames(),
 			numVertices(0), numElements(0), numTrianlges(0), numLines(0), numPoints(0),
+			maxNumBoneAssignments(0), maxNumBonesReferenced(0),
+			vertexBufferBytes(0), indexBufferBytes(0), potentialSavings(0),
 			hasSkeleton(false), skeletonName(""), skeletonValid(false), skeleton() {}
 	};
 
@@ -128,10 +172,16 @@ namespace meshmagick
 		SkeletonInfo getInfo(Ogre::SkeletonPtr skeleton);
 
     private:
-        MeshInfo processMesh(const Ogre::String& meshFileName) const;
+        /// Replaces directories in the input by the mesh and skeleton files they contain.
+        Ogre::StringVector getInputFileNames(const Ogre::StringVector& inFileNames) const;
+
+        /// Loads the mesh from stream, if given. Otherwise it is read from the file.
+        MeshInfo processMesh(const Ogre::String& meshFileName,
+            Ogre::DataStreamPtr stream = Ogre::DataStreamPtr()) const;
         void processMesh(MeshInfo& info, Ogre::MeshPtr mesh) const;
 
-        SkeletonInfo processSkeleton(const Ogre::String& skeletonFileName) const;
+        SkeletonInfo processSkeleton(const Ogre::String& skeletonFileName,
+            Ogre::DataStreamPtr stream = Ogre::DataStreamPtr()) const;
         void processSkeleton(SkeletonInfo& info, Ogre::SkeletonPtr skeleton) const;
 		void processSkeleton(SkeletonInfo& info, Ogre::Skeleton* skeleton) const;
 
@@ -139,6 +189,10 @@ namespace meshmagick
 		void processBoneAssignmentData(VertexInfo&, const Ogre::VertexData* vd,
 			const Ogre::Mesh::IndexMap& blendIndexToBoneIndexMap) const;
 		void processVertexDeclaration(VertexInfo&, const Ogre::VertexDeclaration* vd) const;
+		/// Gathers memory use and waste of the vertex buffers.
+		void processVertexBuffers(VertexInfo&, const Ogre::VertexData* vd) const;
+		/// Returns the bytes that could be saved in the vertex buffers.
+		size_t getPotentialSavings(const VertexInfo&) const;
 
 		void printMeshInfo(const OptionList& toolOptions, const MeshInfo& info) const;
 		void printSkeletonInfo(const OptionList& toolOptions, const SkeletonInfo& info) const;
@@ -146,18 +200,48 @@ namespace meshmagick
 		void reportMeshInfo(const MeshInfo& info) const;
 		void reportSkeletonInfo(const SkeletonInfo& info) const;
 
+		/// @param csv if true, all fields are printed and quoted as needed, so that the
+		/// columns match the CSV header.
 		void listMeshInfo(const Ogre::StringVector& listFields, char delim,
-			const MeshInfo& info) const;
+			const MeshInfo& info, bool csv = false) const;
 		void listSkeletonInfo(const Ogre::StringVector& listFields, char delim,
-			const SkeletonInfo& info) const;
+			const SkeletonInfo& info, bool csv = false) const;
 
 		void printMeshInfoList(const Ogre::StringVector& listFields, char delim,
-			const MeshInfo& info, size_t submeshIndex) const;
+			const MeshInfo& info, size_t submeshIndex, size_t lodIndex, bool csv) const;
+
+		/// Returns false, if the field is unknown or not available for this mesh.
+		bool getMeshInfoField(const Ogre::String& field, const MeshInfo& info,
+			size_t submeshIndex, size_t lodIndex, Ogre::String& value) const;
+		bool getSkeletonInfoField(const Ogre::String& field, const SkeletonInfo& info,
+			Ogre::String& value) const;
+
+		/// Writes a line of JSON or CSV output to stdout. Unlike print, it ignores the
+		/// verbosity, the document is the result of the invocation.
+		void printRecord(const Ogre::String& record) const;
+
+		Ogre::StringVector getCsvFields(const OptionList& toolOptions) const;
+		void printCsvHeader(const Ogre::StringVector& fields) const;
+		Ogre::String getCsvString(const Ogre::String& value) const;
+
+		Ogre::String getMeshInfoJson(const MeshInfo& info) const;
+		Ogre::String getSkeletonInfoJson(const SkeletonInfo& info) const;
+		Ogre::String getVertexInfoJson(const VertexInfo& info) const;
+		void reportVertexBuffers(const VertexInfo& info, const Ogre::String& indent) const;
+		Ogre::String getJsonAnimationList(
+			const std::vector<std::pair<Ogre::String, Ogre::Real> >& animations) const;
+		Ogre::String getJsonAabb(const Ogre::AxisAlignedBox& box) const;
+		Ogre::String getJsonNumber(Ogre::Real value) const;
+		Ogre::String getJsonBool(bool value) const;
 
         Ogre::String getEndianModeAsString(Ogre::MeshSerializer::Endian) const;
 
         void doInvoke(const OptionList& toolOptions,
             const Ogre::StringVector& inFileNames, const Ogre::StringVector& outFileNames);
+
+		/// Sizes of the simulated post transform vertex caches
+		size_t mFifoCacheSize;
+		size_t mLruCacheSize;
     };
 }
 #endif
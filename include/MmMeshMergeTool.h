@@ -36,6 +36,8 @@ THE SOFTWARE.
 #	include <OgreSkeleton.h>
 #endif
 
+#include <map>
+
 #include "MmOptionsParser.h"
 #include "MmTool.h"
 
@@ -48,8 +50,18 @@ namespace meshmagick
 		The tool is then reset to be able to merge the next batch of meshes.
 	@par
 		The merge tool creates a new SubMesh for each SubMesh of the Meshes you add.
-		Its functionality is pretty basic still. No submesh merging based on material.
-		Only one Mesh can have shared vertex data.
+		With MeshMergeTool#setMergeSubMeshes SubMeshes with the same material, operation
+		type and vertex declaration are merged into one instead.
+		With MeshMergeTool#setWeld coincident vertices within each resulting vertex data are
+		collapsed afterwards, e.g. along the seams of modular pieces merged into one SubMesh.
+	@par
+		When invoked with a cell size, the tool works as a static batcher, placing the
+		input meshes in the world and writing one merged mesh per grid cell, so that
+		merged meshes are small enough to be culled, yet big enough to save draw calls.
+		Mesh files placed many times can be instanced instead. Their geometry is not
+		copied, but an instance table is written for hardware instancing.
+		Shared vertex data of all Meshes is concatenated into one, if the layouts match.
+		Otherwise SubMeshes get their own copy.
 	 */
 	class _MeshMagickExport MeshMergeTool : public Tool
     {
@@ -73,12 +85,131 @@ namespace meshmagick
 		/// Clears the list of Meshes to be baked.
 		void reset();
 
+		/// Sets whether SubMeshes sharing material and vertex declaration are merged into one.
+		void setMergeSubMeshes(bool merge) { mMergeSubMeshes = merge; }
+		bool getMergeSubMeshes() const { return mMergeSubMeshes; }
+
+		/// Sets whether all vertices are packed into one shared, interleaved vertex buffer.
+		void setSingleBuffer(bool single) { mSingleBuffer = single; }
+		bool getSingleBuffer() const { return mSingleBuffer; }
+
+		/** Sets whether coincident vertices are collapsed after merging.
+		@param posTolerance maximum distance of positions considered equal.
+		@param attributeTolerance maximum difference of normals, tangents and
+			texture coordinates considered equal.
+		*/
+		void setWeld(bool weld, Ogre::Real posTolerance = 1e-4f,
+			Ogre::Real attributeTolerance = 1e-2f)
+		{
+			mWeld = weld;
+			mWeldTolerance = posTolerance;
+			mWeldAttributeTolerance = attributeTolerance;
+		}
+		bool getWeld() const { return mWeld; }
+
 	private: 
+		/// An input mesh file and the transformation it is placed with.
+		struct Placement
+		{
+			Ogre::String fileName;
+			Ogre::Matrix4 transform;
+
+			Placement(const Ogre::String& name, const Ogre::Matrix4& m)
+				: fileName(name), transform(m) {}
+		};
+		typedef std::vector<Placement> PlacementList;
+		/// Maps instanced mesh file names to the indices of their placements.
+		typedef std::map<Ogre::String, std::vector<size_t> > InstanceMap;
+		/// New SubMeshes using shared vertices and the Mesh they were taken from.
+		typedef std::vector<std::pair<Ogre::SubMesh*, const Ogre::Mesh*> > SharedSubMeshList;
+		/// Maps Meshes to the offset of their shared vertices in the merged shared vertex data.
+		typedef std::map<const Ogre::Mesh*, size_t> SharedOffsetMap;
+
+		/// Magic number and version of .instances files, see writeInstances.
+		static const Ogre::uint32 INSTANCES_FILE_ID = 0x4e494d4d;
+		static const Ogre::uint32 INSTANCES_FILE_VERSION = 1;
+
 		Ogre::SkeletonPtr mBaseSkeleton;
 		std::vector<Ogre::MeshPtr> mMeshes;
+		bool mMergeSubMeshes;
+		bool mSingleBuffer;
+		bool mWeld;
+		Ogre::Real mWeldTolerance;
+		Ogre::Real mWeldAttributeTolerance;
+		/// Pose offsets not longer than this are dropped.
+		Ogre::Real mPoseTolerance;
+		/// Pose offsets are rounded to multiples of this, if greater than 0.
+		Ogre::Real mPosePrecision;
+		/// Number of placements of a mesh file, from which on it is instanced. 0 for never.
+		size_t mMinInstances;
 
 		const Ogre::String findSubmeshName(Ogre::MeshPtr m, Ogre::ushort sid) const;
 
+		/// Returns a key, that is equal for SubMeshes, which can be merged into one.
+		/// Empty, if the SubMesh has to be kept on its own.
+		Ogre::String getSubMeshMergeKey(Ogre::MeshPtr m, Ogre::ushort sid) const;
+		/// Returns a key, that is equal for vertex data with the same declaration and buffers.
+		static Ogre::String getVertexLayoutKey(const Ogre::VertexData* vd);
+		/// Returns new vertex data holding the vertices of all vertexDatas, one after another.
+		/// All must have the same layout.
+		Ogre::VertexData* concatenateVertexData(
+			const std::vector<const Ogre::VertexData*>& vertexDatas) const;
+		/// Adds offset to all indices. Switches to 32 bit indices, if use32BitIndices is set.
+		void rebaseIndexData(Ogre::IndexData* indexData, size_t offset, bool use32BitIndices) const;
+		/// Concatenates the shared vertex data of sources into mesh's shared vertex data
+		/// and rebases the indices of subs. The offset of each source merged is stored
+		/// in vertexOffsets.
+		void mergeSharedVertexData(Ogre::MeshPtr mesh, const std::vector<const Ogre::Mesh*>& sources,
+			const SharedSubMeshList& subs, SharedOffsetMap& vertexOffsets) const;
+		/** Adds poses and vertex animation of source to mesh.
+		@param handles the new handle of each of source's submeshes.
+		@param sharedOffsets where source's shared vertices are found in mesh's.
+		*/
+		void mergeVertexAnimation(Ogre::MeshPtr mesh, Ogre::MeshPtr source,
+			const std::vector<unsigned short>& handles, const SharedOffsetMap& sharedOffsets) const;
+		/// Copies the offsets of pose into newPose, dropping and quantising them as set up.
+		void copyPose(Ogre::Pose* newPose, const Ogre::Pose* pose, size_t vertexOffset) const;
+		/// Rounds the components of v to multiples of step, if step is greater than 0.
+		static Ogre::Vector3 quantise(const Ogre::Vector3& v, Ogre::Real step);
+		/// Moves all vertex data of mesh into its shared vertex data, in a single buffer.
+		/// SubMeshes with vertex animation, poses or a different layout are left alone.
+		void packSingleBuffer(Ogre::MeshPtr mesh) const;
+		/// Copies index data, vertex data and bone assignments of sub to newsub.
+		void copySubMeshGeometry(Ogre::SubMesh* newsub, Ogre::SubMesh* sub) const;
+		/// Concatenates index data, vertex data and bone assignments of subs into newsub.
+		void mergeSubMeshGeometry(Ogre::SubMesh* newsub,
+			const std::vector<Ogre::SubMesh*>& subs) const;
+		/// Collapses coincident vertices in every vertex data of mesh.
+		void weldVertices(Ogre::MeshPtr mesh) const;
+
+		/** Loads the named mesh files and their skeletons into meshes, in the same order.
+			Files are read concurrently. Meshes that fail to load are left null.
+		*/
+		void loadMeshes(const Ogre::StringVector& fileNames, std::vector<Ogre::MeshPtr>& meshes);
+		/** Reads a placement manifest. Each line holds a mesh file name, a tab and the
+			translation x y z, orientation w x y z and optionally a uniform scale
+			or a scale x y z, delimited by whitespace. Lines starting with # are ignored.
+		*/
+		void readPlacements(const Ogre::String& fileName, PlacementList& placements) const;
+		/// Gives the morph key frames of mesh their own copy of their vertex buffers.
+		/// Mesh::clone leaves them shared with the original.
+		static void copyMorphBuffers(Ogre::Mesh* mesh);
+		/** Places a copy of each mesh with its transformation and merges them.
+		@param cellSize if not zero, placed meshes are bucketed by the grid cell their
+			bounds' centre lies in and one mesh is written per cell. The cell's
+			coordinates are appended to the output file name.
+		*/
+		void mergePlacements(const PlacementList& placements, const Ogre::Vector3& cellSize,
+			const Ogre::String& outFileName);
+		/** Writes the instance table of instanced meshes in native byte order:
+			uint32 id 'MMIN', uint32 version, uint32 number of meshes. Per mesh the
+			uint32 length of the mesh file name, the name, the uint32 number of instances
+			and per instance the upper 3x4 rows of its transformation as floats and the
+			uint32 index of its placement.
+		*/
+		void writeInstances(const Ogre::String& fileName, const PlacementList& placements,
+			const InstanceMap& instances) const;
+
 		void doInvoke(const OptionList& toolOptions,
 			const Ogre::StringVector& inFileNames,
 			const Ogre::StringVector& outFileNames);
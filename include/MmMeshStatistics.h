@@ -0,0 +1,131 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_MESH_STATISTICS_H__
+#define __MM_MESH_STATISTICS_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "MmInfoTool.h"
+
+namespace meshmagick
+{
+    /** Histogram with logarithmic buckets, that also keeps count, sum, min and max.
+    @par
+        Bucket 0 holds values below 1, bucket i > 0 holds values in [2^(i-1), 2^i).
+        Memory use is constant, percentiles are estimated by interpolating inside the
+        bucket the requested rank falls into.
+    */
+    class _MeshMagickExport LogHistogram
+    {
+    public:
+        static const size_t NUM_BUCKETS = 64;
+
+        LogHistogram();
+
+        void add(double value);
+
+        size_t getCount() const;
+        double getMin() const;
+        double getMax() const;
+        double getMean() const;
+        /// @param p percentile in [0, 100]
+        double getPercentile(double p) const;
+
+        size_t getBucketCount(size_t bucket) const;
+        /// Inclusive lower bound of the bucket.
+        static double getBucketMin(size_t bucket);
+        /// Exclusive upper bound of the bucket.
+        static double getBucketMax(size_t bucket);
+
+    private:
+        size_t mBuckets[NUM_BUCKETS];
+        size_t mCount;
+        double mSum;
+        double mMin;
+        double mMax;
+
+        static size_t getBucket(double value);
+    };
+
+    /** Accumulates statistics over many meshes and skeletons for the info tool.
+    @par
+        Nothing is stored per input, except for the configured number of heaviest meshes,
+        so memory use does not depend on the number of inputs.
+    */
+    class _MeshMagickExport MeshStatistics
+    {
+    public:
+        /// @param numTopMeshes number of heaviest meshes to keep track of.
+        explicit MeshStatistics(size_t numTopMeshes = 10);
+
+        void addMesh(const MeshInfo& info);
+        /// Skeletons linked by meshes are not added, since one rig is usually shared by
+        /// many meshes. Add skeleton inputs explicitly.
+        void addSkeleton(const SkeletonInfo& info);
+
+        /// Returns the report as a list of lines.
+        Ogre::StringVector getReport() const;
+
+        /// Returns the size in bytes of the vertex and index buffers of the mesh, LODs included.
+        static size_t getMeshMemory(const MeshInfo& info);
+
+    private:
+        typedef std::pair<size_t, Ogre::String> MemoryEntry;
+        /// first: bytes per vertex, second: number of vertex buffers with this layout
+        typedef std::map<Ogre::String, std::pair<size_t, size_t> > LayoutMap;
+        typedef std::map<size_t, size_t> CountMap;
+
+        size_t mNumTopMeshes;
+        size_t mNumMeshes;
+        size_t mNumSkeletons;
+
+        LogHistogram mVertexCounts;
+        LogHistogram mTriangleCounts;
+        LogHistogram mMeshMemory;
+        LogHistogram mBytesPerVertex;
+        LogHistogram mLodLevels;
+        LogHistogram mBonesReferenced;
+        LogHistogram mInfluences;
+        LogHistogram mBoneCounts;
+        LogHistogram mAnimationLengths;
+
+        CountMap mIndexWidths;
+        LayoutMap mLayouts;
+
+        /// Min-heap on memory, holding the heaviest meshes seen so far.
+        std::vector<MemoryEntry> mTopMeshes;
+
+        void addVertexInfo(const VertexInfo& info);
+
+        void appendHistogramSummary(Ogre::StringVector& lines, const Ogre::String& name,
+            const LogHistogram& histogram) const;
+        void appendHistogram(Ogre::StringVector& lines, const Ogre::String& name,
+            const LogHistogram& histogram) const;
+    };
+}
+#endif
@@ -28,8 +28,51 @@ THE SOFTWARE.
 
 #include <OgreMesh.h>
 
+#include <vector>
+
 namespace meshmagick
 {
+    /// Rendering efficiency of an index buffer, see MeshUtils::getVertexCacheMetrics.
+    struct VertexCacheMetrics
+    {
+        /// Average cache miss ratio: vertex shader invocations per triangle.
+        /// 0.5 is the optimum for a regular grid, 3 means no reuse at all.
+        Ogre::Real fifoAcmr;
+        /// Average transformed vertex ratio: vertex shader invocations per referenced
+        /// vertex. 1 is optimal.
+        Ogre::Real fifoAtvr;
+        Ogre::Real lruAcmr;
+        Ogre::Real lruAtvr;
+        /// Bytes fetched from the vertex buffers in cache lines, relative to the size of
+        /// the referenced vertices. 1 is optimal.
+        Ogre::Real overfetch;
+        /// Fraction of the vertices, that are not referenced by the index buffer. For
+        /// vertex data shared by several index buffers see MeshUtils::getUnreferencedVertices.
+        Ogre::Real unreferencedVertices;
+
+        VertexCacheMetrics() : fifoAcmr(0), fifoAtvr(0), lruAcmr(0), lruAtvr(0),
+            overfetch(0), unreferencedVertices(0) {}
+    };
+
+    /// Vertex buffer layout, see MeshUtils::parseVertexLayout.
+    struct VertexLayout
+    {
+        struct Element
+        {
+            Ogre::VertexElementSemantic semantic;
+            unsigned short index;
+            Ogre::VertexElementType type;
+            /// False, if the layout leaves the type open and the current one is kept.
+            bool hasType;
+        };
+        typedef std::vector<Element> ElementList;
+
+        /// Elements of each buffer, the buffer index is used as source.
+        std::vector<ElementList> buffers;
+        /// Vertex size of each buffer is rounded up to a multiple of this, 1 for none.
+        std::vector<size_t> alignments;
+    };
+
     /// Utility class containing mesh related functions that may be useful for
     /// multiple tools.
     class _MeshMagickExport MeshUtils
@@ -42,6 +85,67 @@ namespace meshmagick
 
         static Ogre::AxisAlignedBox getVertexDataAabb(Ogre::VertexData* vd,
             const Ogre::Matrix4& transform = Ogre::Matrix4::IDENTITY);
+
+        /// Returns the indices in [indexStart, indexStart + indexCount) widened to 32 bit.
+        static std::vector<Ogre::uint32> getIndices(const Ogre::IndexData* indexData);
+
+        /** Simulates a post transform vertex cache and the vertex fetch for the index data.
+        @par
+            Runs in linear time. The FIFO cache models most current hardware, LRU the
+            cache most optimisers assume. Vertex fetch is simulated with 64 byte cache
+            lines and a 16KB cache per vertex buffer, fetched on FIFO cache misses.
+            Only triangle operations are analysed, for others all metrics are 0.
+        @param fifoSize number of entries of the simulated FIFO cache.
+        @param lruSize number of entries of the simulated LRU cache.
+        */
+        static VertexCacheMetrics getVertexCacheMetrics(const Ogre::VertexData* vertexData,
+            const Ogre::IndexData* indexData, Ogre::RenderOperation::OperationType operationType,
+            size_t fifoSize = 16, size_t lruSize = 16);
+
+        /// Returns the fraction of the vertices not referenced by any of the index datas.
+        static Ogre::Real getUnreferencedVertices(const Ogre::VertexData* vertexData,
+            const std::vector<const Ogre::IndexData*>& indexDatas);
+
+        /** Removes vertex elements and rebuilds the vertex buffers without them.
+        @par
+            The remaining elements keep their source and order, offsets are recomputed
+            without gaps. Sources left without elements are dropped.
+        @param remove flags for the elements of the declaration, in the order of
+            VertexDeclaration::getElements.
+        */
+        static void removeVertexElements(Ogre::VertexData* vertexData,
+            const std::vector<bool>& remove);
+
+        /// Returns the part of the layout string describing a single vertex element,
+        /// e.g. "p(f3)" for a float3 position.
+        static Ogre::String getElementLayoutString(Ogre::VertexElementSemantic semantic,
+            Ogre::VertexElementType type);
+
+        /// Returns the name of a vertex element in the layout notation, its semantic letter
+        /// followed by its index, e.g. "u1".
+        static Ogre::String getElementName(Ogre::VertexElementSemantic semantic,
+            unsigned short index);
+
+        /// Parses an element name like "b" or "u1", the index defaults to 0.
+        /// @return false, if the name is malformed.
+        static bool parseElementName(const Ogre::String& name,
+            Ogre::VertexElementSemantic& semantic, unsigned short& index);
+
+        /** Returns the layout string of a vertex declaration, e.g. "p(f3)n(f3)-u(f2)".
+        @par
+            Elements are listed in order of source and offset, buffers are separated by
+            hyphens. The index of an element follows its semantic letter, if it differs
+            from the number of elements with the same semantic listed before.
+        */
+        static Ogre::String getVertexLayoutString(const Ogre::VertexDeclaration* decl);
+
+        /** Parses a layout string in the notation of getVertexLayoutString.
+        @par
+            Types may be left out, e.g. "p-nu", to keep them. A buffer may end with
+            ":n" to pad its vertex size to a multiple of n bytes, e.g. "p(f3)n(f3):16".
+        @return false, if the string is malformed or lists an element twice.
+        */
+        static bool parseVertexLayout(const Ogre::String& layoutString, VertexLayout& layout);
     };
 }
 #endif
@@ -63,6 +63,16 @@ namespace meshmagick
         StatefulMeshSerializer* getMeshSerializer() const;
         StatefulSkeletonSerializer* getSkeletonSerializer() const;
 		Ogre::Log* getLog() const;
+
+        /** Removes all meshes, skeletons and placeholder materials created while loading
+            files from their resource managers.
+        @par
+            Resources loaded for an input file live until the tool is done with that file,
+            so that memory use does not grow over long batch runs. Tools processing one
+            file after another get this through Tool::forEachFile. Tools needing all files
+            at once, like meshmerge, call it when done with the batch.
+        */
+        void releaseFileResources();
 		bool isStandalone() const;
 
     private:
@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "MmOptionsParser.h"
 #include "MmTool.h"
 
+#include <set>
+
 namespace meshmagick
 {
 	struct UniqueVertex
@@ -53,6 +55,24 @@ namespace meshmagick
 			memset(uv, 0, sizeof(Ogre::Vector3) * OGRE_MAX_TEXTURE_COORD_SETS);
 		}
 
+		/// Reads the float elements of a vertex. bufferLocks holds a pointer to the
+		/// vertex in each bound buffer, indexed by source.
+		/// @return the number of texture coordinate sets read.
+		unsigned short read(const Ogre::VertexDeclaration* decl,
+			const std::vector<char*>& bufferLocks);
+	};
+
+	/// Orders UniqueVertex instances, treating components within the tolerances as equal.
+	struct UniqueVertexLess
+	{
+		float pos_tolerance, norm_tolerance, uv_tolerance;
+		unsigned short uvSets;
+		bool operator()(const UniqueVertex& a, const UniqueVertex& b) const;
+
+		bool equals(const Ogre::Vector3& a, const Ogre::Vector3& b, Ogre::Real tolerance) const;
+		bool equals(const Ogre::Vector4& a, const Ogre::Vector4& b, Ogre::Real tolerance) const;
+		bool less(const Ogre::Vector3& a, const Ogre::Vector3& b, Ogre::Real tolerance) const;
+		bool less(const Ogre::Vector4& a, const Ogre::Vector4& b, Ogre::Real tolerance) const;
 	};
 
 	class OptimiseTool : public Tool
@@ -80,6 +100,13 @@ namespace meshmagick
 	protected:
 		float mPosTolerance, mNormTolerance, mUVTolerance;
 		bool mKeepIdentityTracks;
+		/// Remove unreferenced vertices and dead vertex elements.
+		bool mStrip;
+		/// Also remove texture coordinate sets, that are the same for all vertices.
+		bool mStripConstantUVs;
+		/// Vertex elements to remove in any case, as semantic and index.
+		typedef std::vector<std::pair<Ogre::VertexElementSemantic, unsigned short> > ElementList;
+		ElementList mStripElements;
 
 
 		struct IndexInfo
@@ -94,19 +121,6 @@ namespace meshmagick
 		typedef std::vector<IndexInfo> IndexRemap;
 		IndexRemap mIndexRemap;
 
-		struct UniqueVertexLess
-		{
-			float pos_tolerance, norm_tolerance, uv_tolerance;
-			unsigned short uvSets;
-			bool operator()(const UniqueVertex& a, const UniqueVertex& b) const;
-
-			bool equals(const Ogre::Vector3& a, const Ogre::Vector3& b, Ogre::Real tolerance) const;
-			bool equals(const Ogre::Vector4& a, const Ogre::Vector4& b, Ogre::Real tolerance) const;
-			bool less(const Ogre::Vector3& a, const Ogre::Vector3& b, Ogre::Real tolerance) const;
-			bool less(const Ogre::Vector4& a, const Ogre::Vector4& b, Ogre::Real tolerance) const;
-		};
-
-
 		struct VertexInfo
 		{
 			Ogre::uint32 oldIndex;
@@ -137,10 +151,29 @@ namespace meshmagick
 		};
 		typedef std::list<IndexDataWithOpType> IndexDataList;
 		IndexDataList mIndexDataList;
+		/// Index buffers remapped since the remap was built.
+		std::set<Ogre::HardwareIndexBuffer*> mRemappedIndexBuffers;
 
 		void setTargetVertexData(Ogre::VertexData* vd);
 		void addIndexData(Ogre::IndexData* id, Ogre::RenderOperation::OperationType operationType);
 		bool optimiseGeometry();
+		/** Removes the vertices of the target vertex data, that neither the index data
+			added nor lodFaces reference. Index data added is remapped, LOD levels and bone
+			assignments have to be fixed afterwards.
+		@return true, if vertices have been removed.
+		*/
+		bool stripUnreferencedVertices(const Ogre::SubMesh::LODFaceList& lodFaces);
+		/** Removes the elements chosen with -strip-element and those detected as dead:
+			binormals, if the tangent carries the handedness, and blend elements of meshes
+			without skeleton. With -strip-constant-uvs also texture coordinate sets that
+			are the same for all vertices.
+		*/
+		void stripVertexElements(Ogre::VertexData* vd, bool skinned);
+		/// Whether poses or morph animations refer to vertices of the given target,
+		/// 0 for shared geometry, submesh index + 1 otherwise.
+		bool hasVertexAnimation(const Ogre::Mesh* mesh, unsigned short target) const;
+		void fixSharedVertexReferences(Ogre::Mesh* mesh);
+		void fixDedicatedVertexReferences(Ogre::Mesh* mesh, Ogre::SubMesh* sm);
 		bool calculateDuplicateVertices();
 		void rebuildVertexBuffers();
 		void remapIndexDataList();
@@ -0,0 +1,91 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_RENAME_MAP_H__
+#define __MM_RENAME_MAP_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreString.h>
+#else
+#	include <OgreString.h>
+#endif
+
+#include <regex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace meshmagick
+{
+    /** A set of renaming rules for the elements of meshes and skeletons.
+    @par
+        Plain rules are kept in hash maps, so that thousands of them cost a single lookup
+        per name. Regular expression rules are only tried, if no plain rule matched, in the
+        order they were added. The first one matching the whole name wins.
+    @par
+        A RenameMap is not modified while it is applied, so it may be used from several
+        threads at once.
+    */
+    class _MeshMagickExport RenameMap
+    {
+    public:
+        typedef enum {RK_MATERIAL, RK_SUBMESH, RK_BONE, RK_ANIMATION, RK_COUNT} RenameKind;
+
+        RenameMap();
+
+        /** Adds the rules of a mapping file. Each line holds a kind, which is one of
+            material, submesh, bone and animation, optionally followed by -regex, then the
+            old name, " -> " and the new name, e.g.
+            <pre>
+            material Rock/Old -> Rock/New
+            material-regex Stone_(.*) -> Rock_$1
+            </pre>
+            Empty lines and lines starting with # are ignored.
+        @throw std::ios_base::failure, if the file can't be read.
+        @throw std::logic_error, if a line can't be parsed.
+        */
+        void load(const Ogre::String& fileName);
+
+        void add(RenameKind kind, const Ogre::String& before, const Ogre::String& after);
+        /// @param replacement may refer to groups of pattern by $n.
+        void addRegex(RenameKind kind, const Ogre::String& pattern,
+            const Ogre::String& replacement);
+
+        /// Renames name according to the rules of given kind.
+        /// @return true, if the name has been changed.
+        bool apply(RenameKind kind, Ogre::String& name) const;
+
+        /// Returns the number of rules.
+        size_t size() const;
+
+    private:
+        typedef std::unordered_map<Ogre::String, Ogre::String> NameMap;
+        typedef std::vector<std::pair<std::regex, Ogre::String> > RegexList;
+
+        NameMap mNames[RK_COUNT];
+        RegexList mRegexes[RK_COUNT];
+    };
+}
+#endif
@@ -26,6 +26,8 @@ THE SOFTWARE.
 
 #include "MeshMagickPrerequisites.h"
 
+#include "MmChunkPatcher.h"
+#include "MmRenameMap.h"
 #include "MmTool.h"
 
 namespace meshmagick
@@ -47,10 +49,26 @@ namespace meshmagick
 	private:
 		typedef std::pair<Ogre::String, Ogre::String> StringPair;
 
+		/// Outcome of patching a single file.
+		typedef enum {PR_WRITTEN, PR_UNCHANGED, PR_RESERIALISE, PR_FAILED} PatchResult;
+
+		/// Whether files are always loaded and reserialised instead of patched.
+		bool mFullReserialise;
+		/// Rules read from the file given with -map.
+		RenameMap mRenameMap;
+
 		void processMeshFile(
 			const OptionList &toolOptions, Ogre::String inFile, Ogre::String outFile);
 		void processSkeletonFile(
 			const OptionList &toolOptions, Ogre::String inFile, Ogre::String outFile);
+		/// Adds the renames given as options, that apply to meshes or skeletons, to patcher.
+		/// Messages about options not applying are added to warnings.
+		void setupPatcher(ChunkPatcher& patcher, const OptionList &toolOptions, bool isMesh,
+			Ogre::StringVector& warnings) const;
+		/// Renames on chunk level and writes the result. Safe to call from worker threads.
+		/// @param error receives the message, if PR_FAILED is returned.
+		PatchResult patchFile(const ChunkPatcher& patcher, const Ogre::String& inFile,
+			const Ogre::String& outFile, bool isMesh, Ogre::String& error) const;
 		StringPair split(const Ogre::String& value) const;
 	};
 
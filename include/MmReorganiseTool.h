@@ -0,0 +1,97 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_REORGANISE_TOOL_H__
+#define __MM_REORGANISE_TOOL_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreMesh.h>
+#	include <Ogre/OgreString.h>
+#	include <Ogre/OgreStringVector.h>
+#else
+#	include <OgreMesh.h>
+#	include <OgreString.h>
+#	include <OgreStringVector.h>
+#endif
+
+#include "MmMeshUtils.h"
+#include "MmTool.h"
+
+namespace meshmagick
+{
+    /** Rewrites vertex buffers to a given layout.
+    @par
+        The layout is given in the notation the info tool prints, see
+        MeshUtils::parseVertexLayout. It determines which buffer each element goes to,
+        the order of the elements, their types and the vertex size alignment of each
+        buffer. Elements not named in the layout are dropped. Float types convert into
+        each other, missing components are 0, a missing fourth component is 1. Colour
+        types convert into each other.
+    @par
+        Morph animation needs float3 positions in a buffer of their own, optionally
+        followed by float3 normals. If the layout puts normals there, key frames
+        without normals get the normals of the mesh, so that all buffers match.
+    */
+    class _MeshMagickExport ReorganiseTool : public Tool
+    {
+    public:
+        ReorganiseTool();
+
+        Ogre::String getName() const;
+
+        void setLayout(const VertexLayout& layout) { mLayout = layout; }
+        const VertexLayout& getLayout() const { return mLayout; }
+
+        /// Rewrites all vertex data of mesh to the layout.
+        /// @return false, if some vertex data doesn't fit the layout and was left as it is.
+        bool processMesh(Ogre::Mesh* mesh);
+
+    protected:
+        virtual void doInvoke(const OptionList& toolOptions,
+            const Ogre::StringVector& inFileNames,
+            const Ogre::StringVector& outFileNames);
+
+    private:
+        VertexLayout mLayout;
+
+        void processMeshFile(const Ogre::String& inFile, const Ogre::String& outFile);
+
+        /** Rewrites vd to the layout.
+        @param target 0 for shared vertex data, submesh index + 1 otherwise, as used by
+            vertex animation tracks.
+        @return false, if vd doesn't fit the layout.
+        */
+        bool reorganiseVertexData(Ogre::Mesh* mesh, Ogre::VertexData* vd,
+            unsigned short target, const Ogre::String& name);
+
+        /// Adds the normals of vd to the morph key frames of target lacking them.
+        void addMorphNormals(Ogre::Mesh* mesh, Ogre::VertexData* vd, unsigned short target);
+
+        static bool canConvert(Ogre::VertexElementType from, Ogre::VertexElementType to);
+        static void convertElement(const unsigned char* src, Ogre::VertexElementType srcType,
+            unsigned char* dest, Ogre::VertexElementType destType);
+    };
+}
+#endif
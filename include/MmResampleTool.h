@@ -0,0 +1,132 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_RESAMPLE_TOOL_H__
+#define __MM_RESAMPLE_TOOL_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreAnimation.h>
+#	include <Ogre/OgreQuaternion.h>
+#	include <Ogre/OgreSkeleton.h>
+#	include <Ogre/OgreVector.h>
+#else
+#	include <OgreAnimation.h>
+#	include <OgreQuaternion.h>
+#	include <OgreSkeleton.h>
+#	include <OgreVector.h>
+#endif
+
+#include "MmTool.h"
+
+#include <vector>
+
+namespace meshmagick
+{
+    /** Resamples the node tracks of skeleton animations to a fixed frame rate.
+    @par
+        Every track is sampled at multiples of 1 / frame rate, using the interpolation
+        set up for its animation, and its key frames are replaced by the samples. With
+        uniformly spaced keys the key frame for a given time can be found by index
+        instead of by searching.
+    @par
+        Tracks without motion are reduced to a single key frame. Tracks of a bone, that
+        stays in its binding pose in all animations, are removed, just like
+        Skeleton::optimiseAllAnimations does. Not so for skeletons blending by averaging,
+        where such a track still pulls the bone towards its binding pose.
+    @par
+        Optionally, keys that linear interpolation of their neighbours reproduces within
+        the tolerances are removed afterwards. This gives up uniform spacing for fewer
+        keys, so it is a trade off between memory and lookup cost.
+    */
+    class _MeshMagickExport ResampleTool : public Tool
+    {
+    public:
+        ResampleTool();
+
+        Ogre::String getName() const;
+
+        void processSkeletonFile(const Ogre::String& inFile, const Ogre::String& outFile);
+        void processSkeleton(Ogre::Skeleton* skeleton);
+
+        Ogre::Real getFrameRate() const { return mFrameRate; }
+        void setFrameRate(Ogre::Real fps) { mFrameRate = fps; }
+
+        bool getReduce() const { return mReduce; }
+        void setReduce(bool reduce) { mReduce = reduce; }
+
+        /// Whether tracks of bones staying in binding pose are kept.
+        bool getKeepIdentityTracks() const { return mKeepIdentityTracks; }
+        void setKeepIdentityTracks(bool keep) { mKeepIdentityTracks = keep; }
+
+        /// Maximum deviation of translation and scale, for motion detection and reduction.
+        Ogre::Real getTolerance() const { return mTolerance; }
+        void setTolerance(Ogre::Real tolerance) { mTolerance = tolerance; }
+
+        /// Maximum deviation of rotations, for motion detection and reduction.
+        Ogre::Radian getAngleTolerance() const { return mAngleTolerance; }
+        void setAngleTolerance(const Ogre::Radian& tolerance) { mAngleTolerance = tolerance; }
+
+    protected:
+        virtual void doInvoke(const OptionList& toolOptions,
+            const Ogre::StringVector& inFileNames,
+            const Ogre::StringVector& outFileNames);
+
+    private:
+        struct KeySample
+        {
+            Ogre::Real time;
+            Ogre::Vector3 translate;
+            Ogre::Quaternion rotation;
+            Ogre::Vector3 scale;
+        };
+        typedef std::vector<KeySample> KeySampleList;
+
+        /// Resampled keys of one node track.
+        struct TrackSamples
+        {
+            Ogre::Animation* animation;
+            unsigned short handle;
+            Ogre::NodeAnimationTrack* track;
+            KeySampleList samples;
+            bool hasMotion;
+            bool isIdentity;
+        };
+
+        Ogre::Real mFrameRate;
+        bool mReduce;
+        bool mKeepIdentityTracks;
+        Ogre::Real mTolerance;
+        Ogre::Radian mAngleTolerance;
+
+        void sampleTrack(TrackSamples& track) const;
+        /// Removes samples, that interpolating their neighbours reproduces.
+        void reduceSamples(KeySampleList& samples, Ogre::Animation::RotationInterpolationMode mode,
+            bool shortestPath) const;
+        KeySample interpolate(const KeySample& a, const KeySample& b, Ogre::Real time,
+            Ogre::Animation::RotationInterpolationMode mode, bool shortestPath) const;
+        bool equals(const KeySample& a, const KeySample& b) const;
+    };
+}
+#endif
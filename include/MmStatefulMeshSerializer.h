@@ -30,10 +30,12 @@ THE SOFTWARE.
 #	include <Ogre/OgreMesh.h>
 #	include <Ogre/OgreMeshSerializer.h>
 #	include <Ogre/OgreString.h>
+#	include <Ogre/OgreStringVector.h>
 #else
 #	include <OgreMesh.h>
 #	include <OgreMeshSerializer.h>
 #	include <OgreString.h>
+#	include <OgreStringVector.h>
 #endif
 
 namespace meshmagick
@@ -42,8 +44,19 @@ namespace meshmagick
     {
     public:
         Ogre::MeshPtr loadMesh(const Ogre::String& name);
-        void saveMesh(const Ogre::String& name, bool keepEndianess);
+        /// Loads the mesh from given stream, e.g. a file read into memory beforehand.
+        /// name is used as resource name.
+        Ogre::MeshPtr loadMesh(const Ogre::String& name, Ogre::DataStreamPtr stream);
+        /// Saves the mesh loaded last.
+        /// Returns false, if the file already had identical contents and was left untouched.
+        bool saveMesh(const Ogre::String& name, bool keepEndianess);
+        /// Saves the given mesh the same way as the mesh loaded last.
+        bool saveMesh(const Ogre::Mesh* mesh, const Ogre::String& name,
+            Endian endianMode = ENDIAN_NATIVE);
         void clear();
+        /// Clears the state and removes all mesh resources created by loadMesh from the
+        /// MeshManager. Mesh pointers still held by the caller stay valid.
+        void releaseResources();
         Ogre::MeshPtr getMesh() const;
         Ogre::String getMeshFileVersion() const;
         Ogre::Serializer::Endian getEndianMode() const;
@@ -51,6 +64,8 @@ namespace meshmagick
         Ogre::MeshPtr mMesh;
         Ogre::String mMeshFileVersion;
         Endian mMeshFileEndian;
+        /// Names of the mesh resources created by loadMesh since last release.
+        Ogre::StringVector mCreatedResources;
 
         void determineFileFormat(Ogre::DataStreamPtr stream);
     };
@@ -30,10 +30,12 @@ THE SOFTWARE.
 #	include <Ogre/OgreSkeleton.h>
 #	include <Ogre/OgreSkeletonSerializer.h>
 #	include <Ogre/OgreString.h>
+#	include <Ogre/OgreStringVector.h>
 #else
 #	include <OgreSkeleton.h>
 #	include <OgreSkeletonSerializer.h>
 #	include <OgreString.h>
+#	include <OgreStringVector.h>
 #endif
 
 #include "MmOptionsParser.h"
@@ -44,13 +46,26 @@ namespace meshmagick
     {
     public:
         Ogre::SkeletonPtr loadSkeleton(const Ogre::String& name);
-        void saveSkeleton(const Ogre::String& name, bool keepEndianess);
+        /// Loads the skeleton from given stream, name is used as resource name.
+        Ogre::SkeletonPtr loadSkeleton(const Ogre::String& name, Ogre::DataStreamPtr stream);
+        /// Saves the skeleton loaded last.
+        /// Returns false, if the file already had identical contents and was left untouched.
+        bool saveSkeleton(const Ogre::String& name, bool keepEndianess);
+        /// Saves the given skeleton, e.g. one built from the skeleton loaded last.
+        bool saveSkeleton(const Ogre::Skeleton* skeleton, const Ogre::String& name,
+            Endian endianMode = ENDIAN_NATIVE);
         void clear();
+        /// Clears the state and removes all skeleton resources created by loadSkeleton
+        /// from the SkeletonManager.
+        void releaseResources();
         Ogre::SkeletonPtr getSkeleton() const;
+        Ogre::Serializer::Endian getEndianMode() const;
     private:
         Ogre::SkeletonPtr mSkeleton;
         Ogre::String mSkeletonFileVersion;
         Endian mSkeletonFileEndian;
+        /// Names of the skeleton resources created by loadSkeleton since last release.
+        Ogre::StringVector mCreatedResources;
 
         void determineFileFormat(Ogre::DataStreamPtr stream);
     };
@@ -0,0 +1,98 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_STRIP_BONES_TOOL_H__
+#define __MM_STRIP_BONES_TOOL_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreMesh.h>
+#	include <Ogre/OgreSkeleton.h>
+#	include <Ogre/OgreStringVector.h>
+#else
+#	include <OgreMesh.h>
+#	include <OgreSkeleton.h>
+#	include <OgreStringVector.h>
+#endif
+
+#include "MmTool.h"
+
+#include <vector>
+
+namespace meshmagick
+{
+    /** Removes bones from a skeleton, that none of the meshes using it needs.
+    @par
+        A bone is kept, if a bone assignment of one of the meshes references it, if it
+        is named with -keep, e.g. because objects get attached to it, or if it is an
+        ancestor of a kept bone. All other bones are removed. The kept bones are
+        numbered anew, in their original order, and bone assignments and animation
+        tracks are remapped accordingly.
+    @par
+        Since handles change, all meshes using the skeleton have to be processed along
+        with it.
+    */
+    class _MeshMagickExport StripBonesTool : public Tool
+    {
+    public:
+        StripBonesTool();
+
+        Ogre::String getName() const;
+
+        /// Names of bones to keep, even if no vertex is assigned to them.
+        void setKeepBones(const Ogre::StringVector& boneNames) { mKeepBones = boneNames; }
+        const Ogre::StringVector& getKeepBones() const { return mKeepBones; }
+
+        /** Strips the bones of skeleton, that are not needed by the meshes.
+        @par
+            Bone assignments of the meshes are remapped to the handles of the stripped
+            skeleton. The given skeleton is left unchanged.
+        @return the stripped skeleton, or a null pointer if all bones are needed.
+        */
+        Ogre::SkeletonPtr stripBones(const Ogre::Skeleton* skeleton,
+            const std::vector<Ogre::Mesh*>& meshes);
+
+    protected:
+        virtual void doInvoke(const OptionList& toolOptions,
+            const Ogre::StringVector& inFileNames,
+            const Ogre::StringVector& outFileNames);
+
+    private:
+        /// Maps old bone handles to new ones, NO_BONE for removed bones.
+        typedef std::vector<unsigned short> BoneHandleMap;
+        static const unsigned short NO_BONE = 0xffff;
+
+        Ogre::StringVector mKeepBones;
+
+        /// Marks the bones referenced by the assignments in keep.
+        void markReferencedBones(const Ogre::Mesh::VertexBoneAssignmentList& assignments,
+            const Ogre::String& meshName, std::vector<bool>& keep) const;
+
+        Ogre::SkeletonPtr createStrippedSkeleton(const Ogre::Skeleton* skeleton,
+            const BoneHandleMap& handleMap) const;
+
+        static void remapBoneAssignments(Ogre::Mesh* mesh, const BoneHandleMap& handleMap);
+    };
+}
+#endif
@@ -0,0 +1,82 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_THREAD_POOL_H__
+#define __MM_THREAD_POOL_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#include <functional>
+
+namespace meshmagick
+{
+    /** Runs a number of independent jobs on a set of worker threads.
+    @par
+        Jobs are identified by their index. Workers fetch the next free index until all
+        jobs are done, so the order in which jobs are executed is undefined. Results
+        should be stored per index and consumed after ThreadPool#run returned, which
+        keeps output deterministic.
+    @par
+        Ogre's resource managers are not thread safe. Jobs must not create, load or
+        remove resources, they are meant for file I/O and number crunching on data
+        that is not shared between jobs.
+    */
+    class _MeshMagickExport ThreadPool
+    {
+    public:
+        typedef std::function<void (size_t)> Job;
+        typedef std::function<void (size_t, size_t)> WindowJob;
+
+        /// @param numThreads number of workers, 0 to use one per hardware thread.
+        explicit ThreadPool(size_t numThreads = 0);
+
+        size_t getNumThreads() const;
+
+        /** Calls job(i) for all i in [0, numJobs) and returns, when all calls are done.
+        @par
+            If a job throws, remaining jobs are not started anymore and the first
+            exception is rethrown in the calling thread.
+        */
+        void run(size_t numJobs, const Job& job) const;
+
+        /** Runs parallelJob(i) on the pool and serialJob(i) on the calling thread, for all
+            i in [0, numJobs), a window of a few jobs per thread at a time.
+        @par
+            This is the way to process many files: read or patch them in parallelJob and do
+            everything involving Ogre's managers in serialJob. serialJob is called in index
+            order, after all parallel jobs of its window are done, so it may consume and
+            release their results. Bounding the window bounds the memory held at once.
+        @param windowJob optional, called as windowJob(first, count) on the calling thread
+            after the serial jobs of each window.
+        */
+        void runWindowed(size_t numJobs, const Job& parallelJob, const Job& serialJob,
+            const WindowJob& windowJob = WindowJob()) const;
+
+        /// Returns the number of hardware threads, at least 1.
+        static size_t getHardwareThreadCount();
+
+    private:
+        size_t mNumThreads;
+    };
+}
+#endif
@@ -26,6 +26,7 @@ THE SOFTWARE.
 
 #include "MeshMagickPrerequisites.h"
 #include "MmOptionsParser.h"
+#include "MmThreadPool.h"
 
 #ifdef __APPLE__
 #	include <Ogre/OgreStringVector.h>
@@ -34,6 +35,7 @@ THE SOFTWARE.
 #endif
 
 #include <iostream>
+#include <map>
 
 namespace meshmagick
 {
@@ -58,18 +60,51 @@ namespace meshmagick
     protected:
         Verbosity mVerbosity;
         bool mFollowSkeletonLink;
+        /// Whether to report peak memory use after the invocation.
+        bool mReportMemory;
+        /// Peak resident memory in MB not to exceed, 0 for no limit.
+        size_t mMemoryBudget;
+        /// Number of worker threads tools may use, 0 for one per hardware thread.
+        size_t mNumThreads;
 
         void print(const Ogre::String& msg, Verbosity verbosity=V_NORMAL,
 			std::ostream& out = std::cout) const;
         void warn(const Ogre::String& msg) const;
         void fail(const Ogre::String& msg) const;
 
+        /// Checks whether the skeleton file inFile has already been processed during
+        /// the current invocation. If so, and it was written to a different file than
+        /// outFile, the previously written output is copied to outFile.
+        /// Tools call this before loading a skeleton, so that a skeleton shared by many
+        /// meshes of a batch is loaded, processed and written only once.
+        /// @return true if the skeleton does not need to be processed again.
+        bool isSkeletonProcessed(const Ogre::String& inFile, const Ogre::String& outFile);
+
+        /// Records that the skeleton file inFile has been processed and saved as outFile.
+        void setSkeletonProcessed(const Ogre::String& inFile, const Ogre::String& outFile);
+
+        /// Calls job(i) for all i in [0, numFiles) and releases the resources loaded for
+        /// each file after its job, see OgreEnvironment::releaseFileResources.
+        void forEachFile(size_t numFiles, const ThreadPool::Job& job) const;
+
+        /// Like forEachFile above, but runs parallelJob(i) on mNumThreads workers first,
+        /// a window of files at a time, see ThreadPool::runWindowed.
+        void forEachFile(size_t numFiles, const ThreadPool::Job& parallelJob,
+            const ThreadPool::Job& job,
+            const ThreadPool::WindowJob& windowJob = ThreadPool::WindowJob()) const;
+
         virtual void doInvoke(const OptionList& toolOptions,
             const Ogre::StringVector& inFileNames,
             const Ogre::StringVector& outFileNames) = 0;
 
     private:
+        /// Maps resolved input skeleton file names to the resolved file name of the
+        /// output written for them. Reset on each invocation.
+        typedef std::map<Ogre::String, Ogre::String> ProcessedSkeletonMap;
+        ProcessedSkeletonMap mProcessedSkeletons;
+
         void setGlobalOptions(const OptionList& globalOptions);
+        void reportMemoryUse() const;
     };
 }
 #endif
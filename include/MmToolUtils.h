@@ -38,6 +38,7 @@ THE SOFTWARE.
 #	include <OgreVector.h>
 #endif
 
+#include <vector>
 
 namespace meshmagick
 {
@@ -66,6 +67,29 @@ namespace meshmagick
 			std::ios::fmtflags flags=std::ios::fmtflags(std::ios_base::fixed));
 
         static bool fileExists(const Ogre::String& fileName);
+
+        /// Returns the absolute, canonical name of the given file, with symbolic links
+        /// and relative path components resolved. Two names referring to the same file
+        /// yield the same string. If the file does not exist, the name is returned as is.
+        static Ogre::String getResolvedFileName(const Ogre::String& fileName);
+
+        /// Returns the peak resident memory of this process in bytes, 0 if unknown.
+        static size_t getPeakResidentMemory();
+
+        static bool isDirectory(const Ogre::String& fileName);
+
+        /// Returns the names of all files in given directory and its sub directories, that
+        /// match one of the patterns (e.g. "*.mesh"). Result is sorted, so that it does not
+        /// depend on the order in which the file system lists directory entries.
+        static Ogre::StringVector findFiles(const Ogre::String& directory,
+            const Ogre::StringVector& patterns);
+
+        /// Reads the whole file into contents, which stay empty if the file can't be read.
+        /// Safe to call from worker threads.
+        static void readFile(const Ogre::String& fileName, std::vector<unsigned char>& contents);
+
+        /// Returns str as a quoted and escaped JSON string literal.
+        static Ogre::String getJsonString(const Ogre::String& str);
         
         /// Returns the guessed fully qualified file name of the skeleton file referenced by
         /// given mesh.
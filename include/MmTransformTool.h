@@ -53,6 +53,14 @@ namespace meshmagick
 		void transform(Ogre::MeshPtr mesh, Ogre::Matrix4 transformation, bool followSkeleton = true);
 		void transform(Ogre::SkeletonPtr skeleton, Ogre::Matrix4 transformation);
 
+		/// Sets whether transform reverses the vertex winding of triangles,
+		/// e.g. to keep faces front facing under a mirroring transformation.
+		void setFlipVertexWinding(bool flip) { mFlipVertexWinding = flip; }
+
+		/// Sets whether transform normalises normals, binormals and tangents.
+		/// Needed for transformations that scale.
+		void setNormaliseNormals(bool normalise) { mNormaliseNormals = normalise; }
+
     private:
         Ogre::Matrix4 mTransform;
         Ogre::AxisAlignedBox mBoundingBox;
@@ -0,0 +1,73 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __MM_VERTEX_WELDER_H__
+#define __MM_VERTEX_WELDER_H__
+
+#include "MeshMagickPrerequisites.h"
+
+#ifdef __APPLE__
+#	include <Ogre/OgreAnimationTrack.h>
+#	include <Ogre/OgreMesh.h>
+#else
+#	include <OgreAnimationTrack.h>
+#	include <OgreMesh.h>
+#endif
+
+#include "MmOptimiseTool.h"
+
+#include <vector>
+
+namespace meshmagick
+{
+    /** Collapses coincident vertices of a VertexData into one.
+    @par
+        Vertices are compared like the optimise tool does, see UniqueVertexLess.
+        Additionally colours, blend data, bone assignments and morph key frame
+        positions have to match, because unlike duplicates within a single mesh,
+        vertices of different meshes may well differ in those.
+    @par
+        Candidates are looked up in a spatial hash with cells of the position tolerance,
+        so welding takes linear time.
+    */
+    class _MeshMagickExport VertexWelder
+    {
+    public:
+        VertexWelder(Ogre::Real posTolerance, Ogre::Real normTolerance, Ogre::Real uvTolerance);
+
+        /** Welds the vertices of vd.
+        @param indexDatas all index data referencing vd, remapped in place.
+        @param boneAssignments assignments to vd's vertices, remapped in place.
+        @param morphTracks morph animation tracks targeting vd. Their key frame buffers
+            are replaced by buffers holding the remaining vertices only.
+        @return number of vertices removed.
+        */
+        size_t weld(Ogre::VertexData* vd, const std::vector<Ogre::IndexData*>& indexDatas,
+            Ogre::Mesh::VertexBoneAssignmentList& boneAssignments,
+            const std::vector<Ogre::VertexAnimationTrack*>& morphTracks) const;
+
+    private:
+        UniqueVertexLess mLess;
+    };
+}
+#endif
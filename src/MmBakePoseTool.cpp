@@ -0,0 +1,358 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmBakePoseTool.h"
+
+#include "MmMeshUtils.h"
+#include "MmOgreEnvironment.h"
+#include "MmStatefulMeshSerializer.h"
+#include "MmStatefulSkeletonSerializer.h"
+#include "MmToolUtils.h"
+
+#include <OgreAnimation.h>
+#include <OgreHardwareBufferManager.h>
+#include <OgreStringConverter.h>
+#include <OgreSubMesh.h>
+
+using namespace Ogre;
+
+namespace meshmagick
+{
+    BakePoseTool::BakePoseTool()
+        : Tool(), mAnimationName(), mTime(0)
+    {
+    }
+
+    String BakePoseTool::getName() const
+    {
+        return "bakepose";
+    }
+
+    void BakePoseTool::doInvoke(const OptionList& toolOptions,
+        const StringVector& inFileNames, const StringVector& outFileNamesArg)
+    {
+        // Name count has to match, else we have no way to figure out how to apply output
+        // names to input files.
+        if (!(outFileNamesArg.empty() || inFileNames.size() == outFileNamesArg.size()))
+        {
+            fail("number of output files must match number of input files.");
+        }
+
+        mAnimationName = StringUtil::BLANK;
+        mTime = 0;
+        for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
+        {
+            if (it->first == "animation")
+            {
+                mAnimationName = any_cast<String>(it->second);
+            }
+            else if (it->first == "time")
+            {
+                mTime = any_cast<Real>(it->second);
+                if (mTime < 0)
+                {
+                    fail("time must not be negative.");
+                }
+            }
+        }
+
+        StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
+
+        forEachFile(inFileNames.size(), [&](size_t i)
+        {
+            if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
+            {
+                processMeshFile(inFileNames[i], outFileNames[i]);
+            }
+            else
+            {
+                warn("unrecognised name ending for file " + inFileNames[i]);
+                warn("file skipped.");
+            }
+        });
+    }
+
+    void BakePoseTool::processMeshFile(const String& inFile, const String& outFile)
+    {
+        StatefulMeshSerializer* meshSerializer =
+            OgreEnvironment::getSingleton().getMeshSerializer();
+
+        print("Loading mesh " + inFile + "...");
+        MeshPtr mesh;
+        try
+        {
+            mesh = meshSerializer->loadMesh(inFile);
+        }
+        catch (std::exception& e)
+        {
+            warn(e.what());
+            warn("Unable to open mesh file " + inFile);
+            warn("file skipped.");
+            return;
+        }
+
+        if (!mesh->hasSkeleton() && mesh->getBoneAssignments().empty())
+        {
+            bool hasAssignments = false;
+            for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+            {
+                hasAssignments |= !mesh->getSubMesh(i)->getBoneAssignments().empty();
+            }
+            if (!hasAssignments)
+            {
+                print("Mesh " + inFile + " isn't skinned, file skipped.");
+                return;
+            }
+        }
+
+        if (!mAnimationName.empty())
+        {
+            if (!mesh->hasSkeleton())
+            {
+                warn("mesh " + inFile + " has no skeleton to take animation "
+                    + mAnimationName + " from.");
+                warn("file skipped.");
+                return;
+            }
+
+            String skeletonFileName = ToolUtils::getSkeletonFileName(mesh, inFile);
+            if (skeletonFileName.empty())
+            {
+                warn("Unable to locate skeleton " + mesh->getSkeletonName() + " referenced by "
+                    + inFile);
+                warn("file skipped.");
+                return;
+            }
+
+            print("Loading skeleton " + skeletonFileName + "...");
+            SkeletonPtr skeleton;
+            try
+            {
+                skeleton = OgreEnvironment::getSingleton().getSkeletonSerializer()->loadSkeleton(
+                    skeletonFileName);
+            }
+            catch (std::exception& e)
+            {
+                warn(e.what());
+                warn("Unable to open skeleton file " + skeletonFileName);
+                warn("file skipped.");
+                return;
+            }
+
+            if (!skeleton->hasAnimation(mAnimationName))
+            {
+                warn("skeleton " + skeletonFileName + " has no animation " + mAnimationName);
+                warn("file skipped.");
+                return;
+            }
+            if (mesh->hasVertexAnimation())
+            {
+                warn("vertex animations of " + inFile + " are not adjusted to the baked pose.");
+            }
+
+            print("Baking frame " + StringConverter::toString(mTime) + " of animation "
+                + mAnimationName + "...");
+            skeleton->reset(true);
+            skeleton->getAnimation(mAnimationName)->apply(skeleton.get(), mTime);
+            bakePose(mesh.get(), skeleton.get());
+
+            AxisAlignedBox aabb = MeshUtils::getMeshAabb(mesh.get());
+            mesh->_setBounds(aabb, false);
+            mesh->_setBoundingSphereRadius(Math::boundingRadiusFromAABB(aabb));
+        }
+
+        print("Removing skinning...");
+        removeSkinning(mesh.get());
+
+        if (meshSerializer->saveMesh(outFile, true))
+        {
+            print("Mesh saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Mesh " + outFile + " unchanged, not written.");
+        }
+    }
+
+    void BakePoseTool::bakePose(Mesh* mesh, const Skeleton* skeleton) const
+    {
+        // _getBoneMatrices is not const, but only reads derived transforms.
+        Skeleton* skel = const_cast<Skeleton*>(skeleton);
+        std::vector<Affine3> boneMatrices(skel->getNumBones());
+        if (!boneMatrices.empty())
+        {
+            skel->_getBoneMatrices(&boneMatrices[0]);
+        }
+
+        if (mesh->sharedVertexData != NULL)
+        {
+            bakeVertexData(mesh->sharedVertexData, mesh->getBoneAssignments(), boneMatrices);
+        }
+        for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+        {
+            SubMesh* subMesh = mesh->getSubMesh(i);
+            if (!subMesh->useSharedVertices && subMesh->vertexData != NULL)
+            {
+                bakeVertexData(subMesh->vertexData, subMesh->getBoneAssignments(),
+                    boneMatrices);
+            }
+        }
+    }
+
+    void BakePoseTool::bakeVertexData(VertexData* vertexData,
+        const Mesh::VertexBoneAssignmentList& assignments,
+        const std::vector<Affine3>& boneMatrices) const
+    {
+        // Blend the bone matrices per vertex first, weights normalised like Ogre does.
+        std::vector<Affine3> blended(vertexData->vertexCount, Affine3::ZERO);
+        std::vector<Real> weights(vertexData->vertexCount, 0);
+        for (Mesh::VertexBoneAssignmentList::const_iterator it = assignments.begin();
+            it != assignments.end(); ++it)
+        {
+            const VertexBoneAssignment& vba = it->second;
+            if (vba.vertexIndex >= vertexData->vertexCount)
+            {
+                continue;
+            }
+            if (vba.boneIndex >= boneMatrices.size())
+            {
+                warn("bone assignment references unknown bone "
+                    + StringConverter::toString(vba.boneIndex) + ", ignored.");
+                continue;
+            }
+            const Affine3& m = boneMatrices[vba.boneIndex];
+            Affine3& b = blended[vba.vertexIndex];
+            for (size_t r = 0; r < 3; ++r)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    b[r][c] += m[r][c] * vba.weight;
+                }
+            }
+            weights[vba.vertexIndex] += vba.weight;
+        }
+        for (size_t v = 0; v < vertexData->vertexCount; ++v)
+        {
+            if (weights[v] > 0)
+            {
+                Affine3& b = blended[v];
+                for (size_t r = 0; r < 3; ++r)
+                {
+                    for (size_t c = 0; c < 4; ++c)
+                    {
+                        b[r][c] /= weights[v];
+                    }
+                }
+            }
+        }
+
+        const VertexDeclaration::VertexElementList& elements =
+            vertexData->vertexDeclaration->getElements();
+        for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+            it != elements.end(); ++it)
+        {
+            const VertexElement& elem = *it;
+            const VertexElementSemantic semantic = elem.getSemantic();
+            if (semantic != VES_POSITION && semantic != VES_NORMAL
+                && semantic != VES_BINORMAL && semantic != VES_TANGENT)
+            {
+                continue;
+            }
+            if (elem.getType() != VET_FLOAT3 && elem.getType() != VET_FLOAT4)
+            {
+                warn("skipped vertex element of unsupported type.");
+                continue;
+            }
+
+            HardwareVertexBufferSharedPtr buffer =
+                vertexData->vertexBufferBinding->getBuffer(elem.getSource());
+            unsigned char* data = static_cast<unsigned char*>(
+                buffer->lock(HardwareBuffer::HBL_NORMAL));
+            data += vertexData->vertexStart * buffer->getVertexSize();
+            for (size_t v = 0; v < vertexData->vertexCount; ++v, data += buffer->getVertexSize())
+            {
+                if (!(weights[v] > 0))
+                {
+                    continue;
+                }
+
+                float* ptr;
+                elem.baseVertexPointerToElement(data, &ptr);
+                Vector3 value(ptr[0], ptr[1], ptr[2]);
+                if (semantic == VES_POSITION)
+                {
+                    value = blended[v] * value;
+                }
+                else
+                {
+                    // Tangent w holds the handedness, which the pose doesn't change.
+                    value = blended[v].linear() * value;
+                    value.normalise();
+                }
+                ptr[0] = value.x;
+                ptr[1] = value.y;
+                ptr[2] = value.z;
+            }
+            buffer->unlock();
+        }
+    }
+
+    void BakePoseTool::removeSkinning(Mesh* mesh) const
+    {
+        mesh->clearBoneAssignments();
+        if (mesh->sharedVertexData != NULL)
+        {
+            removeBlendElements(mesh->sharedVertexData);
+        }
+        for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+        {
+            SubMesh* subMesh = mesh->getSubMesh(i);
+            subMesh->clearBoneAssignments();
+            if (!subMesh->useSharedVertices && subMesh->vertexData != NULL)
+            {
+                removeBlendElements(subMesh->vertexData);
+            }
+        }
+        mesh->setSkeletonName(StringUtil::BLANK);
+    }
+
+    void BakePoseTool::removeBlendElements(VertexData* vertexData)
+    {
+        const VertexDeclaration::VertexElementList& elements =
+            vertexData->vertexDeclaration->getElements();
+        std::vector<bool> remove;
+        bool any = false;
+        for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+            it != elements.end(); ++it)
+        {
+            bool blend = it->getSemantic() == VES_BLEND_INDICES
+                || it->getSemantic() == VES_BLEND_WEIGHTS;
+            remove.push_back(blend);
+            any |= blend;
+        }
+        if (any)
+        {
+            MeshUtils::removeVertexElements(vertexData, remove);
+        }
+    }
+}
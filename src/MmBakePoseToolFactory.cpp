@@ -0,0 +1,84 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmBakePoseToolFactory.h"
+
+#include "MmOptionsParser.h"
+#include "MmBakePoseTool.h"
+
+namespace meshmagick
+{
+
+	BakePoseToolFactory::BakePoseToolFactory()
+	{
+	}
+
+	BakePoseToolFactory::~BakePoseToolFactory()
+	{
+	}
+
+	Tool* BakePoseToolFactory::createTool()
+	{
+		return new BakePoseTool();
+	}
+
+	void BakePoseToolFactory::destroyTool(Tool* tool)
+	{
+		delete tool;
+	}
+
+	OptionDefinitionSet BakePoseToolFactory::getOptionDefinitions() const
+	{
+		OptionDefinitionSet optionDefs;
+		optionDefs.insert(OptionDefinition("animation", OT_STRING));
+		optionDefs.insert(OptionDefinition("time", OT_REAL, false, false, Any(Ogre::Real(0))));
+		return optionDefs;
+	}
+
+	Ogre::String BakePoseToolFactory::getToolName() const
+	{
+		return "bakepose";
+	}
+
+	Ogre::String BakePoseToolFactory::getToolDescription() const
+	{
+		return "Bake a skeleton pose into meshes and remove skinning from them.";
+	}
+
+	void BakePoseToolFactory::printToolHelp(std::ostream& out) const
+	{
+		out << std::endl;
+		out << "Bake a skeleton pose into meshes and remove skinning from them" << std::endl
+			<< std::endl;
+		out << "Meant for static props, that reference a skeleton but never play a skeletal" << std::endl
+			<< "animation. Positions, normals, binormals and tangents are skinned with the" << std::endl
+			<< "chosen pose, then bone assignments, blend indices and blend weights are" << std::endl
+			<< "removed and the skeleton link is cleared. Without -animation the binding" << std::endl
+			<< "pose is kept, vertex data stays as it is and the skeleton isn't needed." << std::endl
+			<< std::endl;
+		out << "Options:" << std::endl;
+		out << "   -animation=name - Skeleton animation to take the pose from." << std::endl;
+		out << "   -time=t         - Time in seconds within the animation, defaults to 0." << std::endl
+			<< std::endl;
+	}
+}
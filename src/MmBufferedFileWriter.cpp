@@ -0,0 +1,226 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmBufferedFileWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ios>
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX // keeps std::min usable
+#   endif
+#   include <windows.h>
+#endif
+
+using namespace Ogre;
+
+namespace
+{
+    /// DataStream writing into a growing byte vector.
+    class MemoryWriteStream : public DataStream
+    {
+    public:
+        MemoryWriteStream(std::vector<unsigned char>& buffer)
+            : DataStream(DataStream::READ | DataStream::WRITE), mBuffer(buffer), mPos(0)
+        {
+        }
+
+        size_t read(void* buf, size_t count)
+        {
+            size_t numBytes = std::min(count, mBuffer.size() - mPos);
+            if (numBytes > 0)
+            {
+                memcpy(buf, &mBuffer[mPos], numBytes);
+                mPos += numBytes;
+            }
+            return numBytes;
+        }
+
+        size_t write(const void* buf, size_t count)
+        {
+            if (mPos + count > mBuffer.size())
+            {
+                mBuffer.resize(mPos + count);
+                mSize = mBuffer.size();
+            }
+            if (count > 0)
+            {
+                memcpy(&mBuffer[mPos], buf, count);
+                mPos += count;
+            }
+            return count;
+        }
+
+        void skip(long count)
+        {
+            seek(static_cast<size_t>(static_cast<long>(mPos) + count));
+        }
+
+        void seek(size_t pos)
+        {
+            mPos = std::min(pos, mBuffer.size());
+        }
+
+        size_t tell() const
+        {
+            return mPos;
+        }
+
+        bool eof() const
+        {
+            return mPos >= mBuffer.size();
+        }
+
+        void close()
+        {
+        }
+
+    private:
+        std::vector<unsigned char>& mBuffer;
+        size_t mPos;
+    };
+}
+
+namespace meshmagick
+{
+    BufferedFileWriter::BufferedFileWriter(size_t initialCapacity)
+        : mBuffer(), mStream()
+    {
+        mBuffer.reserve(initialCapacity);
+        mStream = DataStreamPtr(new MemoryWriteStream(mBuffer));
+    }
+
+    BufferedFileWriter::~BufferedFileWriter()
+    {
+        mStream.reset();
+    }
+
+    DataStreamPtr BufferedFileWriter::getStream() const
+    {
+        return mStream;
+    }
+
+    const std::vector<unsigned char>& BufferedFileWriter::getBuffer() const
+    {
+        return mBuffer;
+    }
+
+    bool BufferedFileWriter::commit(const String& fileName)
+    {
+        if (hasIdenticalContents(fileName))
+        {
+            return false;
+        }
+
+        // Write to a temporary file first and move it over the target afterwards,
+        // so that an interrupted write never corrupts the target.
+        const String tempFileName = fileName + ".tmp";
+        std::ofstream ofs;
+        ofs.open(tempFileName.c_str(),
+            std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if (!ofs)
+        {
+            throw std::ios_base::failure(("cannot open file " + tempFileName).c_str());
+        }
+
+        if (!mBuffer.empty())
+        {
+            ofs.write(reinterpret_cast<const char*>(&mBuffer[0]),
+                static_cast<std::streamsize>(mBuffer.size()));
+        }
+        ofs.close();
+        if (ofs.fail())
+        {
+            std::remove(tempFileName.c_str());
+            throw std::ios_base::failure(("cannot write file " + tempFileName).c_str());
+        }
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        // rename() doesn't replace an existing file on Windows. MoveFileEx does, and
+        // leaves the target untouched if it fails. The temporary file is kept then,
+        // so that the new contents aren't lost either.
+        if (!MoveFileExA(tempFileName.c_str(), fileName.c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        {
+            throw std::ios_base::failure(("cannot replace file " + fileName
+                + ", new contents are in " + tempFileName).c_str());
+        }
+#else
+        if (std::rename(tempFileName.c_str(), fileName.c_str()) != 0)
+        {
+            std::remove(tempFileName.c_str());
+            throw std::ios_base::failure(("cannot replace file " + fileName).c_str());
+        }
+#endif
+
+        return true;
+    }
+
+    bool BufferedFileWriter::hasIdenticalContents(const String& fileName) const
+    {
+        std::ifstream ifs;
+        ifs.open(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+        if (!ifs)
+        {
+            return false;
+        }
+
+        // Cheap test first, files of different size can't be equal.
+        ifs.seekg(0, std::ios_base::end);
+        if (static_cast<size_t>(ifs.tellg()) != mBuffer.size())
+        {
+            return false;
+        }
+        ifs.seekg(0, std::ios_base::beg);
+
+        uint64 fileHash = FNV_OFFSET_BASIS;
+        std::vector<unsigned char> chunk(1024 * 1024);
+        while (ifs)
+        {
+            ifs.read(reinterpret_cast<char*>(&chunk[0]), static_cast<std::streamsize>(chunk.size()));
+            size_t numRead = static_cast<size_t>(ifs.gcount());
+            if (numRead == 0)
+            {
+                break;
+            }
+            fileHash = getHash(&chunk[0], numRead, fileHash);
+        }
+
+        uint64 bufferHash = mBuffer.empty() ? FNV_OFFSET_BASIS : getHash(&mBuffer[0], mBuffer.size());
+        return fileHash == bufferHash;
+    }
+
+    uint64 BufferedFileWriter::getHash(const unsigned char* data, size_t size, uint64 hash)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,421 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmChunkPatcher.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Ogre;
+
+namespace
+{
+    // Chunk ids as found in OgreMeshFileFormat.h and OgreSkeletonFileFormat.h.
+    const uint16 HEADER_CHUNK_ID = 0x1000;
+    const uint16 M_MESH = 0x3000;
+    const uint16 M_SUBMESH = 0x4000;
+    const uint16 M_MESH_SKELETON_LINK = 0x6000;
+    const uint16 M_SUBMESH_NAME_TABLE = 0xA000;
+    const uint16 M_SUBMESH_NAME_TABLE_ELEMENT = 0xA100;
+    const uint16 SKELETON_BONE = 0x2000;
+    const uint16 SKELETON_ANIMATION = 0x4000;
+
+    /// Size of chunk id and chunk length.
+    const size_t CHUNK_HEADER_SIZE = sizeof(uint16) + sizeof(uint32);
+
+    /// Reads and writes the primitives of a serialised file in its byte order.
+    class ChunkStream
+    {
+    public:
+        ChunkStream(const std::vector<unsigned char>& in, std::vector<unsigned char>& out)
+            : mIn(in), mOut(out), mFlipEndian(false)
+        {
+        }
+
+        /// Reads the file header. Returns false, if the header is unknown.
+        bool readHeader(size_t& pos, String& version)
+        {
+            uint16 id;
+            if (!read(pos, id))
+            {
+                return false;
+            }
+            if (id != HEADER_CHUNK_ID)
+            {
+                mFlipEndian = true;
+                if (flip(id) != HEADER_CHUNK_ID)
+                {
+                    return false;
+                }
+            }
+            return readString(pos, version);
+        }
+
+        bool read(size_t& pos, uint16& value) const
+        {
+            return readRaw(pos, &value, sizeof(value));
+        }
+
+        bool read(size_t& pos, uint32& value) const
+        {
+            return readRaw(pos, &value, sizeof(value));
+        }
+
+        /// Reads a string terminated by a newline, the way Ogre's Serializer does.
+        bool readString(size_t& pos, String& str) const
+        {
+            const unsigned char* begin = mIn.empty() ? NULL : &mIn[0];
+            const void* end = pos < mIn.size()
+                ? memchr(begin + pos, '\n', mIn.size() - pos) : NULL;
+            if (end == NULL)
+            {
+                return false;
+            }
+            const size_t length = static_cast<const unsigned char*>(end) - (begin + pos);
+            str.assign(reinterpret_cast<const char*>(begin + pos), length);
+            pos += length + 1;
+            return true;
+        }
+
+        /// Reads a chunk header and checks, that the chunk lies within [pos, end).
+        bool readChunk(size_t& pos, size_t end, uint16& id, size_t& chunkEnd) const
+        {
+            const size_t start = pos;
+            uint32 length;
+            if (!read(pos, id) || !read(pos, length)
+                || length < CHUNK_HEADER_SIZE || length > end - start)
+            {
+                return false;
+            }
+            chunkEnd = start + length;
+            return true;
+        }
+
+        void copy(size_t begin, size_t end)
+        {
+            mOut.insert(mOut.end(), mIn.begin() + begin, mIn.begin() + end);
+        }
+
+        void write(uint16 value)
+        {
+            writeRaw(&value, sizeof(value));
+        }
+
+        void writeString(const String& str)
+        {
+            mOut.insert(mOut.end(), str.begin(), str.end());
+            mOut.push_back('\n');
+        }
+
+        /// Starts a chunk with a preliminary length, returns its position for endChunk.
+        size_t beginChunk(uint16 id)
+        {
+            const size_t start = mOut.size();
+            write(id);
+            const uint32 length = 0;
+            writeRaw(&length, sizeof(length));
+            return start;
+        }
+
+        /// Sets the length of the chunk started at start to everything written since.
+        void endChunk(size_t start)
+        {
+            uint32 length = static_cast<uint32>(mOut.size() - start);
+            if (mFlipEndian)
+            {
+                length = flip(length);
+            }
+            memcpy(&mOut[start + sizeof(uint16)], &length, sizeof(length));
+        }
+
+    private:
+        const std::vector<unsigned char>& mIn;
+        std::vector<unsigned char>& mOut;
+        bool mFlipEndian;
+
+        template <typename T> static T flip(T value)
+        {
+            unsigned char* bytes = reinterpret_cast<unsigned char*>(&value);
+            for (size_t i = 0; i < sizeof(T) / 2; ++i)
+            {
+                std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+            }
+            return value;
+        }
+
+        template <typename T> bool readRaw(size_t& pos, T* value, size_t size) const
+        {
+            if (pos > mIn.size() || size > mIn.size() - pos)
+            {
+                return false;
+            }
+            memcpy(value, &mIn[pos], size);
+            pos += size;
+            if (mFlipEndian)
+            {
+                *value = flip(*value);
+            }
+            return true;
+        }
+
+        template <typename T> void writeRaw(const T* value, size_t size)
+        {
+            T v = mFlipEndian ? flip(*value) : *value;
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+            mOut.insert(mOut.end(), bytes, bytes + size);
+        }
+    };
+}
+
+namespace meshmagick
+{
+    ChunkPatcher::ChunkPatcher()
+        : mMaterialRenames(), mSubMeshRenames(), mBoneRenames(), mAnimationRenames(),
+        mSkeletonName(), mSetSkeletonName(false), mRenameMap(NULL)
+    {
+    }
+
+    void ChunkPatcher::addMaterialRename(const String& before, const String& after)
+    {
+        mMaterialRenames.push_back(std::make_pair(before, after));
+    }
+
+    void ChunkPatcher::addSubMeshRename(const String& before, const String& after)
+    {
+        mSubMeshRenames.push_back(std::make_pair(before, after));
+    }
+
+    void ChunkPatcher::addBoneRename(const String& before, const String& after)
+    {
+        mBoneRenames.push_back(std::make_pair(before, after));
+    }
+
+    void ChunkPatcher::addAnimationRename(const String& before, const String& after)
+    {
+        mAnimationRenames.push_back(std::make_pair(before, after));
+    }
+
+    void ChunkPatcher::setSkeletonName(const String& name)
+    {
+        mSkeletonName = name;
+        mSetSkeletonName = true;
+    }
+
+    void ChunkPatcher::setRenameMap(const RenameMap* map)
+    {
+        mRenameMap = map;
+    }
+
+    bool ChunkPatcher::patchMesh(const std::vector<unsigned char>& contents,
+        std::vector<unsigned char>& patched) const
+    {
+        patched.clear();
+        patched.reserve(contents.size());
+        ChunkStream stream(contents, patched);
+
+        // Versions before 1.8 didn't always write correct chunk lengths.
+        size_t pos = 0;
+        String version;
+        if (!stream.readHeader(pos, version) || (version != "[MeshSerializer_v1.100]"
+            && version != "[MeshSerializer_v1.10]" && version != "[MeshSerializer_v1.8]"))
+        {
+            return false;
+        }
+        stream.copy(0, pos);
+
+        bool hasSkeletonLink = false;
+        while (pos < contents.size())
+        {
+            const size_t chunkStart = pos;
+            uint16 id;
+            size_t chunkEnd;
+            if (!stream.readChunk(pos, contents.size(), id, chunkEnd))
+            {
+                return false;
+            }
+            if (id != M_MESH)
+            {
+                stream.copy(chunkStart, chunkEnd);
+                pos = chunkEnd;
+                continue;
+            }
+
+            // The mesh chunk starts with the skeletally animated flag.
+            if (pos == chunkEnd)
+            {
+                return false;
+            }
+            const size_t mesh = stream.beginChunk(id);
+            stream.copy(pos, pos + 1);
+            pos += 1;
+            while (pos < chunkEnd)
+            {
+                const size_t subStart = pos;
+                uint16 subId;
+                size_t subEnd;
+                if (!stream.readChunk(pos, chunkEnd, subId, subEnd))
+                {
+                    return false;
+                }
+
+                String name;
+                if (subId == M_SUBMESH)
+                {
+                    // Material name first, then everything else.
+                    if (!stream.readString(pos, name) || pos > subEnd)
+                    {
+                        return false;
+                    }
+                    const size_t subMesh = stream.beginChunk(subId);
+                    stream.writeString(rename(name, mMaterialRenames, RenameMap::RK_MATERIAL));
+                    stream.copy(pos, subEnd);
+                    stream.endChunk(subMesh);
+                }
+                else if (subId == M_MESH_SKELETON_LINK)
+                {
+                    if (!stream.readString(pos, name) || pos != subEnd)
+                    {
+                        return false;
+                    }
+                    hasSkeletonLink = true;
+                    const size_t link = stream.beginChunk(subId);
+                    stream.writeString(mSetSkeletonName ? mSkeletonName : name);
+                    stream.endChunk(link);
+                }
+                else if (subId == M_SUBMESH_NAME_TABLE)
+                {
+                    const size_t table = stream.beginChunk(subId);
+                    while (pos < subEnd)
+                    {
+                        const size_t elementStart = pos;
+                        uint16 elementId;
+                        size_t elementEnd;
+                        if (!stream.readChunk(pos, subEnd, elementId, elementEnd))
+                        {
+                            return false;
+                        }
+                        if (elementId != M_SUBMESH_NAME_TABLE_ELEMENT)
+                        {
+                            stream.copy(elementStart, elementEnd);
+                            pos = elementEnd;
+                            continue;
+                        }
+
+                        // Submesh index, then its name.
+                        if (elementEnd - pos < sizeof(uint16))
+                        {
+                            return false;
+                        }
+                        const size_t element = stream.beginChunk(elementId);
+                        stream.copy(pos, pos + sizeof(uint16));
+                        pos += sizeof(uint16);
+                        if (!stream.readString(pos, name) || pos != elementEnd)
+                        {
+                            return false;
+                        }
+                        stream.writeString(rename(name, mSubMeshRenames, RenameMap::RK_SUBMESH));
+                        stream.endChunk(element);
+                    }
+                    stream.endChunk(table);
+                }
+                else
+                {
+                    stream.copy(subStart, subEnd);
+                }
+                pos = subEnd;
+            }
+            stream.endChunk(mesh);
+        }
+
+        // Adding a skeleton link is left to the serialiser.
+        return hasSkeletonLink || !mSetSkeletonName;
+    }
+
+    bool ChunkPatcher::patchSkeleton(const std::vector<unsigned char>& contents,
+        std::vector<unsigned char>& patched) const
+    {
+        patched.clear();
+        patched.reserve(contents.size());
+        ChunkStream stream(contents, patched);
+
+        size_t pos = 0;
+        String version;
+        if (!stream.readHeader(pos, version)
+            || (version != "[Serializer_v1.80]" && version != "[Serializer_v1.10]"))
+        {
+            return false;
+        }
+        stream.copy(0, pos);
+
+        while (pos < contents.size())
+        {
+            const size_t chunkStart = pos;
+            uint16 id;
+            size_t chunkEnd;
+            if (!stream.readChunk(pos, contents.size(), id, chunkEnd))
+            {
+                return false;
+            }
+
+            // Bones and animations start with their name, then everything else.
+            if (id == SKELETON_BONE || id == SKELETON_ANIMATION)
+            {
+                String name;
+                if (!stream.readString(pos, name) || pos > chunkEnd)
+                {
+                    return false;
+                }
+                const size_t chunk = stream.beginChunk(id);
+                stream.writeString(id == SKELETON_BONE
+                    ? rename(name, mBoneRenames, RenameMap::RK_BONE)
+                    : rename(name, mAnimationRenames, RenameMap::RK_ANIMATION));
+                stream.copy(pos, chunkEnd);
+                stream.endChunk(chunk);
+            }
+            else
+            {
+                stream.copy(chunkStart, chunkEnd);
+            }
+            pos = chunkEnd;
+        }
+        return true;
+    }
+
+    String ChunkPatcher::rename(const String& name, const RenameList& renames,
+        RenameMap::RenameKind kind) const
+    {
+        String rval = name;
+        for (RenameList::const_iterator it = renames.begin(); it != renames.end(); ++it)
+        {
+            if (rval == it->first)
+            {
+                rval = it->second;
+            }
+        }
+        if (mRenameMap != NULL)
+        {
+            mRenameMap->apply(kind, rval);
+        }
+        return rval;
+    }
+}
@@ -0,0 +1,690 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmDedupeTool.h"
+
+#include "MmBufferedFileWriter.h"
+#include "MmMeshUtils.h"
+#include "MmOgreEnvironment.h"
+#include "MmStatefulMeshSerializer.h"
+#include "MmThreadPool.h"
+#include "MmToolUtils.h"
+
+#include <OgreHardwareVertexBuffer.h>
+#include <OgreQuaternion.h>
+#include <OgreStringConverter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+using namespace Ogre;
+
+namespace
+{
+    /// Quantisation step for normalised directions, texture coordinates and
+    /// other float components. Position quantisation is set by -tolerance.
+    const Real ATTRIBUTE_STEP = 1.0f / 4096;
+
+    template <typename T> uint64 hashValue(const T& value, uint64 hash)
+    {
+        return meshmagick::BufferedFileWriter::getHash(
+            reinterpret_cast<const unsigned char*>(&value), sizeof(T), hash);
+    }
+
+    uint64 hashString(const String& str, uint64 hash)
+    {
+        hash = hashValue(str.size(), hash);
+        return meshmagick::BufferedFileWriter::getHash(
+            reinterpret_cast<const unsigned char*>(str.c_str()), str.size(), hash);
+    }
+
+    uint64 hashQuantised(Real value, Real step, uint64 hash)
+    {
+        long long q = static_cast<long long>(std::floor(value / step + 0.5f));
+        return hashValue(q, hash);
+    }
+
+    /// Sum of the vertex sizes of all buffers bound.
+    size_t getVertexSize(const VertexData* vd)
+    {
+        size_t size = 0;
+        const VertexBufferBinding::VertexBufferBindingMap& bindings =
+            vd->vertexBufferBinding->getBindings();
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+            it != bindings.end(); ++it)
+        {
+            size += it->second->getVertexSize();
+        }
+        return size;
+    }
+
+    size_t getIndexBytes(const IndexData* id)
+    {
+        return id != NULL && id->indexBuffer
+            ? id->indexCount * id->indexBuffer->getIndexSize() : 0;
+    }
+
+    bool isDirectionSemantic(VertexElementSemantic semantic)
+    {
+        return semantic == VES_NORMAL || semantic == VES_TANGENT || semantic == VES_BINORMAL;
+    }
+
+    /// Orders elements by semantic and index, so that the canonical form does not depend
+    /// on how the elements are distributed over buffers.
+    struct ElementLess
+    {
+        bool operator()(const VertexElement* lhs, const VertexElement* rhs) const
+        {
+            if (lhs->getSemantic() != rhs->getSemantic())
+            {
+                return lhs->getSemantic() < rhs->getSemantic();
+            }
+            return lhs->getIndex() < rhs->getIndex();
+        }
+    };
+}
+
+namespace meshmagick
+{
+    DedupeTool::DedupeTool() : Tool(), mTolerance(1e-4f), mTransformInvariant(false)
+    {
+    }
+
+    String DedupeTool::getName() const
+    {
+        return "dedupe";
+    }
+
+    void DedupeTool::doInvoke(const OptionList& toolOptions,
+        const StringVector& inFileNames, const StringVector& outFileNames)
+    {
+        if (!outFileNames.empty())
+        {
+            warn("dedupe tool doesn't write meshes. Output files are ignored.");
+        }
+
+        for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
+        {
+            if (it->first == "tolerance")
+            {
+                mTolerance = any_cast<Real>(it->second);
+                if (!(mTolerance > 0))
+                {
+                    fail("tolerance must be greater than zero.");
+                }
+            }
+            else if (it->first == "transform-invariant")
+            {
+                mTransformInvariant = true;
+            }
+        }
+        const String manifestFileName = OptionsUtil::getStringOption(toolOptions, "manifest");
+
+        const StringVector fileNames = getInputFileNames(inFileNames);
+        StatefulMeshSerializer* meshSerializer =
+            OgreEnvironment::getSingleton().getMeshSerializer();
+
+        std::vector<GeometryRecord> meshRecords;
+        std::vector<GeometryRecord> submeshRecords;
+
+        // Files are read in parallel and hashed in parallel once a window is parsed.
+        ThreadPool pool(mNumThreads);
+        std::vector<std::vector<unsigned char> > contents(fileNames.size());
+        std::vector<MeshGeometry> geometries(fileNames.size());
+        std::vector<std::vector<GeometryRecord> > records;
+        forEachFile(fileNames.size(), [&](size_t i)
+        {
+            ToolUtils::readFile(fileNames[i], contents[i]);
+        },
+        [&](size_t i)
+        {
+            const String& fileName = fileNames[i];
+            print("Loading mesh " + fileName + "...", V_HIGH);
+            try
+            {
+                MeshPtr mesh;
+                if (contents[i].empty())
+                {
+                    mesh = meshSerializer->loadMesh(fileName);
+                }
+                else
+                {
+                    DataStreamPtr stream(new MemoryDataStream(fileName,
+                        &contents[i][0], contents[i].size(), false, true));
+                    mesh = meshSerializer->loadMesh(fileName, stream);
+                }
+                extractGeometry(geometries[i], mesh);
+                geometries[i].fileName = fileName;
+            }
+            catch (std::exception& e)
+            {
+                warn(e.what());
+                warn("Unable to open mesh file " + fileName);
+                warn("file skipped.");
+                geometries[i] = MeshGeometry();
+            }
+
+            contents[i] = std::vector<unsigned char>();
+        },
+        [&](size_t first, size_t count)
+        {
+            // First record per mesh is the mesh itself, the others are its submeshes.
+            records.clear();
+            records.resize(count);
+            pool.run(count, [&](size_t i)
+            {
+                const MeshGeometry& mesh = geometries[first + i];
+                if (mesh.fileName.empty())
+                {
+                    return;
+                }
+
+                std::vector<const SubMeshGeometry*> all;
+                for (size_t j = 0; j < mesh.submeshes.size(); ++j)
+                {
+                    all.push_back(&mesh.submeshes[j]);
+                }
+                GeometryRecord meshRecord;
+                meshRecord.name = mesh.fileName;
+                meshRecord.fileName = mesh.fileName;
+                meshRecord.numBytes = mesh.numBytes;
+                meshRecord.frame = getFrame(all);
+                // Only meshes using the same materials can replace each other.
+                meshRecord.hash = hashValue(mesh.submeshes.size(),
+                    BufferedFileWriter::FNV_OFFSET_BASIS);
+                for (size_t j = 0; j < mesh.submeshes.size(); ++j)
+                {
+                    meshRecord.hash = hashString(mesh.submeshes[j].materialName, meshRecord.hash);
+                    meshRecord.hash = getHash(mesh.submeshes[j], meshRecord.frame, meshRecord.hash);
+                }
+                records[i].push_back(meshRecord);
+
+                for (size_t j = 0; j < mesh.submeshes.size(); ++j)
+                {
+                    const SubMeshGeometry& submesh = mesh.submeshes[j];
+                    GeometryRecord record;
+                    record.name = mesh.fileName + ":" + StringConverter::toString(j)
+                        + (submesh.name.empty() ? String() : "(" + submesh.name + ")");
+                    record.fileName = mesh.fileName;
+                    record.numBytes = submesh.numBytes;
+                    record.frame = getFrame(std::vector<const SubMeshGeometry*>(1, &submesh));
+                    record.hash = getHash(submesh, record.frame,
+                        BufferedFileWriter::FNV_OFFSET_BASIS);
+                    records[i].push_back(record);
+                }
+            });
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (!records[i].empty())
+                {
+                    meshRecords.push_back(records[i].front());
+                    submeshRecords.insert(submeshRecords.end(),
+                        records[i].begin() + 1, records[i].end());
+                }
+                geometries[first + i] = MeshGeometry();
+            }
+        });
+
+        print("Scanned " + StringConverter::toString(meshRecords.size()) + " meshes with "
+            + StringConverter::toString(submeshRecords.size()) + " submeshes.");
+        print("");
+
+        reportDuplicates("meshes", meshRecords);
+        // Duplicate meshes consist of duplicate submeshes, so the submesh waste is the total.
+        const size_t wasted = reportDuplicates("submeshes", submeshRecords);
+        print(StringConverter::toString(wasted)
+            + " bytes could be saved by storing each geometry only once.");
+
+        if (!manifestFileName.empty())
+        {
+            writeManifest(manifestFileName, meshRecords);
+        }
+    }
+
+    StringVector DedupeTool::getInputFileNames(const StringVector& inFileNames) const
+    {
+        StringVector fileNames;
+        for (size_t i = 0; i < inFileNames.size(); ++i)
+        {
+            if (ToolUtils::isDirectory(inFileNames[i]))
+            {
+                StringVector found = ToolUtils::findFiles(inFileNames[i],
+                    StringVector(1, "*.mesh"));
+                print("Found " + StringConverter::toString(found.size()) + " files in "
+                    + inFileNames[i], V_HIGH);
+                fileNames.insert(fileNames.end(), found.begin(), found.end());
+            }
+            else if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
+            {
+                fileNames.push_back(inFileNames[i]);
+            }
+            else
+            {
+                warn("unrecognised name ending for file " + inFileNames[i]);
+                warn("file skipped.");
+            }
+        }
+        return fileNames;
+    }
+
+    void DedupeTool::extractGeometry(MeshGeometry& geometry, MeshPtr mesh) const
+    {
+        geometry.numBytes = 0;
+        if (mesh->sharedVertexData != NULL)
+        {
+            geometry.numBytes += mesh->sharedVertexData->vertexCount
+                * getVertexSize(mesh->sharedVertexData);
+        }
+
+        const Mesh::SubMeshNameMap& subMeshNames = mesh->getSubMeshNameMap();
+        geometry.submeshes.resize(mesh->getNumSubMeshes());
+        for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+        {
+            const SubMesh* submesh = mesh->getSubMesh(i);
+            SubMeshGeometry& submeshGeometry = geometry.submeshes[i];
+            for (Mesh::SubMeshNameMap::const_iterator it = subMeshNames.begin();
+                it != subMeshNames.end(); ++it)
+            {
+                if (it->second == i)
+                {
+                    submeshGeometry.name = it->first;
+                }
+            }
+            extractGeometry(submeshGeometry, submesh);
+
+            geometry.numBytes += submesh->useSharedVertices
+                ? getIndexBytes(submesh->indexData) : submeshGeometry.numBytes;
+        }
+    }
+
+    void DedupeTool::extractGeometry(SubMeshGeometry& geometry, const SubMesh* submesh) const
+    {
+        geometry.materialName = submesh->getMaterialName();
+        geometry.operationType = submesh->operationType;
+        geometry.numDirections = 0;
+        geometry.numFloats = 0;
+        geometry.numBytes = getIndexBytes(submesh->indexData);
+
+        const VertexData* vd = submesh->useSharedVertices
+            ? submesh->parent->sharedVertexData : submesh->vertexData;
+        if (vd == NULL)
+        {
+            return;
+        }
+
+        // Number the vertices in the order of their first use. This makes the result
+        // independent of vertex order and of vertices not used by this submesh, which
+        // is important for submeshes sharing vertices.
+        std::vector<uint32> indices = MeshUtils::getIndices(submesh->indexData);
+        if (indices.empty())
+        {
+            for (uint32 i = 0; i < vd->vertexCount; ++i)
+            {
+                indices.push_back(i);
+            }
+        }
+        const uint32 UNUSED = std::numeric_limits<uint32>::max();
+        std::vector<uint32> newIndices(vd->vertexCount, UNUSED);
+        std::vector<uint32> vertices;
+        geometry.indices.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            if (indices[i] >= vd->vertexCount)
+            {
+                throw std::runtime_error("vertex index out of range.");
+            }
+            if (newIndices[indices[i]] == UNUSED)
+            {
+                newIndices[indices[i]] = static_cast<uint32>(vertices.size());
+                vertices.push_back(indices[i]);
+            }
+            geometry.indices.push_back(newIndices[indices[i]]);
+        }
+
+        geometry.numBytes += (submesh->useSharedVertices ? vertices.size() : vd->vertexCount)
+            * getVertexSize(vd);
+
+        std::vector<const VertexElement*> elements;
+        const VertexDeclaration::VertexElementList& elementList =
+            vd->vertexDeclaration->getElements();
+        for (VertexDeclaration::VertexElementList::const_iterator it = elementList.begin();
+            it != elementList.end(); ++it)
+        {
+            elements.push_back(&*it);
+        }
+        std::sort(elements.begin(), elements.end(), ElementLess());
+
+        // Lock each buffer once, all elements are read from the same pointers.
+        std::map<unsigned short, std::pair<const unsigned char*, size_t> > sources;
+        const VertexBufferBinding::VertexBufferBindingMap& bindings =
+            vd->vertexBufferBinding->getBindings();
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+            it != bindings.end(); ++it)
+        {
+            const size_t vertexSize = it->second->getVertexSize();
+            sources[it->first] = std::make_pair(static_cast<const unsigned char*>(
+                it->second->lock(HardwareBuffer::HBL_READ_ONLY)) + vd->vertexStart * vertexSize,
+                vertexSize);
+        }
+
+        bool hasPosition = false;
+        for (size_t e = 0; e < elements.size(); ++e)
+        {
+            const VertexElement* element = elements[e];
+            geometry.layout += StringConverter::toString(element->getSemantic()) + "/"
+                + StringConverter::toString(element->getIndex()) + "/"
+                + StringConverter::toString(element->getType()) + ";";
+            if (sources.find(element->getSource()) == sources.end())
+            {
+                continue;
+            }
+
+            const unsigned char* base = sources[element->getSource()].first + element->getOffset();
+            const size_t vertexSize = sources[element->getSource()].second;
+            const bool isFloat = VertexElement::getBaseType(element->getType()) == VET_FLOAT1;
+            const unsigned short typeCount = VertexElement::getTypeCount(element->getType());
+
+            if (element->getSemantic() == VES_POSITION && !hasPosition && isFloat
+                && typeCount >= 3)
+            {
+                hasPosition = true;
+                for (size_t v = 0; v < vertices.size(); ++v)
+                {
+                    const float* data = reinterpret_cast<const float*>(base + vertices[v] * vertexSize);
+                    geometry.positions.push_back(Vector3(data[0], data[1], data[2]));
+                }
+            }
+            else if (isDirectionSemantic(element->getSemantic()) && isFloat && typeCount >= 3)
+            {
+                // Directions are rotated with the frame, a fourth component is kept as is.
+                ++geometry.numDirections;
+                geometry.numFloats += typeCount - 3;
+                for (size_t v = 0; v < vertices.size(); ++v)
+                {
+                    const float* data = reinterpret_cast<const float*>(base + vertices[v] * vertexSize);
+                    geometry.directions.push_back(Vector3(data[0], data[1], data[2]));
+                    geometry.floats.insert(geometry.floats.end(), data + 3, data + typeCount);
+                }
+            }
+            else if (isFloat)
+            {
+                geometry.numFloats += typeCount;
+                for (size_t v = 0; v < vertices.size(); ++v)
+                {
+                    const float* data = reinterpret_cast<const float*>(base + vertices[v] * vertexSize);
+                    geometry.floats.insert(geometry.floats.end(), data, data + typeCount);
+                }
+            }
+            else
+            {
+                for (size_t v = 0; v < vertices.size(); ++v)
+                {
+                    const unsigned char* data = base + vertices[v] * vertexSize;
+                    geometry.bytes.insert(geometry.bytes.end(), data, data + element->getSize());
+                }
+            }
+        }
+
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+            it != bindings.end(); ++it)
+        {
+            it->second->unlock();
+        }
+    }
+
+    DedupeTool::Frame DedupeTool::getFrame(
+        const std::vector<const SubMeshGeometry*>& geometries) const
+    {
+        Frame frame;
+
+        size_t numPositions = 0;
+        Vector3 sum = Vector3::ZERO;
+        for (size_t i = 0; i < geometries.size(); ++i)
+        {
+            const std::vector<Vector3>& positions = geometries[i]->positions;
+            for (size_t j = 0; j < positions.size(); ++j)
+            {
+                sum += positions[j];
+            }
+            numPositions += positions.size();
+        }
+        if (numPositions == 0)
+        {
+            return frame;
+        }
+        frame.origin = sum / static_cast<Real>(numPositions);
+
+        if (!mTransformInvariant)
+        {
+            return frame;
+        }
+
+        // Principal axes are the eigenvectors of the covariance matrix.
+        Matrix3 covariance = Matrix3::ZERO;
+        Real sumSquaredLength = 0;
+        for (size_t i = 0; i < geometries.size(); ++i)
+        {
+            const std::vector<Vector3>& positions = geometries[i]->positions;
+            for (size_t j = 0; j < positions.size(); ++j)
+            {
+                const Vector3 d = positions[j] - frame.origin;
+                for (int row = 0; row < 3; ++row)
+                {
+                    for (int col = 0; col < 3; ++col)
+                    {
+                        covariance[row][col] += d[row] * d[col];
+                    }
+                }
+                sumSquaredLength += d.squaredLength();
+            }
+        }
+        if (!(sumSquaredLength > 0))
+        {
+            return frame;
+        }
+        frame.scale = std::sqrt(sumSquaredLength / numPositions);
+        covariance = covariance * (1 / static_cast<Real>(numPositions));
+
+        Real eigenValues[3];
+        Vector3 eigenVectors[3];
+        covariance.EigenSolveSymmetric(eigenValues, eigenVectors);
+        int order[3] = {0, 1, 2};
+        std::sort(order, order + 3, [&](int lhs, int rhs)
+        {
+            return eigenValues[lhs] > eigenValues[rhs];
+        });
+        Vector3 axes[2] = {eigenVectors[order[0]], eigenVectors[order[1]]};
+
+        // Eigenvectors have no defined sign, take the direction the geometry is skewed to.
+        // The third axis follows from the other two, so that the frame is never mirrored.
+        for (int a = 0; a < 2; ++a)
+        {
+            Real skew = 0;
+            for (size_t i = 0; i < geometries.size(); ++i)
+            {
+                const std::vector<Vector3>& positions = geometries[i]->positions;
+                for (size_t j = 0; j < positions.size(); ++j)
+                {
+                    const Real distance = axes[a].dotProduct(positions[j] - frame.origin);
+                    skew += distance * distance * distance;
+                }
+            }
+            axes[a].normalise();
+            if (skew < 0)
+            {
+                axes[a] = -axes[a];
+            }
+        }
+        const Vector3 z = axes[0].crossProduct(axes[1]);
+        frame.axes = Matrix3(axes[0].x, axes[0].y, axes[0].z,
+            axes[1].x, axes[1].y, axes[1].z,
+            z.x, z.y, z.z);
+
+        return frame;
+    }
+
+    uint64 DedupeTool::getHash(const SubMeshGeometry& geometry, const Frame& frame,
+        uint64 hash) const
+    {
+        hash = hashString(geometry.layout, hash);
+        hash = hashValue(geometry.operationType, hash);
+        hash = hashValue(geometry.indices.size(), hash);
+        hash = hashValue(geometry.positions.size(), hash);
+        if (!geometry.indices.empty())
+        {
+            hash = BufferedFileWriter::getHash(
+                reinterpret_cast<const unsigned char*>(&geometry.indices[0]),
+                geometry.indices.size() * sizeof(uint32), hash);
+        }
+
+        for (size_t i = 0; i < geometry.positions.size(); ++i)
+        {
+            const Vector3 p = frame.axes * (geometry.positions[i] - frame.origin) / frame.scale;
+            hash = hashQuantised(p.x, mTolerance, hash);
+            hash = hashQuantised(p.y, mTolerance, hash);
+            hash = hashQuantised(p.z, mTolerance, hash);
+        }
+        for (size_t i = 0; i < geometry.directions.size(); ++i)
+        {
+            const Vector3 d = frame.axes * geometry.directions[i];
+            hash = hashQuantised(d.x, ATTRIBUTE_STEP, hash);
+            hash = hashQuantised(d.y, ATTRIBUTE_STEP, hash);
+            hash = hashQuantised(d.z, ATTRIBUTE_STEP, hash);
+        }
+        for (size_t i = 0; i < geometry.floats.size(); ++i)
+        {
+            hash = hashQuantised(geometry.floats[i], ATTRIBUTE_STEP, hash);
+        }
+        if (!geometry.bytes.empty())
+        {
+            hash = BufferedFileWriter::getHash(&geometry.bytes[0], geometry.bytes.size(), hash);
+        }
+        return hash;
+    }
+
+    std::vector<std::vector<size_t> > DedupeTool::getClusters(
+        const std::vector<GeometryRecord>& records)
+    {
+        std::map<uint64, std::vector<size_t> > groups;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            groups[records[i].hash].push_back(i);
+        }
+
+        std::vector<std::vector<size_t> > clusters;
+        for (std::map<uint64, std::vector<size_t> >::const_iterator it = groups.begin();
+            it != groups.end(); ++it)
+        {
+            if (it->second.size() > 1)
+            {
+                clusters.push_back(it->second);
+            }
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(),
+            [&](const std::vector<size_t>& lhs, const std::vector<size_t>& rhs)
+        {
+            return (lhs.size() - 1) * records[lhs.front()].numBytes
+                > (rhs.size() - 1) * records[rhs.front()].numBytes;
+        });
+        return clusters;
+    }
+
+    size_t DedupeTool::reportDuplicates(const String& title,
+        const std::vector<GeometryRecord>& records) const
+    {
+        const String indent = "    ";
+        const std::vector<std::vector<size_t> > clusters = getClusters(records);
+        if (clusters.empty())
+        {
+            print("No duplicate " + title + " found.");
+            print("");
+            return 0;
+        }
+
+        size_t wasted = 0;
+        print(StringConverter::toString(clusters.size()) + " groups of duplicate " + title + ":");
+        for (size_t i = 0; i < clusters.size(); ++i)
+        {
+            const std::vector<size_t>& cluster = clusters[i];
+            const size_t clusterWaste = (cluster.size() - 1) * records[cluster.front()].numBytes;
+            print(indent + StringConverter::toString(cluster.size()) + " copies, "
+                + StringConverter::toString(clusterWaste) + " bytes wasted:");
+            for (size_t j = 0; j < cluster.size(); ++j)
+            {
+                print(indent + indent + records[cluster[j]].name + (j == 0 ? " (kept)" : ""));
+            }
+            wasted += clusterWaste;
+        }
+        print("");
+        return wasted;
+    }
+
+    void DedupeTool::writeManifest(const String& fileName,
+        const std::vector<GeometryRecord>& records) const
+    {
+        const std::vector<std::vector<size_t> > clusters = getClusters(records);
+
+        String manifest = "# duplicate\tkept\ttranslation x y z\torientation w x y z\tscale\n";
+        for (size_t i = 0; i < clusters.size(); ++i)
+        {
+            const GeometryRecord& kept = records[clusters[i].front()];
+            for (size_t j = 1; j < clusters[i].size(); ++j)
+            {
+                const GeometryRecord& duplicate = records[clusters[i][j]];
+                // Frames map positions p to A * (p - o) / s, so the duplicate's positions
+                // are o_d + s_d * A_d^T * A_k * (p_k - o_k) / s_k.
+                const Matrix3 rotation = duplicate.frame.axes.Transpose() * kept.frame.axes;
+                const Real scale = duplicate.frame.scale / kept.frame.scale;
+                const Vector3 translation = duplicate.frame.origin
+                    - scale * (rotation * kept.frame.origin);
+                const Quaternion orientation(rotation);
+
+                manifest += duplicate.fileName + "\t" + kept.fileName
+                    + "\t" + StringConverter::toString(translation.x)
+                    + " " + StringConverter::toString(translation.y)
+                    + " " + StringConverter::toString(translation.z)
+                    + "\t" + StringConverter::toString(orientation.w)
+                    + " " + StringConverter::toString(orientation.x)
+                    + " " + StringConverter::toString(orientation.y)
+                    + " " + StringConverter::toString(orientation.z)
+                    + "\t" + StringConverter::toString(scale) + "\n";
+            }
+        }
+
+        BufferedFileWriter writer;
+        writer.getStream()->write(manifest.c_str(), manifest.size());
+        if (writer.commit(fileName))
+        {
+            print("Manifest saved as " + fileName + ".");
+        }
+        else
+        {
+            print("Manifest " + fileName + " unchanged, not written.");
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmDedupeToolFactory.h"
+
+#include "MmDedupeTool.h"
+#include "MmOptionsParser.h"
+
+namespace meshmagick
+{
+
+	DedupeToolFactory::DedupeToolFactory()
+	{
+	}
+
+	DedupeToolFactory::~DedupeToolFactory()
+	{
+	}
+
+	Tool* DedupeToolFactory::createTool()
+	{
+		return new DedupeTool();
+	}
+
+	void DedupeToolFactory::destroyTool(Tool* tool)
+	{
+		delete tool;
+	}
+
+	OptionDefinitionSet DedupeToolFactory::getOptionDefinitions() const
+	{
+		OptionDefinitionSet optionDefs;
+		optionDefs.insert(OptionDefinition("tolerance", OT_REAL, false, false,
+			Ogre::Any(Ogre::Real(1e-4))));
+		optionDefs.insert(OptionDefinition("transform-invariant", OT_BOOL, false, false));
+		optionDefs.insert(OptionDefinition("manifest", OT_STRING, false, false));
+		return optionDefs;
+	}
+
+	Ogre::String DedupeToolFactory::getToolName() const
+	{
+		return "dedupe";
+	}
+
+	Ogre::String DedupeToolFactory::getToolDescription() const
+	{
+		return "Find meshes and submeshes with duplicate geometry.";
+	}
+
+	void DedupeToolFactory::printToolHelp(std::ostream& out) const
+	{
+		out << std::endl;
+		out << "Find meshes and submeshes with identical or nearly identical geometry" << std::endl
+			<< std::endl;
+		out << "Input files may be meshes or directories, which are searched recursively." << std::endl
+			<< "Duplicates are reported in groups, largest waste first. The first member of" << std::endl
+			<< "a group is the one to keep." << std::endl
+			<< "Meshes only count as duplicates, if their submeshes also use the same materials." << std::endl
+			<< std::endl;
+		out << "Options:" << std::endl;
+		out << "   -tolerance=val - Grid size positions are snapped to before comparing them." << std::endl
+			<< "                    Relative to the RMS radius with -transform-invariant. (default 0.0001)" << std::endl;
+		out << "   -transform-invariant - Also find copies, that are rotated or uniformly scaled." << std::endl
+			<< "                    Translated copies are always found." << std::endl;
+		out << "   -manifest=file - Write a tab separated line for each duplicate mesh, naming" << std::endl
+			<< "                    the mesh to use instead and the translation, orientation and" << std::endl
+			<< "                    scale to place it with." << std::endl
+			<< std::endl;
+	}
+}
@@ -23,6 +23,8 @@ THE SOFTWARE.
 
 #include "MmInfoTool.h"
 
+#include "MmBufferedFileWriter.h"
+#include "MmMeshStatistics.h"
 #include "MmMeshUtils.h"
 #include "MmOgreEnvironment.h"
 #include "MmStatefulMeshSerializer.h"
@@ -35,8 +37,12 @@ THE SOFTWARE.
 #include <OgreStringConverter.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <functional>
 #include <map>
+#include <set>
+#include <unordered_set>
 
 using namespace Ogre;
 
@@ -52,7 +58,7 @@ namespace meshmagick
     };
     //------------------------------------------------------------------------
 
-    InfoTool::InfoTool()
+    InfoTool::InfoTool() : mFifoCacheSize(16), mLruCacheSize(16)
     {
     }
     //------------------------------------------------------------------------
@@ -96,33 +102,179 @@ namespace meshmagick
             warn("info tool doesn't write anything. Output files are ignored.");
         }
 
-        for (size_t i = 0, end = inFileNames.size(); i < end; ++i)
+        // In aggregate mode only statistics over all files are printed.
+        const bool aggregate = OptionsUtil::isOptionSet(toolOptions, "aggregate");
+        size_t numTopMeshes = 10;
+        for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
         {
-            if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
+            if (it->first == "top")
             {
-				MeshInfo meshInfo = processMesh(inFileNames[i]);
-				printMeshInfo(toolOptions, meshInfo);
+                numTopMeshes = static_cast<size_t>(std::max(0, any_cast<int>(it->second)));
             }
-            else if (StringUtil::endsWith(inFileNames[i], ".skeleton", true))
+            else if (it->first == "fifo-cache-size")
             {
-				SkeletonInfo skeletonInfo = processSkeleton(inFileNames[i]);
-				printSkeletonInfo(toolOptions, skeletonInfo);
+                mFifoCacheSize = static_cast<size_t>(std::max(1, any_cast<int>(it->second)));
             }
-            else
+            else if (it->first == "lru-cache-size")
             {
-                warn("unrecognised name ending for file " + inFileNames[i]);
+                mLruCacheSize = static_cast<size_t>(std::max(1, any_cast<int>(it->second)));
+            }
+        }
+        MeshStatistics statistics(numTopMeshes);
+
+        const String format = aggregate ? BLANKSTRING
+            : OptionsUtil::getStringOption(toolOptions, "format");
+        const bool json = format == "json" || format == "ndjson";
+        const StringVector fileNames = getInputFileNames(inFileNames);
+
+        if (format == "json")
+        {
+            printRecord("[");
+        }
+        else if (format == "csv")
+        {
+            printCsvHeader(getCsvFields(toolOptions));
+        }
+
+        // Results are printed in the order of the (sorted) input.
+        std::vector<std::vector<unsigned char> > contents(fileNames.size());
+        String pendingRecord;
+        forEachFile(fileNames.size(), [&](size_t i)
+        {
+            ToolUtils::readFile(fileNames[i], contents[i]);
+        },
+        [&](size_t i)
+        {
+            const String& fileName = fileNames[i];
+            DataStreamPtr stream;
+            if (!contents[i].empty())
+            {
+                stream = DataStreamPtr(new MemoryDataStream(fileName,
+                    &contents[i][0], contents[i].size(), false, true));
+            }
+
+            String record;
+            try
+            {
+                if (StringUtil::endsWith(fileName, ".mesh", true))
+                {
+                    MeshInfo meshInfo = processMesh(fileName, stream);
+                    if (aggregate)
+                    {
+                        statistics.addMesh(meshInfo);
+                    }
+                    else if (json)
+                    {
+                        record = getMeshInfoJson(meshInfo);
+                    }
+                    else
+                    {
+                        printMeshInfo(toolOptions, meshInfo);
+                    }
+                }
+                else if (StringUtil::endsWith(fileName, ".skeleton", true))
+                {
+                    SkeletonInfo skeletonInfo = processSkeleton(fileName, stream);
+                    if (aggregate)
+                    {
+                        statistics.addSkeleton(skeletonInfo);
+                    }
+                    else if (json)
+                    {
+                        record = getSkeletonInfoJson(skeletonInfo);
+                    }
+                    else
+                    {
+                        printSkeletonInfo(toolOptions, skeletonInfo);
+                    }
+                }
+                else
+                {
+                    warn("unrecognised name ending for file " + fileName);
+                    warn("file skipped.");
+                }
+            }
+            catch (std::exception& e)
+            {
+                warn(e.what());
+                warn("Unable to process file " + fileName);
                 warn("file skipped.");
             }
+
+            if (!record.empty())
+            {
+                if (format == "ndjson")
+                {
+                    printRecord(record);
+                }
+                else
+                {
+                    // Delay printing by one record, so that we know whether a comma
+                    // is needed.
+                    if (!pendingRecord.empty())
+                    {
+                        printRecord(pendingRecord + ",");
+                    }
+                    pendingRecord = record;
+                }
+            }
+
+            contents[i] = std::vector<unsigned char>();
+        });
+
+        if (format == "json")
+        {
+            if (!pendingRecord.empty())
+            {
+                printRecord(pendingRecord);
+            }
+            printRecord("]");
+        }
+
+        if (aggregate)
+        {
+            StringVector report = statistics.getReport();
+            for (size_t i = 0; i < report.size(); ++i)
+            {
+                print(report[i]);
+            }
         }
     }
     //------------------------------------------------------------------------
 
-	MeshInfo InfoTool::processMesh(const Ogre::String& meshFileName) const
+    StringVector InfoTool::getInputFileNames(const StringVector& inFileNames) const
+    {
+        StringVector patterns;
+        patterns.push_back("*.mesh");
+        patterns.push_back("*.skeleton");
+
+        StringVector fileNames;
+        for (size_t i = 0; i < inFileNames.size(); ++i)
+        {
+            if (ToolUtils::isDirectory(inFileNames[i]))
+            {
+                StringVector found = ToolUtils::findFiles(inFileNames[i], patterns);
+                print("Found " + StringConverter::toString(found.size()) + " files in "
+                    + inFileNames[i], V_HIGH, std::cerr);
+                fileNames.insert(fileNames.end(), found.begin(), found.end());
+            }
+            else
+            {
+                fileNames.push_back(inFileNames[i]);
+            }
+        }
+        return fileNames;
+    }
+    //------------------------------------------------------------------------
+
+	MeshInfo InfoTool::processMesh(const Ogre::String& meshFileName,
+		DataStreamPtr stream) const
 	{
         StatefulMeshSerializer* meshSerializer =
             OgreEnvironment::getSingleton().getMeshSerializer();
 
-        MeshPtr mesh = meshSerializer->loadMesh(meshFileName);
+        MeshPtr mesh = stream ? meshSerializer->loadMesh(meshFileName, stream)
+			: meshSerializer->loadMesh(meshFileName);
 
 		MeshInfo info;
 		info.name = meshFileName;
@@ -136,6 +288,8 @@ namespace meshmagick
 	void InfoTool::processMesh(MeshInfo& info, MeshPtr mesh) const
 	{
 	    info.storedBoundingBox = mesh->getBounds();
+		// Ogre counts the full detail mesh as first level.
+		info.numLodLevels = mesh->getNumLodLevels() - 1;
 		info.actualBoundingBox = MeshUtils::getMeshAabb(mesh);
 
         // Build metadata for bone assignments
@@ -157,11 +311,17 @@ namespace meshmagick
 				mesh->sharedBlendIndexToBoneIndexMap);
             processVertexDeclaration(info.sharedVertices,
 				mesh->sharedVertexData->vertexDeclaration);
+			processVertexBuffers(info.sharedVertices, mesh->sharedVertexData);
 			info.maxNumBoneAssignments =
 				std::max(info.maxNumBoneAssignments, info.sharedVertices.numBoneAssignments);
 			info.maxNumBonesReferenced =
 				std::max(info.maxNumBonesReferenced, info.sharedVertices.numBonesReferenced);
 			info.numVertices += info.sharedVertices.numVertices;
+			for (size_t i = 0; i < info.sharedVertices.buffers.size(); ++i)
+			{
+				info.vertexBufferBytes += info.sharedVertices.buffers[i].numBytes;
+			}
+			info.potentialSavings += getPotentialSavings(info.sharedVertices);
         }
         else
         {
@@ -199,8 +359,60 @@ namespace meshmagick
 			}
 			info.numElements += subMeshInfo.numElements;
 			info.numVertices += subMeshInfo.vertices.numVertices;
+
+			for (size_t j = 0; j < subMeshInfo.vertices.buffers.size(); ++j)
+			{
+				info.vertexBufferBytes += subMeshInfo.vertices.buffers[j].numBytes;
+			}
+			info.indexBufferBytes += subMeshInfo.indexBufferBytes;
+			info.potentialSavings += getPotentialSavings(subMeshInfo.vertices);
+			if (subMeshInfo.indexWidthReducible)
+			{
+				info.potentialSavings += subMeshInfo.indexBufferBytes / 2;
+			}
         }
 
+		// Each submesh references only part of the shared vertices, so their unreferenced
+		// fraction is taken over the index data of all of them, per LOD level.
+		if (mesh->sharedVertexData != NULL)
+		{
+			for (size_t lod = 0; ; ++lod)
+			{
+				std::vector<const IndexData*> indexDatas;
+				for (size_t i = 0; i < info.submeshes.size(); ++i)
+				{
+					const SubMesh* submesh = mesh->getSubMesh(i);
+					if (!submesh->useSharedVertices)
+					{
+						continue;
+					}
+					if (lod == 0)
+					{
+						indexDatas.push_back(submesh->indexData);
+					}
+					else if (lod - 1 < submesh->mLodFaceList.size())
+					{
+						indexDatas.push_back(submesh->mLodFaceList[lod - 1]);
+					}
+				}
+				if (indexDatas.empty())
+				{
+					break;
+				}
+
+				const Real unreferenced =
+					MeshUtils::getUnreferencedVertices(mesh->sharedVertexData, indexDatas);
+				for (size_t i = 0; i < info.submeshes.size(); ++i)
+				{
+					SubMeshInfo& subMeshInfo = info.submeshes[i];
+					if (subMeshInfo.usesSharedVertices && lod < subMeshInfo.vertexCache.size())
+					{
+						subMeshInfo.vertexCache[lod].unreferencedVertices = unreferenced;
+					}
+				}
+			}
+		}
+
         // Animation detection
 
         // Morph animations ?
@@ -254,6 +466,7 @@ namespace meshmagick
 			info.vertices.numVertices = submesh->vertexData->vertexCount;
 			processBoneAssignmentData(info.vertices, submesh->vertexData, submesh->blendIndexToBoneIndexMap);
             processVertexDeclaration(info.vertices, submesh->vertexData->vertexDeclaration);
+			processVertexBuffers(info.vertices, submesh->vertexData);
         }
 
         // indices
@@ -270,6 +483,7 @@ namespace meshmagick
             }
 
 			size_t numIndices = indexBuffer->getNumIndexes();
+			info.numIndices = numIndices;
 			switch(submesh->operationType)
 			{
 			case RenderOperation::OT_LINE_LIST:
@@ -303,11 +517,58 @@ namespace meshmagick
 				info.elementType = "triangles";
 				break;
 			}
+
+			// Vertex cache efficiency of the full detail level and all generated LODs.
+			if (info.elementType == "triangles")
+			{
+				const VertexData* vd = submesh->useSharedVertices
+					? submesh->parent->sharedVertexData : submesh->vertexData;
+				info.vertexCache.push_back(MeshUtils::getVertexCacheMetrics(vd,
+					submesh->indexData, submesh->operationType,
+					mFifoCacheSize, mLruCacheSize));
+				for (size_t i = 0; i < submesh->mLodFaceList.size(); ++i)
+				{
+					info.vertexCache.push_back(MeshUtils::getVertexCacheMetrics(vd,
+						submesh->mLodFaceList[i], submesh->operationType,
+						mFifoCacheSize, mLruCacheSize));
+				}
+			}
+
+			// Index memory. LOD levels may share their buffer with the full detail level,
+			// so each buffer is only counted once.
+			std::vector<const IndexData*> indexDatas(1, submesh->indexData);
+			indexDatas.insert(indexDatas.end(),
+				submesh->mLodFaceList.begin(), submesh->mLodFaceList.end());
+			std::set<const HardwareIndexBuffer*> countedBuffers;
+			uint32 maxIndex = 0;
+			for (size_t i = 0; i < indexDatas.size(); ++i)
+			{
+				const IndexData* id = indexDatas[i];
+				if (id == NULL || !id->indexBuffer)
+				{
+					continue;
+				}
+				if (countedBuffers.insert(id->indexBuffer.get()).second)
+				{
+					info.indexBufferBytes += id->indexBuffer->getSizeInBytes();
+				}
+				if (info.indexBitWidth == 32)
+				{
+					std::vector<uint32> indices = MeshUtils::getIndices(id);
+					if (!indices.empty())
+					{
+						maxIndex = std::max(maxIndex,
+							*std::max_element(indices.begin(), indices.end()));
+					}
+				}
+			}
+			info.indexWidthReducible = info.indexBitWidth == 32 && maxIndex <= 0xFFFF;
         }
     }
     //------------------------------------------------------------------------
 
-    SkeletonInfo InfoTool::processSkeleton(const String& skeletonFileName) const
+    SkeletonInfo InfoTool::processSkeleton(const String& skeletonFileName,
+		DataStreamPtr stream) const
 	{
 		SkeletonInfo info;
 
@@ -317,7 +578,8 @@ namespace meshmagick
         SkeletonPtr skeleton;
         try
         {
-            skeleton = skeletonSerializer->loadSkeleton(skeletonFileName);
+            skeleton = stream ? skeletonSerializer->loadSkeleton(skeletonFileName, stream)
+				: skeletonSerializer->loadSkeleton(skeletonFileName);
         }
         catch(std::exception& e)
         {
@@ -389,126 +651,143 @@ namespace meshmagick
 	}
     //------------------------------------------------------------------------
 
-	/// @todo externalise this function, when reorganise-tool is integrated,
-    /// because both use the same format
     void InfoTool::processVertexDeclaration(VertexInfo& info, const VertexDeclaration* vd) const
     {
-        // First: source-ID, second: offset
-        typedef std::pair<unsigned short, size_t> ElementPosition;
-        typedef std::pair<VertexElementSemantic, VertexElementType> Element;
-        typedef std::map<ElementPosition, Element> ElementMap;
-
-        // This map holds the results from iterating all elements in the declaration.
-        // Having them stored in the map makes it easy to create the layout string.
-        ElementMap elements;
-
-        // Iterate over declaration elements and put them into the map.
-        // We do this, because we don't know in what order the elements are stored, but
-        // in order to create the layout string we need them in order of their source and offset.
-        const VertexDeclaration::VertexElementList& elementList = vd->getElements();
-        for (VertexDeclaration::VertexElementList::const_iterator it = elementList.begin(),
-            end = elementList.end(); it != end; ++it)
-        {
-            elements[std::make_pair((*it).getSource(), (*it).getOffset())] =
-                std::make_pair((*it).getSemantic(), (*it).getType());
-        }
+		info.layout = MeshUtils::getVertexLayoutString(vd);
+		const VertexDeclaration::VertexElementList& elementList = vd->getElements();
 
-        // Create the layout string
-        String layout;
-        unsigned short source = 0;
-        for (ElementMap::const_iterator it = elements.begin(), end = elements.end();
-            it != end; ++it)
-        {
-            // If source changed, we append a hyphen to indicate a new buffer.
-            if (it->first.first != source)
-            {
-                layout += '-';
-                source = it->first.first;
-            }
+		info.bytesPerVertex = 0;
+		for (unsigned short i = 0, end = vd->getMaxSource(); i <= end && !elementList.empty(); ++i)
+		{
+			info.bytesPerVertex += vd->getVertexSize(i);
+		}
+    }
+    //------------------------------------------------------------------------
 
-            // Append char indicating the element semantic
-            switch (it->second.first)
-            {
-            case VES_POSITION:
-                layout += "p";
-                break;
-            case VES_BLEND_WEIGHTS:
-                layout += "w";
-                break;
-            case VES_BLEND_INDICES:
-                layout += "i";
-                break;
-            case VES_NORMAL:
-                layout += "n";
-                break;
-            case VES_DIFFUSE:
-                layout += "d";
-                break;
-            case VES_SPECULAR:
-                layout += "s";
-                break;
-            case VES_TEXTURE_COORDINATES:
-                layout += "u";
-                break;
-            case VES_BINORMAL:
-                layout += "b";
-                break;
-            case VES_TANGENT:
-                layout += "t";
-                break;
-            }
-            // Append substring indicating the element type
-            switch (it->second.second)
-            {
-            case VET_FLOAT1:
-                layout += "(f1)";
-                break;
-            case VET_FLOAT2:
-                layout += "(f2)";
-                break;
-            case VET_FLOAT3:
-                layout += "(f3)";
-                break;
-            case VET_FLOAT4:
-                layout += "(f4)";
-                break;
-            case VET_SHORT1:
-                layout += "(s1)";
-                break;
-            case VET_SHORT2:
-                layout += "(s2)";
-                break;
-            case VET_SHORT3:
-                layout += "(s3)";
-                break;
-            case VET_SHORT4:
-                layout += "(s4)";
-                break;
-            case VET_UBYTE4:
-                layout += "(u4)";
-                break;
-#if OGRE_VERSION_MAJOR < 3
-            case VET_COLOUR_ARGB:
-                layout += "(bgra)";
-                break;
-            case VET_COLOUR_ABGR:
-                layout += "(rgba)";
-                break;
-			case VET_COLOUR:
-				// Doesn't appear at runtime, so don't handle
-				break;
-#endif
-            }
-        }
+	void InfoTool::processVertexBuffers(VertexInfo& info, const VertexData* vd) const
+	{
+		const VertexDeclaration* decl = vd->vertexDeclaration;
+		const VertexBufferBinding::VertexBufferBindingMap& bindings =
+			vd->vertexBufferBinding->getBindings();
+
+		// A binormal can be derived from normal and tangent, if the tangent carries
+		// the handedness in its fourth component.
+		bool hasTangentWithHandedness = false;
+		const VertexDeclaration::VertexElementList& elementList = decl->getElements();
+		for (VertexDeclaration::VertexElementList::const_iterator it = elementList.begin();
+			it != elementList.end(); ++it)
+		{
+			if (it->getSemantic() == VES_TANGENT
+				&& VertexElement::getTypeCount(it->getType()) == 4)
+			{
+				hasTangentWithHandedness = true;
+			}
+		}
 
-		info.layout = layout;
-    }
+		std::vector<std::pair<HardwareVertexBuffer*, const unsigned char*> > lockedBuffers;
+		for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+			it != bindings.end(); ++it)
+		{
+			VertexBufferInfo buffer;
+			buffer.source = it->first;
+			buffer.numBytes = it->second->getSizeInBytes();
+			buffer.vertexSize = it->second->getVertexSize();
+
+			const unsigned char* data = static_cast<const unsigned char*>(
+				it->second->lock(HardwareBuffer::HBL_READ_ONLY))
+				+ vd->vertexStart * buffer.vertexSize;
+			lockedBuffers.push_back(std::make_pair(it->second.get(), data));
+
+			VertexDeclaration::VertexElementList elements = decl->findElementsBySource(it->first);
+			size_t usedBytes = 0;
+			for (VertexDeclaration::VertexElementList::const_iterator elemIt = elements.begin();
+				elemIt != elements.end(); ++elemIt)
+			{
+				const size_t elementSize = elemIt->getSize();
+				usedBytes += elementSize;
+
+				String reason;
+				if (elemIt->getSemantic() == VES_BINORMAL && hasTangentWithHandedness)
+				{
+					reason = "redundant";
+				}
+				else if (vd->vertexCount > 1)
+				{
+					// Compare all vertices against the first one.
+					const unsigned char* first = data + elemIt->getOffset();
+					bool constant = true;
+					for (size_t v = 1; v < vd->vertexCount && constant; ++v)
+					{
+						constant = memcmp(first, first + v * buffer.vertexSize, elementSize) == 0;
+					}
+					if (constant)
+					{
+						reason = std::count(first, first + elementSize, 0)
+							== static_cast<std::ptrdiff_t>(elementSize) ? "zero" : "constant";
+					}
+				}
+
+				if (!reason.empty())
+				{
+					buffer.unusedElements.push_back(MeshUtils::getElementLayoutString(
+						elemIt->getSemantic(), elemIt->getType()) + " (" + reason + ")");
+					buffer.unusedBytes += elementSize;
+				}
+			}
+			buffer.padding = buffer.vertexSize > usedBytes ? buffer.vertexSize - usedBytes : 0;
+
+			info.buffers.push_back(buffer);
+		}
+
+		// Vertices, that are identical in all buffers, could share one index.
+		std::unordered_set<uint64> vertexHashes;
+		info.numDuplicateVertices = 0;
+		for (size_t v = 0; v < vd->vertexCount; ++v)
+		{
+			uint64 hash = BufferedFileWriter::FNV_OFFSET_BASIS;
+			for (size_t i = 0; i < lockedBuffers.size(); ++i)
+			{
+				const size_t vertexSize = lockedBuffers[i].first->getVertexSize();
+				hash = BufferedFileWriter::getHash(lockedBuffers[i].second + v * vertexSize,
+					vertexSize, hash);
+			}
+			if (!vertexHashes.insert(hash).second)
+			{
+				++info.numDuplicateVertices;
+			}
+		}
+
+		for (size_t i = 0; i < lockedBuffers.size(); ++i)
+		{
+			lockedBuffers[i].first->unlock();
+		}
+	}
+    //------------------------------------------------------------------------
+
+	size_t InfoTool::getPotentialSavings(const VertexInfo& info) const
+	{
+		size_t wastePerVertex = 0;
+		for (size_t i = 0; i < info.buffers.size(); ++i)
+		{
+			wastePerVertex += info.buffers[i].padding + info.buffers[i].unusedBytes;
+		}
+		wastePerVertex = std::min(wastePerVertex, info.bytesPerVertex);
+
+		// Duplicates are counted with their size after waste removal,
+		// so that no byte is counted twice.
+		return info.numVertices * wastePerVertex
+			+ info.numDuplicateVertices * (info.bytesPerVertex - wastePerVertex);
+	}
     //------------------------------------------------------------------------
 
 	void InfoTool::printMeshInfo(const OptionList& toolOptions, const MeshInfo& info) const
 	{
 		const String list = OptionsUtil::getStringOption(toolOptions, "list");
-		if (list == Ogre::BLANKSTRING)
+		if (OptionsUtil::getStringOption(toolOptions, "format") == "csv")
+		{
+			listMeshInfo(getCsvFields(toolOptions), ',', info, true);
+		}
+		else if (list == Ogre::BLANKSTRING)
 		{
 			reportMeshInfo(info);
 		}
@@ -525,7 +804,11 @@ namespace meshmagick
 	void InfoTool::printSkeletonInfo(const OptionList& toolOptions, const SkeletonInfo& info) const
 	{
 		const String list = OptionsUtil::getStringOption(toolOptions, "list");
-		if (list == Ogre::BLANKSTRING)
+		if (OptionsUtil::getStringOption(toolOptions, "format") == "csv")
+		{
+			listSkeletonInfo(getCsvFields(toolOptions), ',', info, true);
+		}
+		else if (list == Ogre::BLANKSTRING)
 		{
 			reportSkeletonInfo(info);
 		}
@@ -539,6 +822,263 @@ namespace meshmagick
 	}
     //------------------------------------------------------------------------
 
+	void InfoTool::printRecord(const Ogre::String& record) const
+	{
+		std::cout << record << std::endl;
+	}
+    //------------------------------------------------------------------------
+
+	StringVector InfoTool::getCsvFields(const OptionList& toolOptions) const
+	{
+		const String list = OptionsUtil::getStringOption(toolOptions, "list");
+		if (!list.empty())
+		{
+			return StringUtil::split(list, "/");
+		}
+
+		// All mesh level fields
+		StringVector fields;
+		fields.push_back("name");
+		fields.push_back("version");
+		fields.push_back("endian");
+		fields.push_back("stored_bounding_box");
+		fields.push_back("actual_bounding_box");
+		fields.push_back("shared_vertices");
+		fields.push_back("shared_vertex_count");
+		fields.push_back("shared_vertex_layout");
+		fields.push_back("submesh_count");
+		fields.push_back("max_bone_assignments");
+		fields.push_back("max_bone_references");
+		fields.push_back("total_vertex_count");
+		fields.push_back("total_element_count");
+		fields.push_back("total_triangle_count");
+		fields.push_back("total_line_count");
+		fields.push_back("total_point_count");
+		fields.push_back("morph_animation_count");
+		fields.push_back("pose_count");
+		fields.push_back("edge_list");
+		fields.push_back("lod_level_count");
+		fields.push_back("skeleton");
+		fields.push_back("skeleton_name");
+		fields.push_back("skeleton_bone_count");
+		fields.push_back("skeleton_animation_count");
+		return fields;
+	}
+    //------------------------------------------------------------------------
+
+	void InfoTool::printCsvHeader(const Ogre::StringVector& fields) const
+	{
+		String out;
+		for (size_t i = 0; i < fields.size(); ++i)
+		{
+			out += getCsvString(fields[i]);
+			if (i < fields.size() - 1) out += ',';
+		}
+		printRecord(out);
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getCsvString(const Ogre::String& value) const
+	{
+		// RFC 4180: quote fields containing delimiters, quotes or line breaks.
+		if (value.find_first_of(",\"\r\n") == String::npos)
+		{
+			return value;
+		}
+
+		String rval = "\"";
+		for (size_t i = 0; i < value.size(); ++i)
+		{
+			if (value[i] == '"')
+			{
+				rval += '"';
+			}
+			rval += value[i];
+		}
+		rval += '"';
+		return rval;
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getMeshInfoJson(const MeshInfo& info) const
+	{
+		String out = "{";
+		out += "\"type\":\"mesh\"";
+		out += ",\"name\":" + ToolUtils::getJsonString(info.name);
+		out += ",\"version\":" + ToolUtils::getJsonString(info.version);
+		out += ",\"endian\":" + ToolUtils::getJsonString(info.endian);
+		out += ",\"stored_bounding_box\":" + getJsonAabb(info.storedBoundingBox);
+		out += ",\"actual_bounding_box\":" + getJsonAabb(info.actualBoundingBox);
+		out += ",\"edge_list\":" + getJsonBool(info.hasEdgeList);
+		out += ",\"lod_level_count\":" + StringConverter::toString(info.numLodLevels);
+
+		out += ",\"shared_vertices\":";
+		out += info.hasSharedVertices ? getVertexInfoJson(info.sharedVertices) : "null";
+
+		out += ",\"submeshes\":[";
+		for (size_t i = 0; i < info.submeshes.size(); ++i)
+		{
+			const SubMeshInfo& submesh = info.submeshes[i];
+			if (i > 0) out += ",";
+			out += "{\"index\":" + StringConverter::toString(i);
+			out += ",\"name\":" + ToolUtils::getJsonString(submesh.name);
+			out += ",\"material\":" + ToolUtils::getJsonString(submesh.materialName);
+			out += ",\"use_shared_vertices\":" + getJsonBool(submesh.usesSharedVertices);
+			out += ",\"vertices\":";
+			out += submesh.usesSharedVertices ? "null" : getVertexInfoJson(submesh.vertices);
+			out += ",\"operation_type\":" + ToolUtils::getJsonString(submesh.operationType);
+			out += ",\"element_type\":" + ToolUtils::getJsonString(submesh.elementType);
+			out += ",\"element_count\":" + StringConverter::toString(submesh.numElements);
+			out += ",\"index_count\":" + StringConverter::toString(submesh.numIndices);
+			out += ",\"index_width\":" + StringConverter::toString(submesh.indexBitWidth);
+			out += ",\"index_buffer_bytes\":" + StringConverter::toString(submesh.indexBufferBytes);
+			out += ",\"index_width_reducible\":" + getJsonBool(submesh.indexWidthReducible);
+			out += ",\"vertex_cache\":[";
+			for (size_t lod = 0; lod < submesh.vertexCache.size(); ++lod)
+			{
+				const VertexCacheMetrics& cache = submesh.vertexCache[lod];
+				if (lod > 0) out += ",";
+				out += "{\"lod_index\":" + StringConverter::toString(lod);
+				out += ",\"fifo_acmr\":" + getJsonNumber(cache.fifoAcmr);
+				out += ",\"fifo_atvr\":" + getJsonNumber(cache.fifoAtvr);
+				out += ",\"lru_acmr\":" + getJsonNumber(cache.lruAcmr);
+				out += ",\"lru_atvr\":" + getJsonNumber(cache.lruAtvr);
+				out += ",\"overfetch\":" + getJsonNumber(cache.overfetch);
+				out += ",\"unreferenced_vertices\":" + getJsonNumber(cache.unreferencedVertices);
+				out += "}";
+			}
+			out += "]";
+			out += "}";
+		}
+		out += "]";
+
+		out += ",\"max_bone_assignments\":" + StringConverter::toString(info.maxNumBoneAssignments);
+		out += ",\"max_bone_references\":" + StringConverter::toString(info.maxNumBonesReferenced);
+		out += ",\"total_vertex_count\":" + StringConverter::toString(info.numVertices);
+		out += ",\"total_element_count\":" + StringConverter::toString(info.numElements);
+		out += ",\"total_triangle_count\":" + StringConverter::toString(info.numTrianlges);
+		out += ",\"total_line_count\":" + StringConverter::toString(info.numLines);
+		out += ",\"total_point_count\":" + StringConverter::toString(info.numPoints);
+		out += ",\"vertex_buffer_bytes\":" + StringConverter::toString(info.vertexBufferBytes);
+		out += ",\"index_buffer_bytes\":" + StringConverter::toString(info.indexBufferBytes);
+		out += ",\"potential_savings\":" + StringConverter::toString(info.potentialSavings);
+
+		out += ",\"morph_animations\":" + getJsonAnimationList(info.morphAnimations);
+		out += ",\"poses\":[";
+		for (size_t i = 0; i < info.poseNames.size(); ++i)
+		{
+			if (i > 0) out += ",";
+			out += ToolUtils::getJsonString(info.poseNames[i]);
+		}
+		out += "]";
+
+		out += ",\"skeleton_name\":";
+		out += info.hasSkeleton ? ToolUtils::getJsonString(info.skeletonName) : "null";
+		out += ",\"skeleton\":";
+		out += info.skeletonValid ? getSkeletonInfoJson(info.skeleton) : "null";
+		out += "}";
+		return out;
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getSkeletonInfoJson(const SkeletonInfo& info) const
+	{
+		String out = "{";
+		out += "\"type\":\"skeleton\"";
+		out += ",\"name\":" + ToolUtils::getJsonString(info.name);
+		out += ",\"bones\":[";
+		for (size_t i = 0; i < info.boneNames.size(); ++i)
+		{
+			if (i > 0) out += ",";
+			out += ToolUtils::getJsonString(info.boneNames[i]);
+		}
+		out += "]";
+		out += ",\"animations\":" + getJsonAnimationList(info.animations);
+		out += "}";
+		return out;
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getVertexInfoJson(const VertexInfo& info) const
+	{
+		String out = "{";
+		out += "\"vertex_count\":" + StringConverter::toString(info.numVertices);
+		out += ",\"bone_assignment_count\":" + StringConverter::toString(info.numBoneAssignments);
+		out += ",\"bone_references_count\":" + StringConverter::toString(info.numBonesReferenced);
+		out += ",\"layout\":" + ToolUtils::getJsonString(info.layout);
+		out += ",\"bytes_per_vertex\":" + StringConverter::toString(info.bytesPerVertex);
+		out += ",\"buffers\":[";
+		for (size_t i = 0; i < info.buffers.size(); ++i)
+		{
+			const VertexBufferInfo& buffer = info.buffers[i];
+			if (i > 0) out += ",";
+			out += "{\"source\":" + StringConverter::toString(buffer.source);
+			out += ",\"bytes\":" + StringConverter::toString(buffer.numBytes);
+			out += ",\"vertex_size\":" + StringConverter::toString(buffer.vertexSize);
+			out += ",\"padding\":" + StringConverter::toString(buffer.padding);
+			out += ",\"unused_elements\":[";
+			for (size_t j = 0; j < buffer.unusedElements.size(); ++j)
+			{
+				if (j > 0) out += ",";
+				out += ToolUtils::getJsonString(buffer.unusedElements[j]);
+			}
+			out += "]";
+			out += ",\"unused_bytes\":" + StringConverter::toString(buffer.unusedBytes);
+			out += "}";
+		}
+		out += "]";
+		out += ",\"duplicate_vertex_count\":" + StringConverter::toString(info.numDuplicateVertices);
+		out += "}";
+		return out;
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getJsonAnimationList(
+		const std::vector<std::pair<Ogre::String, Ogre::Real> >& animations) const
+	{
+		String out = "[";
+		for (size_t i = 0; i < animations.size(); ++i)
+		{
+			if (i > 0) out += ",";
+			out += "{\"name\":" + ToolUtils::getJsonString(animations[i].first)
+				+ ",\"length\":" + getJsonNumber(animations[i].second) + "}";
+		}
+		out += "]";
+		return out;
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getJsonAabb(const Ogre::AxisAlignedBox& box) const
+	{
+		if (!box.isFinite())
+		{
+			return "null";
+		}
+		const Vector3& min = box.getMinimum();
+		const Vector3& max = box.getMaximum();
+		return "{\"min\":[" + getJsonNumber(min.x) + "," + getJsonNumber(min.y) + ","
+			+ getJsonNumber(min.z) + "],\"max\":[" + getJsonNumber(max.x) + ","
+			+ getJsonNumber(max.y) + "," + getJsonNumber(max.z) + "]}";
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getJsonNumber(Ogre::Real value) const
+	{
+		// JSON has no representation for NaN and infinity.
+		if (!std::isfinite(value))
+		{
+			return "null";
+		}
+		return StringConverter::toString(value, 9);
+	}
+    //------------------------------------------------------------------------
+
+	String InfoTool::getJsonBool(bool value) const
+	{
+		return value ? "true" : "false";
+	}
+    //------------------------------------------------------------------------
+
 	void InfoTool::reportMeshInfo(const MeshInfo& meshInfo) const
 	{
 		// total amount counters
@@ -584,6 +1124,7 @@ namespace meshmagick
 				+ StringConverter::toString(meshInfo.sharedVertices.numBoneAssignments)
 				+ " bone assignments per vertex.");
 			print(indent + "Buffer layout: " + meshInfo.sharedVertices.layout);
+			reportVertexBuffers(meshInfo.sharedVertices, indent);
 
 			numVertices += meshInfo.sharedVertices.numVertices;
 		}
@@ -616,6 +1157,7 @@ namespace meshmagick
 				print(indent + StringConverter::toString(info.vertices.numBoneAssignments)
 					+ " bone assignments per vertex.");
 				print(indent + "Buffer layout: " + info.vertices.layout);
+				reportVertexBuffers(info.vertices, indent);
 
 				numVertices += info.vertices.numVertices;
 			}
@@ -624,6 +1166,23 @@ namespace meshmagick
 			print(indent + StringConverter::toString(info.numElements)
 				+ " " + info.elementType);
 			print(indent + StringConverter::toString(info.indexBitWidth) + " bit index width");
+			print(indent + "Index buffer: " + StringConverter::toString(info.indexBufferBytes)
+				+ " bytes" + (info.indexWidthReducible ? ", fits into 16 bit indices" : ""));
+			for (size_t lod = 0; lod < info.vertexCache.size(); ++lod)
+			{
+				const VertexCacheMetrics& cache = info.vertexCache[lod];
+				print(indent + (lod == 0 ? String("Vertex cache") : "LOD "
+					+ StringConverter::toString(lod))
+					+ ": ACMR " + StringConverter::toString(cache.fifoAcmr, 3)
+					+ " / " + StringConverter::toString(cache.lruAcmr, 3)
+					+ ", ATVR " + StringConverter::toString(cache.fifoAtvr, 3)
+					+ " / " + StringConverter::toString(cache.lruAtvr, 3)
+					+ " (FIFO " + StringConverter::toString(mFifoCacheSize)
+					+ " / LRU " + StringConverter::toString(mLruCacheSize) + ")"
+					+ ", overfetch " + StringConverter::toString(cache.overfetch, 3)
+					+ ", " + StringConverter::toString(cache.unreferencedVertices * 100, 3)
+					+ "% vertices unreferenced");
+			}
 
 			// Discriminate element type for total element counts
 			if (info.elementType == "triangles")
@@ -655,6 +1214,14 @@ namespace meshmagick
 		{
 			print(StringConverter::toString(numPoints) + " points in total.");
 		}
+		print(StringConverter::toString(meshInfo.vertexBufferBytes) + " bytes vertex data, "
+			+ StringConverter::toString(meshInfo.indexBufferBytes) + " bytes index data.");
+		if (meshInfo.potentialSavings > 0)
+		{
+			print(StringConverter::toString(meshInfo.potentialSavings)
+				+ " bytes could be saved by removing padding, unused elements and "
+				"duplicate vertices and by using 16 bit indices.");
+		}
 		print("");
 
 		// Other mesh properties
@@ -728,6 +1295,37 @@ namespace meshmagick
 	}
     //------------------------------------------------------------------------
 
+	void InfoTool::reportVertexBuffers(const VertexInfo& info, const String& indent) const
+	{
+		for (size_t i = 0; i < info.buffers.size(); ++i)
+		{
+			const VertexBufferInfo& buffer = info.buffers[i];
+			String line = indent + "Buffer " + StringConverter::toString(buffer.source)
+				+ ": " + StringConverter::toString(buffer.numBytes) + " bytes, "
+				+ StringConverter::toString(buffer.vertexSize) + " bytes per vertex";
+			if (buffer.padding > 0)
+			{
+				line += ", " + StringConverter::toString(buffer.padding) + " bytes padding";
+			}
+			print(line);
+			if (!buffer.unusedElements.empty())
+			{
+				String elements;
+				for (size_t j = 0; j < buffer.unusedElements.size(); ++j)
+				{
+					elements += (j > 0 ? ", " : "") + buffer.unusedElements[j];
+				}
+				print(indent + indent + "unused elements: " + elements);
+			}
+		}
+		if (info.numDuplicateVertices > 0)
+		{
+			print(indent + StringConverter::toString(info.numDuplicateVertices)
+				+ " duplicate vertices.");
+		}
+	}
+    //------------------------------------------------------------------------
+
 	void InfoTool::reportSkeletonInfo(const SkeletonInfo& info) const
 	{
 		const String& indent = "    ";
@@ -751,7 +1349,7 @@ namespace meshmagick
     //------------------------------------------------------------------------
 
 	void InfoTool::listMeshInfo(const Ogre::StringVector& listFields, char delim,
-		const MeshInfo& info) const
+		const MeshInfo& info, bool csv) const
 	{
 		// First determine whether there are submesh level infos asked about.
 		StringVector submeshLevelFields;
@@ -765,254 +1363,359 @@ namespace meshmagick
 		submeshLevelFields.push_back("submesh_vertex_layout");
 		submeshLevelFields.push_back("submesh_operation_type");
 		submeshLevelFields.push_back("submesh_element_count");
+		submeshLevelFields.push_back("submesh_triangle_count");
+		submeshLevelFields.push_back("submesh_line_count");
+		submeshLevelFields.push_back("submesh_point_count");
 		submeshLevelFields.push_back("submesh_index_width");
+		submeshLevelFields.push_back("submesh_fifo_acmr");
+		submeshLevelFields.push_back("submesh_fifo_atvr");
+		submeshLevelFields.push_back("submesh_lru_acmr");
+		submeshLevelFields.push_back("submesh_lru_atvr");
+		submeshLevelFields.push_back("submesh_overfetch");
+		submeshLevelFields.push_back("submesh_unreferenced_vertices");
+		submeshLevelFields.push_back("lod_index");
 		bool submeshLevel = std::find_first_of(listFields.begin(), listFields.end(),
 			submeshLevelFields.begin(), submeshLevelFields.end()) != listFields.end();
+		// With lod_index, vertex cache fields are printed for every LOD level.
+		bool lodLevel = std::find(listFields.begin(), listFields.end(), "lod_index")
+			!= listFields.end();
 		if (submeshLevel)
 		{
 			for (size_t i = 0; i < info.submeshes.size(); ++i)
 			{
-				printMeshInfoList(listFields, delim, info, i);
+				const size_t numLods = lodLevel
+					? std::max<size_t>(1, info.submeshes[i].vertexCache.size()) : 1;
+				for (size_t lod = 0; lod < numLods; ++lod)
+				{
+					printMeshInfoList(listFields, delim, info, i, lod, csv);
+				}
 			}
 		}
 		else
 		{
-			printMeshInfoList(listFields, delim, info, -1);
+			printMeshInfoList(listFields, delim, info, -1, 0, csv);
 		}
 	}
     //------------------------------------------------------------------------
 
 	void InfoTool::printMeshInfoList(const Ogre::StringVector& listFields, char delim,
-		const MeshInfo& info, size_t submeshIndex) const
+		const MeshInfo& info, size_t submeshIndex, size_t lodIndex, bool csv) const
 	{
 		String out;
 
 		for (size_t i = 0; i < listFields.size(); ++i)
 		{
-			const String field = listFields[i];
-			if (field == "name")
-			{
-				out += info.name;
-			}
-			else if (field == "version")
-			{
-				out += info.version;
-			}
-			else if (field == "endian")
-			{
-				out += info.endian;
-			}
-			else if (field == "stored_bounding_box")
-			{
-				out += ToolUtils::getPrettyAabbString(info.storedBoundingBox);
-			}
-			else if (field == "actual_bounding_box")
-			{
-				out += ToolUtils::getPrettyAabbString(info.actualBoundingBox);
-			}
-			else if (field == "stored_mesh_extent")
-			{
-				out += ToolUtils::getPrettyVectorString(info.storedBoundingBox.getSize());
-			}
-			else if (field == "actual_mesh_extent")
-			{
-				out += ToolUtils::getPrettyVectorString(info.actualBoundingBox.getSize());
-			}
-			else if (field == "edge_list")
-			{
-				out += info.hasEdgeList ? "yes" : "no";
-			}
-			else if (field == "lod_level_count")
-			{
-				out += StringConverter::toString(info.numLodLevels);
-			}
-			else if (field == "shared_vertices")
-			{
-				out += info.hasSharedVertices ? "yes" : "no";
-			}
-			else if (field == "shared_vertex_count" && info.hasSharedVertices)
-			{
-				out += StringConverter::toString(info.sharedVertices.numVertices);
-			}
-			else if (field == "shared_bone_assignment_count" && info.hasSharedVertices)
-			{
-				out += StringConverter::toString(info.sharedVertices.numBoneAssignments);
-			}
-			else if (field == "shared_bone_references_count" && info.hasSharedVertices)
-			{
-				out += StringConverter::toString(info.sharedVertices.numBonesReferenced);
-			}
-			else if (field == "shared_vertex_layout" && info.hasSharedVertices)
-			{
-				out += info.sharedVertices.layout;
-			}
-			else if (field == "submesh_count")
-			{
-				out += StringConverter::toString(info.submeshes.size());
-			}
-			else if (field == "submesh_index")
-			{
-				out += StringConverter::toString(submeshIndex);
-			}
-			else if (field == "submesh_name")
-			{
-				out += info.submeshes[submeshIndex].name;
-			}
-			else if (field == "submesh_material")
-			{
-				out += info.submeshes[submeshIndex].materialName;
-			}
-			else if (field == "submesh_use_shared_vertices")
-			{
-				out += info.submeshes[submeshIndex].usesSharedVertices ? "yes" : "no";
-			}
-			else if (field == "submesh_vertex_count")
-			{
-				out += StringConverter::toString(
-					info.submeshes[submeshIndex].vertices.numVertices);
-			}
-			else if (field == "submesh_bone_assignment_count")
-			{
-				out += StringConverter::toString(
-					info.submeshes[submeshIndex].vertices.numBoneAssignments);
-			}
-			else if (field == "submesh_bone_references_count")
-			{
-				out += StringConverter::toString(
-					info.submeshes[submeshIndex].vertices.numBonesReferenced);
-			}
-			else if (field == "submesh_vertex_layout")
-			{
-				out += info.submeshes[submeshIndex].vertices.layout;
-			}
-			else if (field == "submesh_operation_type")
-			{
-				out += info.submeshes[submeshIndex].operationType;
-			}
-			else if (field == "submesh_element_count")
-			{
-				out += StringConverter::toString(info.submeshes[submeshIndex].numElements);
-			}
-			else if (field == "submesh_triangle_count")
-			{
-				if (info.submeshes[submeshIndex].elementType == "triangles")
-				{
-					out += StringConverter::toString(info.submeshes[submeshIndex].numElements);
-				}
-				else
-				{
-					out += "0";
-				}
-			}
-			else if (field == "submesh_line_count")
-			{
-				if (info.submeshes[submeshIndex].elementType == "lines")
-				{
-					out += StringConverter::toString(info.submeshes[submeshIndex].numElements);
-				}
-				else
-				{
-					out += "0";
-				}
-			}
-			else if (field == "submesh_point_count")
-			{
-				if (info.submeshes[submeshIndex].elementType == "points")
-				{
-					out += StringConverter::toString(info.submeshes[submeshIndex].numElements);
-				}
-				else
-				{
-					out += "0";
-				}
-			}
-			else if (field == "submesh_index_width")
-			{
-				out += StringConverter::toString(info.submeshes[submeshIndex].indexBitWidth);
-			}
-			else if (field == "morph_animation_count")
-			{
-				out += StringConverter::toString(info.morphAnimations.size());
-			}
-			else if (field == "pose_count")
-			{
-				out += StringConverter::toString(info.poseNames.size());
-			}
-			else if (field == "max_bone_assignments")
-			{
-				out += StringConverter::toString(info.maxNumBoneAssignments);
-			}
-			else if (field == "max_bone_references")
+			String value;
+			if (csv)
 			{
-				out += StringConverter::toString(info.maxNumBonesReferenced);
+				// Keep columns aligned with the header, fields not available stay empty.
+				getMeshInfoField(listFields[i], info, submeshIndex, lodIndex, value);
+				out += getCsvString(value);
 			}
-			else if (field == "total_vertex_count")
+			else if (getMeshInfoField(listFields[i], info, submeshIndex, lodIndex, value))
 			{
-				out += StringConverter::toString(info.numVertices);
+				out += value;
 			}
-			else if (field == "total_element_count")
-			{
-				out += StringConverter::toString(info.numElements);
-			}
-			else if (field == "total_triangle_count")
-			{
-				out += StringConverter::toString(info.numTrianlges);
-			}
-			else if (field == "total_line_count")
+			else
 			{
-				out += StringConverter::toString(info.numLines);
+				continue;
 			}
-			else if (field == "total_point_count")
+
+			if (i < listFields.size() - 1) out += delim;
+		}
+
+		if (csv)
+		{
+			printRecord(out);
+		}
+		else
+		{
+			print(out);
+		}
+	}
+    //------------------------------------------------------------------------
+
+	bool InfoTool::getMeshInfoField(const Ogre::String& field, const MeshInfo& info,
+		size_t submeshIndex, size_t lodIndex, Ogre::String& value) const
+	{
+		const bool submeshValid = submeshIndex < info.submeshes.size();
+		const bool submeshField = (StringUtil::startsWith(field, "submesh_", false)
+			&& field != "submesh_count") || field == "lod_index";
+		if (submeshField && !submeshValid)
+		{
+			return false;
+		}
+
+		// Vertex cache metrics of the requested LOD level, if the submesh has them.
+		const VertexCacheMetrics* cache = submeshValid
+			&& lodIndex < info.submeshes[submeshIndex].vertexCache.size()
+			? &info.submeshes[submeshIndex].vertexCache[lodIndex] : NULL;
+
+		if (field == "name")
+		{
+			value = info.name;
+		}
+		else if (field == "version")
+		{
+			value = info.version;
+		}
+		else if (field == "endian")
+		{
+			value = info.endian;
+		}
+		else if (field == "stored_bounding_box")
+		{
+			value = ToolUtils::getPrettyAabbString(info.storedBoundingBox);
+		}
+		else if (field == "actual_bounding_box")
+		{
+			value = ToolUtils::getPrettyAabbString(info.actualBoundingBox);
+		}
+		else if (field == "stored_mesh_extent")
+		{
+			value = ToolUtils::getPrettyVectorString(info.storedBoundingBox.getSize());
+		}
+		else if (field == "actual_mesh_extent")
+		{
+			value = ToolUtils::getPrettyVectorString(info.actualBoundingBox.getSize());
+		}
+		else if (field == "edge_list")
+		{
+			value = info.hasEdgeList ? "yes" : "no";
+		}
+		else if (field == "lod_level_count")
+		{
+			value = StringConverter::toString(info.numLodLevels);
+		}
+		else if (field == "shared_vertices")
+		{
+			value = info.hasSharedVertices ? "yes" : "no";
+		}
+		else if (field == "shared_vertex_count" && info.hasSharedVertices)
+		{
+			value = StringConverter::toString(info.sharedVertices.numVertices);
+		}
+		else if (field == "shared_bone_assignment_count" && info.hasSharedVertices)
+		{
+			value = StringConverter::toString(info.sharedVertices.numBoneAssignments);
+		}
+		else if (field == "shared_bone_references_count" && info.hasSharedVertices)
+		{
+			value = StringConverter::toString(info.sharedVertices.numBonesReferenced);
+		}
+		else if (field == "shared_vertex_layout" && info.hasSharedVertices)
+		{
+			value = info.sharedVertices.layout;
+		}
+		else if (field == "submesh_count")
+		{
+			value = StringConverter::toString(info.submeshes.size());
+		}
+		else if (field == "submesh_index")
+		{
+			value = StringConverter::toString(submeshIndex);
+		}
+		else if (field == "submesh_name")
+		{
+			value = info.submeshes[submeshIndex].name;
+		}
+		else if (field == "submesh_material")
+		{
+			value = info.submeshes[submeshIndex].materialName;
+		}
+		else if (field == "submesh_use_shared_vertices")
+		{
+			value = info.submeshes[submeshIndex].usesSharedVertices ? "yes" : "no";
+		}
+		else if (field == "submesh_vertex_count")
+		{
+			value = StringConverter::toString(
+				info.submeshes[submeshIndex].vertices.numVertices);
+		}
+		else if (field == "submesh_bone_assignment_count")
+		{
+			value = StringConverter::toString(
+				info.submeshes[submeshIndex].vertices.numBoneAssignments);
+		}
+		else if (field == "submesh_bone_references_count")
+		{
+			value = StringConverter::toString(
+				info.submeshes[submeshIndex].vertices.numBonesReferenced);
+		}
+		else if (field == "submesh_vertex_layout")
+		{
+			value = info.submeshes[submeshIndex].vertices.layout;
+		}
+		else if (field == "submesh_operation_type")
+		{
+			value = info.submeshes[submeshIndex].operationType;
+		}
+		else if (field == "submesh_element_count")
+		{
+			value = StringConverter::toString(info.submeshes[submeshIndex].numElements);
+		}
+		else if (field == "submesh_triangle_count")
+		{
+			if (info.submeshes[submeshIndex].elementType == "triangles")
 			{
-				out += StringConverter::toString(info.numPoints);
+				value = StringConverter::toString(info.submeshes[submeshIndex].numElements);
 			}
-			else if (field == "skeleton")
+			else
 			{
-				out += info.hasSkeleton ? "yes" : "no";
+				value = "0";
 			}
-			else if (field == "skeleton_name" && info.hasSkeleton)
+		}
+		else if (field == "submesh_line_count")
+		{
+			if (info.submeshes[submeshIndex].elementType == "lines")
 			{
-				out += info.skeletonName;
+				value = StringConverter::toString(info.submeshes[submeshIndex].numElements);
 			}
-			else if (field == "skeleton_bone_count" && info.skeletonValid)
+			else
 			{
-				out += StringConverter::toString(info.skeleton.boneNames.size());
+				value = "0";
 			}
-			else if (field == "skeleton_animation_count" && info.skeletonValid)
+		}
+		else if (field == "submesh_point_count")
+		{
+			if (info.submeshes[submeshIndex].elementType == "points")
 			{
-				out += StringConverter::toString(info.skeleton.animations.size());
+				value = StringConverter::toString(info.submeshes[submeshIndex].numElements);
 			}
 			else
 			{
-				continue;
+				value = "0";
 			}
-
-			if (i < listFields.size() - 1) out += delim;
 		}
-
-		print(out);
+		else if (field == "submesh_index_width")
+		{
+			value = StringConverter::toString(info.submeshes[submeshIndex].indexBitWidth);
+		}
+		else if (field == "submesh_index_buffer_bytes")
+		{
+			value = StringConverter::toString(info.submeshes[submeshIndex].indexBufferBytes);
+		}
+		else if (field == "submesh_duplicate_vertex_count")
+		{
+			value = StringConverter::toString(
+				info.submeshes[submeshIndex].vertices.numDuplicateVertices);
+		}
+		else if (field == "lod_index")
+		{
+			value = StringConverter::toString(lodIndex);
+		}
+		else if (field == "submesh_fifo_acmr" && cache)
+		{
+			value = StringConverter::toString(cache->fifoAcmr, 4);
+		}
+		else if (field == "submesh_fifo_atvr" && cache)
+		{
+			value = StringConverter::toString(cache->fifoAtvr, 4);
+		}
+		else if (field == "submesh_lru_acmr" && cache)
+		{
+			value = StringConverter::toString(cache->lruAcmr, 4);
+		}
+		else if (field == "submesh_lru_atvr" && cache)
+		{
+			value = StringConverter::toString(cache->lruAtvr, 4);
+		}
+		else if (field == "submesh_overfetch" && cache)
+		{
+			value = StringConverter::toString(cache->overfetch, 4);
+		}
+		else if (field == "submesh_unreferenced_vertices" && cache)
+		{
+			value = StringConverter::toString(cache->unreferencedVertices, 4);
+		}
+		else if (field == "morph_animation_count")
+		{
+			value = StringConverter::toString(info.morphAnimations.size());
+		}
+		else if (field == "pose_count")
+		{
+			value = StringConverter::toString(info.poseNames.size());
+		}
+		else if (field == "max_bone_assignments")
+		{
+			value = StringConverter::toString(info.maxNumBoneAssignments);
+		}
+		else if (field == "max_bone_references")
+		{
+			value = StringConverter::toString(info.maxNumBonesReferenced);
+		}
+		else if (field == "total_vertex_count")
+		{
+			value = StringConverter::toString(info.numVertices);
+		}
+		else if (field == "total_element_count")
+		{
+			value = StringConverter::toString(info.numElements);
+		}
+		else if (field == "total_triangle_count")
+		{
+			value = StringConverter::toString(info.numTrianlges);
+		}
+		else if (field == "total_line_count")
+		{
+			value = StringConverter::toString(info.numLines);
+		}
+		else if (field == "total_point_count")
+		{
+			value = StringConverter::toString(info.numPoints);
+		}
+		else if (field == "vertex_buffer_bytes")
+		{
+			value = StringConverter::toString(info.vertexBufferBytes);
+		}
+		else if (field == "index_buffer_bytes")
+		{
+			value = StringConverter::toString(info.indexBufferBytes);
+		}
+		else if (field == "potential_savings")
+		{
+			value = StringConverter::toString(info.potentialSavings);
+		}
+		else if (field == "skeleton")
+		{
+			value = info.hasSkeleton ? "yes" : "no";
+		}
+		else if (field == "skeleton_name" && info.hasSkeleton)
+		{
+			value = info.skeletonName;
+		}
+		else if (field == "skeleton_bone_count" && info.skeletonValid)
+		{
+			value = StringConverter::toString(info.skeleton.boneNames.size());
+		}
+		else if (field == "skeleton_animation_count" && info.skeletonValid)
+		{
+			value = StringConverter::toString(info.skeleton.animations.size());
+		}
+		else
+		{
+			return false;
+		}
+		return true;
 	}
     //------------------------------------------------------------------------
 
 	void InfoTool::listSkeletonInfo(const Ogre::StringVector& listFields, char delim,
-		const SkeletonInfo& info) const
+		const SkeletonInfo& info, bool csv) const
 	{
 		String out;
 
 		for (size_t i = 0; i < listFields.size(); ++i)
 		{
-			const String field = listFields[i];
-			if (field == "skeleton_name")
-			{
-				out += info.name;
-			}
-			else if (field == "skeleton_bone_count")
+			String value;
+			if (csv)
 			{
-				out += StringConverter::toString(info.boneNames.size());
+				getSkeletonInfoField(listFields[i], info, value);
+				out += getCsvString(value);
 			}
-			else if (field == "skeleton_animation_count")
+			else if (getSkeletonInfoField(listFields[i], info, value))
 			{
-				out += StringConverter::toString(info.animations.size());
+				out += value;
 			}
 			else
 			{
@@ -1022,7 +1725,37 @@ namespace meshmagick
 			if (i < listFields.size() - 1) out += delim;
 		}
 
-		print(out);
+		if (csv)
+		{
+			printRecord(out);
+		}
+		else
+		{
+			print(out);
+		}
+	}
+    //------------------------------------------------------------------------
+
+	bool InfoTool::getSkeletonInfoField(const Ogre::String& field, const SkeletonInfo& info,
+		Ogre::String& value) const
+	{
+		if (field == "skeleton_name")
+		{
+			value = info.name;
+		}
+		else if (field == "skeleton_bone_count")
+		{
+			value = StringConverter::toString(info.boneNames.size());
+		}
+		else if (field == "skeleton_animation_count")
+		{
+			value = StringConverter::toString(info.animations.size());
+		}
+		else
+		{
+			return false;
+		}
+		return true;
 	}
     //------------------------------------------------------------------------
 }
@@ -44,8 +44,14 @@ namespace meshmagick
     OptionDefinitionSet InfoToolFactory::getOptionDefinitions() const
     {
         OptionDefinitionSet optionDefs;
+        optionDefs.insert(OptionDefinition("aggregate"));
+        optionDefs.insert(OptionDefinition("top", OT_INT, false, false, Any(10)));
         optionDefs.insert(OptionDefinition("list", OT_STRING));
         optionDefs.insert(OptionDefinition("delim", OT_STRING));
+        optionDefs.insert(OptionDefinition("fifo-cache-size", OT_INT, false, false, Any(16)));
+        optionDefs.insert(OptionDefinition("lru-cache-size", OT_INT, false, false, Any(16)));
+        optionDefs.insert(OptionDefinition("format", OT_SELECTION, false, false, Any(),
+            "/json/ndjson/csv"));
         return optionDefs;
     }
 
@@ -53,7 +59,21 @@ namespace meshmagick
     {
         out << "Print information about the mesh" << std::endl
             << "without further options, info tool prints informations in report style" << std::endl
+			<< "Input files may also be directories, these are searched recursively for" << std::endl
+			<< ".mesh and .skeleton files, which are reported in alphabetical order." << std::endl
+			<< "-aggregate : instead of reporting each file, print statistics over all files:" << std::endl
+			<< "    percentiles and histograms of vertex and triangle counts, buffer sizes," << std::endl
+			<< "    bytes per vertex, LOD levels, bones, influences and animation lengths," << std::endl
+			<< "    index widths, vertex layouts and the heaviest meshes." << std::endl
+			<< "-top=<n> : number of heaviest meshes listed by -aggregate. Default is 10." << std::endl
+			<< "-format=json|ndjson|csv : print all information in a machine readable format." << std::endl
+			<< "    json   : one array holding an object per file" << std::endl
+			<< "    ndjson : one object per file and line" << std::endl
+			<< "    csv    : a header line and one line per file. Columns are the fields" << std::endl
+			<< "             given by -list, or all mesh level fields, if -list is not set." << std::endl
 			<< "-delim=<delimiter> : delimiter character used by the -list option. Default is tab." << std::endl
+			<< "-fifo-cache-size=<n> : entries of the simulated FIFO vertex cache. Default is 16." << std::endl
+			<< "-lru-cache-size=<n> : entries of the simulated LRU vertex cache. Default is 16." << std::endl
 			<< "-list=<field-key1>/<field-key2>/.. : print delim separated fields" << std::endl
 			<< "    The following field-keys are available:" << std::endl
 			<< std::endl
@@ -87,6 +107,16 @@ namespace meshmagick
 			<< "         submesh_line_count" << std::endl
 			<< "         submesh_point_count" << std::endl
 			<< "         submesh_index_width" << std::endl
+			<< "         submesh_index_buffer_bytes" << std::endl
+			<< "         submesh_duplicate_vertex_count" << std::endl
+			<< std::endl
+			<< "         submesh_fifo_acmr     (vertex shader invocations per triangle)" << std::endl
+			<< "         submesh_fifo_atvr     (vertex shader invocations per vertex)" << std::endl
+			<< "         submesh_lru_acmr" << std::endl
+			<< "         submesh_lru_atvr" << std::endl
+			<< "         submesh_overfetch     (bytes fetched / bytes of referenced vertices)" << std::endl
+			<< "         submesh_unreferenced_vertices (fraction)" << std::endl
+			<< "         lod_index     (print vertex cache fields for each LOD level)" << std::endl
 			<< std::endl
 			<< "         max_bone_assignments" << std::endl
 			<< "         max_bone_references" << std::endl
@@ -96,6 +126,11 @@ namespace meshmagick
 			<< "         total_line_count" << std::endl
 			<< "         total_point_count" << std::endl
 			<< std::endl
+			<< "         vertex_buffer_bytes" << std::endl
+			<< "         index_buffer_bytes" << std::endl
+			<< "         potential_savings     (bytes of padding, unused elements, duplicate" << std::endl
+			<< "                                vertices and needlessly wide indices)" << std::endl
+			<< std::endl
 			<< "         morph_animation_count" << std::endl
 			<< "         pose_count" << std::endl
 			<< std::endl
@@ -23,22 +23,38 @@ THE SOFTWARE.
 
 #include "MmMeshMergeTool.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
 #include <stdexcept>
 #include <OgreAnimation.h>
 #include <OgreAxisAlignedBox.h>
 #include <OgreHardwareBufferManager.h>
+#include <OgreKeyFrame.h>
 #include <OgreMeshManager.h>
+#include <OgrePose.h>
 #include <OgreSkeletonManager.h>
+#include <OgreStringConverter.h>
 #include <OgreSubMesh.h>
 
+#include "MmBufferedFileWriter.h"
+#include "MmMeshUtils.h"
 #include "MmOgreEnvironment.h"
+#include "MmThreadPool.h"
+#include "MmToolUtils.h"
+#include "MmTransformTool.h"
+#include "MmVertexWelder.h"
 
 using namespace Ogre;
 
 namespace meshmagick
 {
 	MeshMergeTool::MeshMergeTool()
-		: mBaseSkeleton(), mMeshes()
+		: mBaseSkeleton(), mMeshes(), mMergeSubMeshes(false), mSingleBuffer(false), mWeld(false),
+		mWeldTolerance(1e-4f), mWeldAttributeTolerance(1e-2f), mPoseTolerance(0),
+		mPosePrecision(0), mMinInstances(0)
 	{
 	}
 
@@ -62,37 +78,428 @@ namespace meshmagick
 			fail("Exactly one output file must be specified.");
 			return;
 		}
-		else if (inFileNames.size() == 0)
+		else if (inFileNames.size() == 0 && !OptionsUtil::isOptionSet(toolOptions, "placements"))
 		{
 			fail("No input files specified.");
 			return;
 		}
 
+		mMergeSubMeshes = OptionsUtil::isOptionSet(toolOptions, "merge-submeshes");
+		mSingleBuffer = OptionsUtil::isOptionSet(toolOptions, "single-buffer");
+		for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
+		{
+			if (it->first == "weld")
+			{
+				mWeld = true;
+				mWeldTolerance = any_cast<Real>(it->second);
+			}
+			else if (it->first == "weld-attribute-tolerance")
+			{
+				mWeldAttributeTolerance = any_cast<Real>(it->second);
+			}
+			else if (it->first == "pose-tolerance")
+			{
+				mPoseTolerance = any_cast<Real>(it->second);
+			}
+			else if (it->first == "pose-precision")
+			{
+				mPosePrecision = any_cast<Real>(it->second);
+			}
+			else if (it->first == "instancing")
+			{
+				mMinInstances = static_cast<size_t>(std::max(2, any_cast<int>(it->second)));
+			}
+		}
+
+		const String placementsFileName = OptionsUtil::getStringOption(toolOptions, "placements");
+		const bool useCells = OptionsUtil::isOptionSet(toolOptions, "cell-size");
+		if (useCells || !placementsFileName.empty() || mMinInstances > 0)
+		{
+			Vector3 cellSize = Vector3::ZERO;
+			if (useCells)
+			{
+				for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
+				{
+					if (it->first == "cell-size")
+					{
+						cellSize = any_cast<Vector3>(it->second);
+					}
+				}
+				if (!(cellSize.x > 0 && cellSize.y > 0 && cellSize.z > 0))
+				{
+					fail("cell-size components must be greater than zero.");
+				}
+				// Cells are batched by material.
+				mMergeSubMeshes = true;
+			}
+
+			PlacementList placements;
+			for (Ogre::StringVector::const_iterator it = inFileNames.begin();
+				it != inFileNames.end(); ++it)
+			{
+				placements.push_back(Placement(*it, Matrix4::IDENTITY));
+			}
+			if (!placementsFileName.empty())
+			{
+				readPlacements(placementsFileName, placements);
+			}
+			if (placements.empty())
+			{
+				fail("No input files specified.");
+			}
+
+			mergePlacements(placements, cellSize, outFileNames.front());
+			OgreEnvironment::getSingleton().releaseFileResources();
+			return;
+		}
+
+		StatefulMeshSerializer* meshSer = OgreEnvironment::getSingleton().getMeshSerializer();
+		std::vector<MeshPtr> meshes;
+		loadMeshes(inFileNames, meshes);
+		// Added in input order, so that the output doesn't depend on load timing.
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			if (meshes[i])
+			{
+				addMesh(meshes[i]);
+			}
+		}
+		Ogre::String outputfile = *outFileNames.begin();
+		MeshPtr mergedMesh = merge(outputfile);
+		if (!meshSer->saveMesh(mergedMesh.get(), outputfile))
+		{
+			print("Mesh " + outputfile + " unchanged, not written.");
+		}
+
+		// Written, so neither the merged mesh nor its sources are needed any more.
+		MeshManager::getSingleton().remove(mergedMesh);
+		OgreEnvironment::getSingleton().releaseFileResources();
+	}
+
+
+	void MeshMergeTool::loadMeshes(const StringVector& fileNames, std::vector<MeshPtr>& meshes)
+	{
 		StatefulMeshSerializer* meshSer = OgreEnvironment::getSingleton().getMeshSerializer();
 		StatefulSkeletonSerializer* skelSer =
 			OgreEnvironment::getSingleton().getSkeletonSerializer();
-		for (Ogre::StringVector::const_iterator it = inFileNames.begin();
-			it != inFileNames.end(); ++it)
+		meshes.assign(fileNames.size(), MeshPtr());
+
+		ThreadPool pool(mNumThreads);
+		std::vector<std::vector<unsigned char> > contents(fileNames.size());
+		pool.runWindowed(fileNames.size(), [&](size_t i)
 		{
-			MeshPtr curMesh = meshSer->loadMesh(*it);
-			if (curMesh)
+			ToolUtils::readFile(fileNames[i], contents[i]);
+		},
+		[&](size_t i)
+		{
+			const String& fileName = fileNames[i];
+			print("Loading mesh " + fileName + "...", V_HIGH);
+			try
 			{
-				if (curMesh->hasSkeleton() && 
-					!SkeletonManager::getSingleton().getByName(curMesh->getSkeletonName(), ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME))
+				MeshPtr mesh;
+				if (contents[i].empty())
+				{
+					mesh = meshSer->loadMesh(fileName);
+				}
+				else
+				{
+					DataStreamPtr stream(new MemoryDataStream(fileName,
+						&contents[i][0], contents[i].size(), false, true));
+					mesh = meshSer->loadMesh(fileName, stream);
+				}
+				if (mesh->hasSkeleton() &&
+					!SkeletonManager::getSingleton().getByName(mesh->getSkeletonName(),
+						ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME))
 				{
-					skelSer->loadSkeleton(curMesh->getSkeletonName());
+					skelSer->loadSkeleton(mesh->getSkeletonName());
 				}
-				addMesh(curMesh);
+				meshes[i] = mesh;
 			}
-			else
+			catch (std::exception& e)
+			{
+				warn(e.what());
+				warn("Unable to open mesh file " + fileName);
+				warn("file skipped.");
+			}
+			contents[i] = std::vector<unsigned char>();
+		});
+
+		// All meshes have to share one skeleton or have none, check before merging.
+		const MeshPtr* firstMesh = NULL;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			if (!meshes[i])
+			{
+				continue;
+			}
+			if (firstMesh == NULL)
 			{
-				warn("Skipped: Mesh " + *it + " cannnot be loaded.");
+				firstMesh = &meshes[i];
+			}
+			else if (meshes[i]->getSkeletonName() != (*firstMesh)->getSkeletonName())
+			{
+				fail("Mesh " + meshes[i]->getName() + " uses skeleton '"
+					+ meshes[i]->getSkeletonName() + "', but mesh " + (*firstMesh)->getName()
+					+ " uses '" + (*firstMesh)->getSkeletonName() + "', cannot merge.");
 			}
 		}
-		Ogre::String outputfile = *outFileNames.begin();
-		meshSer->exportMesh(merge(outputfile).get(), outputfile);
 	}
 
+	void MeshMergeTool::readPlacements(const String& fileName, PlacementList& placements) const
+	{
+		std::ifstream ifs(fileName.c_str());
+		if (!ifs)
+		{
+			fail("cannot open placement file " + fileName);
+		}
+
+		String line;
+		size_t lineNumber = 0;
+		while (std::getline(ifs, line))
+		{
+			++lineNumber;
+			StringUtil::trim(line);
+			if (line.empty() || line[0] == '#')
+			{
+				continue;
+			}
+
+			// The file name may contain blanks, so it is separated by a tab.
+			const String::size_type tab = line.find('\t');
+			const StringVector values = tab == String::npos
+				? StringVector() : StringUtil::split(line.substr(tab + 1), " \t");
+			if (values.size() != 7 && values.size() != 8 && values.size() != 10)
+			{
+				fail("malformed placement in line " + StringConverter::toString(lineNumber)
+					+ " of " + fileName);
+			}
+
+			const Vector3 translation(StringConverter::parseReal(values[0]),
+				StringConverter::parseReal(values[1]), StringConverter::parseReal(values[2]));
+			Quaternion orientation(StringConverter::parseReal(values[3]),
+				StringConverter::parseReal(values[4]), StringConverter::parseReal(values[5]),
+				StringConverter::parseReal(values[6]));
+			orientation.normalise();
+			Vector3 scale = Vector3::UNIT_SCALE;
+			if (values.size() == 8)
+			{
+				scale = Vector3(StringConverter::parseReal(values[7]));
+			}
+			else if (values.size() == 10)
+			{
+				scale = Vector3(StringConverter::parseReal(values[7]),
+					StringConverter::parseReal(values[8]), StringConverter::parseReal(values[9]));
+			}
+
+			Matrix4 transform;
+			transform.makeTransform(translation, scale, orientation);
+			String meshFileName = line.substr(0, tab);
+			StringUtil::trim(meshFileName);
+			placements.push_back(Placement(meshFileName, transform));
+		}
+		print("Read " + StringConverter::toString(placements.size()) + " placements.", V_HIGH);
+	}
+
+	void MeshMergeTool::copyMorphBuffers(Mesh* mesh)
+	{
+		for (unsigned short i = 0; i < mesh->getNumAnimations(); ++i)
+		{
+			Animation::VertexTrackIterator it = mesh->getAnimation(i)->getVertexTrackIterator();
+			while (it.hasMoreElements())
+			{
+				VertexAnimationTrack* track = it.getNext();
+				if (track->getAnimationType() != VAT_MORPH)
+				{
+					continue;
+				}
+				for (unsigned short k = 0; k < track->getNumKeyFrames(); ++k)
+				{
+					VertexMorphKeyFrame* kf = track->getVertexMorphKeyFrame(k);
+					HardwareVertexBufferSharedPtr oldBuf = kf->getVertexBuffer();
+					HardwareVertexBufferSharedPtr newBuf =
+						HardwareBufferManager::getSingleton().createVertexBuffer(
+							oldBuf->getVertexSize(), oldBuf->getNumVertices(),
+							oldBuf->getUsage(), oldBuf->hasShadowBuffer());
+					newBuf->copyData(*oldBuf);
+					kf->setVertexBuffer(newBuf);
+				}
+			}
+		}
+	}
+
+	void MeshMergeTool::mergePlacements(const PlacementList& placements, const Vector3& cellSize,
+		const String& outFileName)
+	{
+		StatefulMeshSerializer* meshSer = OgreEnvironment::getSingleton().getMeshSerializer();
+
+		TransformTool transformer;
+		transformer.setVerbosity(mVerbosity);
+		transformer.setNormaliseNormals(true);
+
+		// Files placed often enough are instanced instead of merged.
+		InstanceMap instances;
+		if (mMinInstances > 0)
+		{
+			for (size_t i = 0; i < placements.size(); ++i)
+			{
+				instances[placements[i].fileName].push_back(i);
+			}
+			for (InstanceMap::iterator it = instances.begin(); it != instances.end();)
+			{
+				if (it->second.size() < mMinInstances)
+				{
+					instances.erase(it++);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		// Each file is loaded once, placed meshes are copies of it.
+		StringVector sourceFileNames;
+		std::map<String, MeshPtr> sources;
+		for (size_t i = 0; i < placements.size(); ++i)
+		{
+			const String& fileName = placements[i].fileName;
+			if (instances.find(fileName) == instances.end()
+				&& sources.insert(std::make_pair(fileName, MeshPtr())).second)
+			{
+				sourceFileNames.push_back(fileName);
+			}
+		}
+		std::vector<MeshPtr> sourceMeshes;
+		loadMeshes(sourceFileNames, sourceMeshes);
+		for (size_t i = 0; i < sourceFileNames.size(); ++i)
+		{
+			sources[sourceFileNames[i]] = sourceMeshes[i];
+		}
+
+		// Maps cell coordinates to the meshes placed in it.
+		typedef std::map<String, std::vector<MeshPtr> > CellMap;
+		CellMap cells;
+		std::vector<MeshPtr> placedMeshes;
+		for (size_t i = 0; i < placements.size(); ++i)
+		{
+			const Placement& placement = placements[i];
+			if (instances.find(placement.fileName) != instances.end())
+			{
+				continue;
+			}
+			std::map<String, MeshPtr>::const_iterator source = sources.find(placement.fileName);
+			if (!source->second)
+			{
+				continue;
+			}
+
+			MeshPtr placed = source->second->clone(
+				source->second->getName() + "#" + StringConverter::toString(i));
+			placedMeshes.push_back(placed);
+			if (placement.transform != Matrix4::IDENTITY)
+			{
+				// The clone's morph key frames still use the source's buffers.
+				copyMorphBuffers(placed.get());
+				// Mirroring turns faces inside out, unless the winding is flipped too.
+				transformer.setFlipVertexWinding(placement.transform.determinant() < 0);
+				// The skeleton is shared by all placements, so it is left as it is.
+				transformer.transform(placed, placement.transform, false);
+			}
+
+			String cellName;
+			if (cellSize != Vector3::ZERO)
+			{
+				const Vector3 centre = placed->getBounds().isFinite()
+					? placed->getBounds().getCenter() : Vector3::ZERO;
+				cellName = StringConverter::toString(
+						static_cast<long>(std::floor(centre.x / cellSize.x))) + "_"
+					+ StringConverter::toString(
+						static_cast<long>(std::floor(centre.y / cellSize.y))) + "_"
+					+ StringConverter::toString(
+						static_cast<long>(std::floor(centre.z / cellSize.z)));
+			}
+			cells[cellName].push_back(placed);
+		}
+
+		String baseName, extension;
+		StringUtil::splitBaseFilename(outFileName, baseName, extension);
+		if (!instances.empty())
+		{
+			writeInstances(baseName + ".instances", placements, instances);
+		}
+		for (CellMap::const_iterator it = cells.begin(); it != cells.end(); ++it)
+		{
+			const String fileName = it->first.empty()
+				? outFileName : baseName + "_" + it->first + "." + extension;
+			for (size_t i = 0; i < it->second.size(); ++i)
+			{
+				addMesh(it->second[i]);
+			}
+
+			MeshPtr mergedMesh = merge(fileName);
+			print("Cell " + (it->first.empty() ? String("0_0_0") : it->first) + ": "
+				+ StringConverter::toString(it->second.size()) + " meshes, "
+				+ StringConverter::toString(mergedMesh->getNumSubMeshes()) + " submeshes.");
+			if (!meshSer->saveMesh(mergedMesh.get(), fileName))
+			{
+				print("Mesh " + fileName + " unchanged, not written.");
+			}
+			MeshManager::getSingleton().remove(mergedMesh);
+		}
+
+		for (size_t i = 0; i < placedMeshes.size(); ++i)
+		{
+			MeshManager::getSingleton().remove(placedMeshes[i]);
+		}
+	}
+
+	void MeshMergeTool::writeInstances(const String& fileName, const PlacementList& placements,
+		const InstanceMap& instances) const
+	{
+		BufferedFileWriter writer;
+		DataStreamPtr stream = writer.getStream();
+
+		const uint32 header[] = {INSTANCES_FILE_ID, INSTANCES_FILE_VERSION,
+			static_cast<uint32>(instances.size())};
+		stream->write(header, sizeof(header));
+		size_t numInstances = 0;
+		for (InstanceMap::const_iterator it = instances.begin(); it != instances.end(); ++it)
+		{
+			const uint32 nameLength = static_cast<uint32>(it->first.size());
+			const uint32 count = static_cast<uint32>(it->second.size());
+			stream->write(&nameLength, sizeof(nameLength));
+			stream->write(it->first.c_str(), nameLength);
+			stream->write(&count, sizeof(count));
+			for (size_t i = 0; i < it->second.size(); ++i)
+			{
+				// Upper three rows of the transformation, followed by the placement's
+				// index, so that further per instance data can be looked up by it.
+				const Matrix4& m = placements[it->second[i]].transform;
+				float rows[12];
+				for (size_t j = 0; j < 12; ++j)
+				{
+					rows[j] = static_cast<float>(m[j / 4][j % 4]);
+				}
+				const uint32 placementIndex = static_cast<uint32>(it->second[i]);
+				stream->write(rows, sizeof(rows));
+				stream->write(&placementIndex, sizeof(placementIndex));
+			}
+			numInstances += it->second.size();
+			print("Instancing " + it->first + " " + StringConverter::toString(it->second.size())
+				+ " times.", V_HIGH);
+		}
+
+		if (writer.commit(fileName))
+		{
+			print(StringConverter::toString(numInstances) + " instances of "
+				+ StringConverter::toString(instances.size()) + " meshes saved as "
+				+ fileName + ".");
+		}
+		else
+		{
+			print("Instances " + fileName + " unchanged, not written.");
+		}
+	}
 
 	void MeshMergeTool::addMesh(Ogre::MeshPtr mesh)
 	{
@@ -153,10 +560,22 @@ namespace meshmagick
 			mp->setSkeletonName(mBaseSkeleton->getName());
 		}
 
+		// Maps merge keys to the new submesh and the submeshes merged into it.
+		// Their geometry is concatenated, when all meshes have been added.
+		typedef std::map<String, std::pair<SubMesh*, std::vector<SubMesh*> > > SubMeshGroupMap;
+		SubMeshGroupMap subMeshGroups;
+		// Meshes with shared vertex data and the new submeshes using it.
+		std::vector<const Mesh*> sharedSources;
+		SharedSubMeshList sharedSubMeshes;
+
+		// Per mesh the handles of the new submeshes its submeshes ended up in.
+		std::vector<std::vector<unsigned short> > subMeshHandles(mMeshes.size());
+
 		AxisAlignedBox totalBounds = AxisAlignedBox();
 		for (std::vector<Ogre::MeshPtr>::iterator it = mMeshes.begin(); it != mMeshes.end(); ++it)
 		{
 			print("Baking: adding submeshes for " + (*it)->getName(), V_HIGH);
+			subMeshHandles[it - mMeshes.begin()].resize((*it)->getNumSubMeshes(), 0);
 
 			// insert all submeshes
 			for (Ogre::ushort sid = 0; sid < (*it)->getNumSubMeshes(); ++sid)
@@ -164,6 +583,20 @@ namespace meshmagick
 				SubMesh* sub = (*it)->getSubMesh(sid);
 				const String name = findSubmeshName((*it), sid);
 
+				const String mergeKey = mMergeSubMeshes
+					? getSubMeshMergeKey(*it, sid) : BLANKSTRING;
+				if (!mergeKey.empty())
+				{
+					SubMeshGroupMap::iterator group = subMeshGroups.find(mergeKey);
+					if (group != subMeshGroups.end())
+					{
+						group->second.second.push_back(sub);
+						print("Baking: merging submesh '" + name + "' with material "
+							+ sub->getMaterialName(), V_HIGH);
+						continue;
+					}
+				}
+
 				// create submesh with correct name
 				SubMesh* newsub;
 				if (name.length() == 0)
@@ -177,126 +610,773 @@ namespace meshmagick
 				}
 
 				newsub->useSharedVertices = sub->useSharedVertices;
-
-				// add index
-				newsub->indexData = sub->indexData->clone();
+				newsub->operationType = sub->operationType;
+				subMeshHandles[it - mMeshes.begin()][sid] = mp->getNumSubMeshes();
+				if (sub->useSharedVertices)
+				{
+					sharedSubMeshes.push_back(std::make_pair(newsub, it->get()));
+				}
 
 				// add geometry
-				if (!newsub->useSharedVertices)
+				if (mergeKey.empty())
 				{
-					newsub->vertexData = sub->vertexData->clone();
-
-					if (mBaseSkeleton)
-					{
-						// build bone assignments
-						for (const auto& boneAssignment : sub->getBoneAssignments())
-							newsub->addBoneAssignment (boneAssignment.second);
-					}
+					copySubMeshGeometry(newsub, sub);
+				}
+				else
+				{
+					subMeshGroups[mergeKey] = std::make_pair(newsub, std::vector<SubMesh*>(1, sub));
 				}
 
 				newsub->setMaterialName(sub->getMaterialName());
 
-				// Add vertex animations for this submesh
-				Animation *anim = 0;
-				for (unsigned short i = 0; i < (*it)->getNumAnimations(); ++i)
+				print("Baking: adding submesh '" +
+					name + "'  with material " + sub->getMaterialName(), V_HIGH);
+			}
+
+			// sharedvertices
+			if ((*it)->sharedVertexData)
+			{
+				sharedSources.push_back(it->get());
+			}
+
+			print("Baking: adding bounds for " + (*it)->getName(), V_HIGH);
+
+			// add bounds
+			totalBounds.merge((*it)->getBounds());
+		}
+		mp->_setBounds(totalBounds);
+
+		SharedOffsetMap sharedOffsets;
+		mergeSharedVertexData(mp, sharedSources, sharedSubMeshes, sharedOffsets);
+
+		for (SubMeshGroupMap::iterator it = subMeshGroups.begin(); it != subMeshGroups.end(); ++it)
+		{
+			SubMesh* newsub = it->second.first;
+			const std::vector<SubMesh*>& subs = it->second.second;
+			if (subs.size() == 1)
+			{
+				copySubMeshGeometry(newsub, subs.front());
+			}
+			else
+			{
+				print("Baking: merged " + StringConverter::toString(subs.size())
+					+ " submeshes with material " + newsub->getMaterialName(), V_HIGH);
+				mergeSubMeshGeometry(newsub, subs);
+			}
+		}
+
+		// Poses and vertex animation reference vertex data by handle, so these are
+		// added, when all vertex data is in place.
+		for (size_t i = 0; i < mMeshes.size(); ++i)
+		{
+			mergeVertexAnimation(mp, mMeshes[i], subMeshHandles[i], sharedOffsets);
+		}
+
+		if (mSingleBuffer)
+		{
+			packSingleBuffer(mp);
+		}
+
+		if (mWeld)
+		{
+			weldVertices(mp);
+		}
+
+		/// @todo add parameters
+		mp->buildEdgeList();
+
+		print("Baking: Finished", V_HIGH);
+
+		reset();
+
+		return mp;
+	}
+
+	String MeshMergeTool::getSubMeshMergeKey(MeshPtr m, Ogre::ushort sid) const
+	{
+		SubMesh* sub = m->getSubMesh(sid);
+		if (sub->useSharedVertices || sub->vertexData == NULL
+			|| sub->indexData == NULL || !sub->indexData->indexBuffer)
+		{
+			return BLANKSTRING;
+		}
+
+		// Strips and fans can't simply be concatenated.
+		if (sub->operationType != RenderOperation::OT_TRIANGLE_LIST
+			&& sub->operationType != RenderOperation::OT_LINE_LIST
+			&& sub->operationType != RenderOperation::OT_POINT_LIST)
+		{
+			return BLANKSTRING;
+		}
+
+		// Vertex animation and poses target the submesh by handle (submesh index + 1),
+		// such submeshes are kept as they are.
+		for (unsigned short i = 0; i < m->getNumAnimations(); ++i)
+		{
+			if (m->getAnimation(i)->hasVertexTrack(sid + 1))
+			{
+				return BLANKSTRING;
+			}
+		}
+		const PoseList& poses = m->getPoseList();
+		for (size_t i = 0; i < poses.size(); ++i)
+		{
+			if (poses[i]->getTarget() == sid + 1)
+			{
+				return BLANKSTRING;
+			}
+		}
+
+		return StringConverter::toString(sub->operationType)
+			+ getVertexLayoutKey(sub->vertexData) + "|" + sub->getMaterialName();
+	}
+
+	String MeshMergeTool::getVertexLayoutKey(const VertexData* vd)
+	{
+		String key;
+		const VertexDeclaration::VertexElementList& elements =
+			vd->vertexDeclaration->getElements();
+		for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+			it != elements.end(); ++it)
+		{
+			key += "|" + StringConverter::toString(it->getSource())
+				+ "," + StringConverter::toString(it->getOffset())
+				+ "," + StringConverter::toString(it->getType())
+				+ "," + StringConverter::toString(it->getSemantic())
+				+ "," + StringConverter::toString(it->getIndex());
+		}
+		const VertexBufferBinding::VertexBufferBindingMap& bindings =
+			vd->vertexBufferBinding->getBindings();
+		for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+			it != bindings.end(); ++it)
+		{
+			key += "|" + StringConverter::toString(it->first)
+				+ ":" + StringConverter::toString(it->second->getVertexSize());
+		}
+		return key;
+	}
+
+	void MeshMergeTool::copySubMeshGeometry(SubMesh* newsub, SubMesh* sub) const
+	{
+		// add index
+		OGRE_DELETE newsub->indexData;
+		newsub->indexData = sub->indexData->clone();
+
+		// add geometry
+		if (!newsub->useSharedVertices)
+		{
+			newsub->vertexData = sub->vertexData->clone();
+
+			if (mBaseSkeleton)
+			{
+				// build bone assignments
+				for (const auto& boneAssignment : sub->getBoneAssignments())
+					newsub->addBoneAssignment (boneAssignment.second);
+			}
+		}
+	}
+
+	void MeshMergeTool::mergeSubMeshGeometry(SubMesh* newsub,
+		const std::vector<SubMesh*>& subs) const
+	{
+		size_t numIndices = 0;
+		std::vector<const VertexData*> vertexDatas;
+		for (size_t i = 0; i < subs.size(); ++i)
+		{
+			vertexDatas.push_back(subs[i]->vertexData);
+			numIndices += subs[i]->indexData->indexCount;
+		}
+
+		// All subs have the same declaration and bindings, see getSubMeshMergeKey.
+		newsub->vertexData = concatenateVertexData(vertexDatas);
+		const size_t numVertices = newsub->vertexData->vertexCount;
+
+		// Only use 32 bit indices, if the merged vertices can't be addressed with 16 bit.
+		const bool use32BitIndices = numVertices > 65536;
+		HardwareIndexBufferSharedPtr firstIb = subs.front()->indexData->indexBuffer;
+		OGRE_DELETE newsub->indexData;
+		newsub->indexData = OGRE_NEW IndexData();
+		newsub->indexData->indexStart = 0;
+		newsub->indexData->indexCount = numIndices;
+		newsub->indexData->indexBuffer = HardwareBufferManager::getSingleton().createIndexBuffer(
+			use32BitIndices ? HardwareIndexBuffer::IT_32BIT : HardwareIndexBuffer::IT_16BIT,
+			numIndices, firstIb->getUsage(), firstIb->hasShadowBuffer());
+		void* indexDest = newsub->indexData->indexBuffer->lock(HardwareBuffer::HBL_DISCARD);
+		uint32* dest32 = static_cast<uint32*>(indexDest);
+		uint16* dest16 = static_cast<uint16*>(indexDest);
+
+		size_t vertexOffset = 0;
+		for (size_t i = 0; i < subs.size(); ++i)
+		{
+			const std::vector<uint32> indices = MeshUtils::getIndices(subs[i]->indexData);
+			for (size_t j = 0; j < indices.size(); ++j)
+			{
+				const uint32 index = static_cast<uint32>(indices[j] + vertexOffset);
+				if (use32BitIndices)
 				{
-					anim = (*it)->getAnimation(i);
+					*dest32++ = index;
+				}
+				else
+				{
+					*dest16++ = static_cast<uint16>(index);
+				}
+			}
+
+			if (mBaseSkeleton)
+			{
+				for (const auto& boneAssignment : subs[i]->getBoneAssignments())
+				{
+					VertexBoneAssignment vba = boneAssignment.second;
+					vba.vertexIndex = static_cast<unsigned int>(vba.vertexIndex + vertexOffset);
+					newsub->addBoneAssignment(vba);
+				}
+			}
+
+			vertexOffset += subs[i]->vertexData->vertexCount;
+		}
+		newsub->indexData->indexBuffer->unlock();
+	}
+
+	VertexData* MeshMergeTool::concatenateVertexData(
+		const std::vector<const VertexData*>& vertexDatas) const
+	{
+		size_t numVertices = 0;
+		for (size_t i = 0; i < vertexDatas.size(); ++i)
+		{
+			numVertices += vertexDatas[i]->vertexCount;
+		}
+
+		const VertexData* firstVd = vertexDatas.front();
+		VertexData* vd = OGRE_NEW VertexData();
+		vd->vertexStart = 0;
+		vd->vertexCount = numVertices;
+		const VertexDeclaration::VertexElementList& elements =
+			firstVd->vertexDeclaration->getElements();
+		for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+			it != elements.end(); ++it)
+		{
+			vd->vertexDeclaration->addElement(it->getSource(), it->getOffset(),
+				it->getType(), it->getSemantic(), it->getIndex());
+		}
+
+		const VertexBufferBinding::VertexBufferBindingMap& bindings =
+			firstVd->vertexBufferBinding->getBindings();
+		for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+			it != bindings.end(); ++it)
+		{
+			const size_t vertexSize = it->second->getVertexSize();
+			HardwareVertexBufferSharedPtr buffer =
+				HardwareBufferManager::getSingleton().createVertexBuffer(vertexSize,
+					numVertices, it->second->getUsage(), it->second->hasShadowBuffer());
+			unsigned char* dest = static_cast<unsigned char*>(
+				buffer->lock(HardwareBuffer::HBL_DISCARD));
+			for (size_t i = 0; i < vertexDatas.size(); ++i)
+			{
+				const VertexData* srcVd = vertexDatas[i];
+				HardwareVertexBufferSharedPtr srcBuffer =
+					srcVd->vertexBufferBinding->getBuffer(it->first);
+				const unsigned char* src = static_cast<const unsigned char*>(
+					srcBuffer->lock(HardwareBuffer::HBL_READ_ONLY))
+					+ srcVd->vertexStart * vertexSize;
+				memcpy(dest, src, srcVd->vertexCount * vertexSize);
+				dest += srcVd->vertexCount * vertexSize;
+				srcBuffer->unlock();
+			}
+			buffer->unlock();
+			vd->vertexBufferBinding->setBinding(it->first, buffer);
+		}
+		return vd;
+	}
+
+	void MeshMergeTool::rebaseIndexData(IndexData* indexData, size_t offset,
+		bool use32BitIndices) const
+	{
+		if (indexData == NULL || !indexData->indexBuffer
+			|| (offset == 0 && (!use32BitIndices
+				|| indexData->indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT)))
+		{
+			return;
+		}
+
+		const std::vector<uint32> indices = MeshUtils::getIndices(indexData);
+		HardwareIndexBufferSharedPtr oldBuffer = indexData->indexBuffer;
+		const bool is32Bit = use32BitIndices
+			|| oldBuffer->getType() == HardwareIndexBuffer::IT_32BIT;
+		indexData->indexBuffer = HardwareBufferManager::getSingleton().createIndexBuffer(
+			is32Bit ? HardwareIndexBuffer::IT_32BIT : HardwareIndexBuffer::IT_16BIT,
+			indices.size(), oldBuffer->getUsage(), oldBuffer->hasShadowBuffer());
+		indexData->indexStart = 0;
+		indexData->indexCount = indices.size();
+		void* data = indexData->indexBuffer->lock(HardwareBuffer::HBL_DISCARD);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			if (is32Bit)
+			{
+				static_cast<uint32*>(data)[i] = static_cast<uint32>(indices[i] + offset);
+			}
+			else
+			{
+				static_cast<uint16*>(data)[i] = static_cast<uint16>(indices[i] + offset);
+			}
+		}
+		indexData->indexBuffer->unlock();
+	}
+
+	void MeshMergeTool::mergeSharedVertexData(MeshPtr mesh,
+		const std::vector<const Mesh*>& sources, const SharedSubMeshList& subs,
+		SharedOffsetMap& vertexOffsets) const
+	{
+		if (sources.empty())
+		{
+			return;
+		}
 
-					// get or create the animation for the new mesh
-					Animation *newanim;
-					if (mp->hasAnimation(anim->getName()))
+		// Shared data with the layout of the first one is concatenated into one pool.
+		const String poolKey = getVertexLayoutKey(sources.front()->sharedVertexData);
+		std::vector<const VertexData*> pool;
+		size_t numVertices = 0;
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			if (getVertexLayoutKey(sources[i]->sharedVertexData) == poolKey)
+			{
+				vertexOffsets[sources[i]] = numVertices;
+				pool.push_back(sources[i]->sharedVertexData);
+				numVertices += sources[i]->sharedVertexData->vertexCount;
+
+				if (mBaseSkeleton)
+				{
+					for (const auto& boneAssignment : sources[i]->getBoneAssignments())
 					{
-						newanim = mp->getAnimation(anim->getName());
+						VertexBoneAssignment vba = boneAssignment.second;
+						vba.vertexIndex = static_cast<unsigned int>(
+							vba.vertexIndex + vertexOffsets[sources[i]]);
+						mesh->addBoneAssignment(vba);
 					}
-					else
+				}
+			}
+		}
+		mesh->sharedVertexData = pool.size() == 1
+			? pool.front()->clone() : concatenateVertexData(pool);
+		print("Baking: merged shared vertices of " + StringConverter::toString(pool.size())
+			+ " meshes", V_HIGH);
+
+		const bool use32BitIndices = numVertices > 65536;
+		for (SharedSubMeshList::const_iterator it = subs.begin(); it != subs.end(); ++it)
+		{
+			SubMesh* sub = it->first;
+			SharedOffsetMap::const_iterator offset = vertexOffsets.find(it->second);
+			if (offset != vertexOffsets.end())
+			{
+				rebaseIndexData(sub->indexData, offset->second, use32BitIndices);
+				continue;
+			}
+
+			// The layout doesn't fit the pool, so the submesh gets its own copy.
+			sub->useSharedVertices = false;
+			sub->vertexData = it->second->sharedVertexData->clone();
+			if (mBaseSkeleton)
+			{
+				for (const auto& boneAssignment : it->second->getBoneAssignments())
+				{
+					sub->addBoneAssignment(boneAssignment.second);
+				}
+			}
+			print("Baking: shared vertices of " + it->second->getName()
+				+ " don't match the merged layout, copied into submesh", V_HIGH);
+		}
+	}
+
+	void MeshMergeTool::mergeVertexAnimation(MeshPtr mesh, MeshPtr source,
+		const std::vector<unsigned short>& handles, const SharedOffsetMap& sharedOffsets) const
+	{
+		// Shared vertices can only be animated, if they went into the merged pool.
+		const SharedOffsetMap::const_iterator sharedOffset = sharedOffsets.find(source.get());
+		const bool hasSharedTarget = sharedOffset != sharedOffsets.end();
+		// Morph key frames hold all vertices of their target, so the pool has to consist
+		// of this mesh's vertices alone.
+		const bool canMorphShared = hasSharedTarget
+			&& mesh->sharedVertexData->vertexCount == source->sharedVertexData->vertexCount;
+
+		const unsigned short NO_POSE = 0xffff;
+		std::vector<unsigned short> poseIndices(source->getPoseCount(), NO_POSE);
+		for (unsigned short i = 0; i < source->getPoseCount(); ++i)
+		{
+			const Pose* pose = source->getPose(i);
+			unsigned short target = pose->getTarget();
+			size_t vertexOffset = 0;
+			if (target == 0)
+			{
+				if (!hasSharedTarget)
+				{
+					warn("Pose " + pose->getName() + " of " + source->getName()
+						+ " targets shared vertices, which could not be merged. Skipped.");
+					continue;
+				}
+				vertexOffset = sharedOffset->second;
+			}
+			else
+			{
+				target = handles[target - 1];
+			}
+
+			poseIndices[i] = mesh->getPoseCount();
+			copyPose(mesh->createPose(target, pose->getName()), pose, vertexOffset);
+		}
+
+		for (unsigned short i = 0; i < source->getNumAnimations(); ++i)
+		{
+			Animation* anim = source->getAnimation(i);
+			if (anim->getNumVertexTracks() == 0)
+			{
+				continue;
+			}
+
+			// get or create the animation for the new mesh
+			Animation* newanim;
+			if (mesh->hasAnimation(anim->getName()))
+			{
+				newanim = mesh->getAnimation(anim->getName());
+				newanim->setLength(std::max(newanim->getLength(), anim->getLength()));
+			}
+			else
+			{
+				newanim = mesh->createAnimation(anim->getName(), anim->getLength());
+			}
+
+			print("Baking: adding vertex animation "
+				+ anim->getName() + " for " + source->getName(), V_HIGH);
+
+			Animation::VertexTrackIterator vti = anim->getVertexTrackIterator();
+			while (vti.hasMoreElements())
+			{
+				VertexAnimationTrack* vt = vti.getNext();
+
+				// handle=0 targets the shared vertices, handle i (where i>0) targets submesh i-1.
+				unsigned short handle = vt->getHandle();
+				if (handle == 0)
+				{
+					if (!hasSharedTarget || (vt->getAnimationType() == VAT_MORPH && !canMorphShared))
 					{
-						newanim = mp->createAnimation(anim->getName(), anim->getLength());
+						warn("Vertex animation " + anim->getName() + " of " + source->getName()
+							+ " targets shared vertices, which could not be merged. Skipped.");
+						continue;
 					}
+				}
+				else
+				{
+					handle = handles[handle - 1];
+				}
 
-					print("Baking: adding vertex animation "
-						+ anim->getName() + " for " + (*it)->getName(), V_HIGH);
+				// Pose tracks of several meshes may target the merged shared vertices.
+				VertexAnimationTrack* newvt = newanim->hasVertexTrack(handle)
+					? newanim->getVertexTrack(handle)
+					: newanim->createVertexTrack(handle, vt->getAnimationType());
+				if (newvt->getAnimationType() != vt->getAnimationType())
+				{
+					warn("Vertex animation " + anim->getName() + " of " + source->getName()
+						+ " mixes morph and pose animation on shared vertices. Skipped.");
+					continue;
+				}
 
-					Animation::VertexTrackIterator vti=anim->getVertexTrackIterator();
-					while (vti.hasMoreElements())
+				for (unsigned short k = 0; k < vt->getNumKeyFrames(); ++k)
+				{
+					if (vt->getAnimationType() == VAT_MORPH)
+					{
+						VertexMorphKeyFrame* kf = vt->getVertexMorphKeyFrame(k);
+						VertexMorphKeyFrame* newkf = newvt->createVertexMorphKeyFrame(kf->getTime());
+						// This creates a ref to the buffer in the original model
+						// so don't delete it until the export is completed.
+						newkf->setVertexBuffer(kf->getVertexBuffer());
+					}
+					else if (vt->getAnimationType() == VAT_POSE)
 					{
-						VertexAnimationTrack *vt = vti.getNext();
-
-						// handle=0 targets the main mesh, handle i (where i>0) targets submesh i-1.
-						// In this case there are only submeshes so index 0 will not be used.
-						unsigned short handle = mp->getNumSubMeshes();
-						VertexAnimationTrack* newvt = newanim->createVertexTrack(
-								handle,
-								vt->getAssociatedVertexData()->clone(),
-								vt->getAnimationType());
-						for (int keyFrameIndex = 0; keyFrameIndex < vt->getNumKeyFrames();
-							++keyFrameIndex)
+						VertexPoseKeyFrame* kf = vt->getVertexPoseKeyFrame(k);
+						VertexPoseKeyFrame* newkf = NULL;
+						for (unsigned short n = 0; n < newvt->getNumKeyFrames() && newkf == NULL; ++n)
 						{
-							switch (vt->getAnimationType())
+							if (Math::RealEqual(newvt->getKeyFrame(n)->getTime(), kf->getTime()))
 							{
-								case VAT_MORPH:
-								{
-									// copy the keyframe vertex buffer
-									VertexMorphKeyFrame *kf =
-										vt->getVertexMorphKeyFrame(keyFrameIndex);
-									VertexMorphKeyFrame *newkf =
-										newvt->createVertexMorphKeyFrame(kf->getTime());
-									// This creates a ref to the buffer in the original model
-									// so don't delete it until the export is completed.
-									newkf->setVertexBuffer(kf->getVertexBuffer());
-									break;
-								}
-								case VAT_POSE:
-								{
-									/// @todo implement pose amination merge
-									break;
-								}
-								case VAT_NONE:
-								default:
-								{
-									break;
-								}
+								newkf = newvt->getVertexPoseKeyFrame(n);
+							}
+						}
+						if (newkf == NULL)
+						{
+							newkf = newvt->createVertexPoseKeyFrame(kf->getTime());
+						}
+
+						const VertexPoseKeyFrame::PoseRefList& refs = kf->getPoseReferences();
+						for (VertexPoseKeyFrame::PoseRefList::const_iterator ref = refs.begin();
+							ref != refs.end(); ++ref)
+						{
+							if (ref->poseIndex < poseIndices.size()
+								&& poseIndices[ref->poseIndex] != NO_POSE)
+							{
+								newkf->addPoseReference(poseIndices[ref->poseIndex], ref->influence);
 							}
 						}
 					}
 				}
+			}
+		}
+	}
 
-				print("Baking: adding submesh '" +
-					name + "'  with material " + sub->getMaterialName(), V_HIGH);
+	void MeshMergeTool::copyPose(Pose* newPose, const Pose* pose, size_t vertexOffset) const
+	{
+		const Pose::VertexOffsetMap& offsets = pose->getVertexOffsets();
+		const Pose::NormalsMap& normals = pose->getNormals();
+		const Real squaredTolerance = mPoseTolerance * mPoseTolerance;
+		size_t numDropped = 0;
+		for (Pose::VertexOffsetMap::const_iterator it = offsets.begin(); it != offsets.end(); ++it)
+		{
+			const Vector3 offset = quantise(it->second, mPosePrecision);
+			Pose::NormalsMap::const_iterator normal = normals.find(it->first);
+			const Vector3 normalOffset = normal == normals.end()
+				? Vector3::ZERO : quantise(normal->second, mPosePrecision);
+
+			// Vertices not moved by the pose needn't be stored at all.
+			if (offset.squaredLength() <= squaredTolerance
+				&& normalOffset.squaredLength() <= squaredTolerance)
+			{
+				++numDropped;
+				continue;
 			}
 
-			// sharedvertices
-			if ((*it)->sharedVertexData)
+			if (pose->getIncludesNormals())
 			{
-				/// @todo merge with existing sharedVertexData
-				if (!mp->sharedVertexData)
-				{
-					mp->sharedVertexData = (*it)->sharedVertexData->clone();
-				}
+				newPose->addVertex(it->first + vertexOffset, offset, normalOffset);
+			}
+			else
+			{
+				newPose->addVertex(it->first + vertexOffset, offset);
+			}
+		}
 
-				if (mBaseSkeleton)
+		if (numDropped > 0)
+		{
+			print("Pose " + pose->getName() + ": dropped " + StringConverter::toString(numDropped)
+				+ " of " + StringConverter::toString(offsets.size()) + " offsets", V_HIGH);
+		}
+	}
+
+	Vector3 MeshMergeTool::quantise(const Vector3& v, Real step)
+	{
+		if (step <= 0)
+		{
+			return v;
+		}
+		return Vector3(std::floor(v.x / step + 0.5f) * step,
+			std::floor(v.y / step + 0.5f) * step, std::floor(v.z / step + 0.5f) * step);
+	}
+
+	void MeshMergeTool::packSingleBuffer(MeshPtr mesh) const
+	{
+		// Morph key frames hold one position per vertex and replace the buffer holding
+		// the positions, so morphed shared vertices can neither grow nor be interleaved.
+		// Being the only vertex data submeshes can share, nothing can be packed then.
+		for (unsigned short a = 0; a < mesh->getNumAnimations(); ++a)
+		{
+			Animation* anim = mesh->getAnimation(a);
+			if (mesh->sharedVertexData && anim->hasVertexTrack(0)
+				&& anim->getVertexTrack(0)->getAnimationType() == VAT_MORPH)
+			{
+				warn("Shared vertices have morph animation, submeshes kept in their own buffers.");
+				return;
+			}
+		}
+
+		std::vector<const VertexData*> vertexDatas;
+		std::vector<SubMesh*> movedSubs;
+		String key;
+		if (mesh->sharedVertexData)
+		{
+			vertexDatas.push_back(mesh->sharedVertexData);
+			key = getVertexLayoutKey(mesh->sharedVertexData);
+		}
+		for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+		{
+			SubMesh* sub = mesh->getSubMesh(i);
+			if (sub->useSharedVertices || sub->vertexData == NULL)
+			{
+				continue;
+			}
+
+			// Vertex animation and poses target the submesh's own vertex data.
+			bool isAnimated = false;
+			for (unsigned short a = 0; a < mesh->getNumAnimations() && !isAnimated; ++a)
+			{
+				isAnimated = mesh->getAnimation(a)->hasVertexTrack(i + 1);
+			}
+			for (unsigned short p = 0; p < mesh->getPoseCount() && !isAnimated; ++p)
+			{
+				isAnimated = mesh->getPose(p)->getTarget() == i + 1;
+			}
+			if (isAnimated)
+			{
+				warn("Submesh " + StringConverter::toString(i)
+					+ " is animated, kept in its own buffer.");
+				continue;
+			}
+
+			// The first unanimated vertex data sets the layout the others have to match.
+			const String subKey = getVertexLayoutKey(sub->vertexData);
+			if (key.empty())
+			{
+				key = subKey;
+			}
+			if (subKey != key)
+			{
+				warn("Submesh " + StringConverter::toString(i)
+					+ " has a different vertex layout, kept in its own buffer.");
+				continue;
+			}
+			vertexDatas.push_back(sub->vertexData);
+			movedSubs.push_back(sub);
+		}
+		if (vertexDatas.empty())
+		{
+			return;
+		}
+
+		VertexData* vd = vertexDatas.size() == 1
+			? vertexDatas.front()->clone() : concatenateVertexData(vertexDatas);
+		const bool use32BitIndices = vd->vertexCount > 65536;
+		size_t vertexOffset = 0;
+		if (mesh->sharedVertexData)
+		{
+			for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+			{
+				if (mesh->getSubMesh(i)->useSharedVertices)
 				{
-					for (const auto& boneAssignment : (*it)->getBoneAssignments ())
-						mp->addBoneAssignment (boneAssignment.second);
+					rebaseIndexData(mesh->getSubMesh(i)->indexData, 0, use32BitIndices);
 				}
 			}
+			vertexOffset = mesh->sharedVertexData->vertexCount;
+			OGRE_DELETE mesh->sharedVertexData;
+		}
+		for (size_t i = 0; i < movedSubs.size(); ++i)
+		{
+			SubMesh* sub = movedSubs[i];
+			rebaseIndexData(sub->indexData, vertexOffset, use32BitIndices);
+			for (const auto& boneAssignment : sub->getBoneAssignments())
+			{
+				VertexBoneAssignment vba = boneAssignment.second;
+				vba.vertexIndex = static_cast<unsigned int>(vba.vertexIndex + vertexOffset);
+				mesh->addBoneAssignment(vba);
+			}
+			sub->clearBoneAssignments();
+			vertexOffset += sub->vertexData->vertexCount;
+			OGRE_DELETE sub->vertexData;
+			sub->vertexData = NULL;
+			sub->useSharedVertices = true;
+		}
+		mesh->sharedVertexData = vd;
 
-			print("Baking: adding bounds for " + (*it)->getName(), V_HIGH);
-
-			// add bounds
-			totalBounds.merge((*it)->getBounds());
+		// Interleave all elements into a single buffer. Morphed vertex data never gets
+		// here, see above.
+		if (vd->vertexBufferBinding->getBufferCount() > 1)
+		{
+			VertexDeclaration* decl =
+				HardwareBufferManager::getSingleton().createVertexDeclaration();
+			size_t elementOffset = 0;
+			const VertexDeclaration::VertexElementList& elements =
+				vd->vertexDeclaration->getElements();
+			for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+				it != elements.end(); ++it)
+			{
+				decl->addElement(0, elementOffset, it->getType(), it->getSemantic(), it->getIndex());
+				elementOffset += it->getSize();
+			}
+			vd->reorganiseBuffers(decl);
 		}
-		mp->_setBounds(totalBounds);
+		print("Baking: packed " + StringConverter::toString(vd->vertexCount)
+			+ " vertices of " + StringConverter::toString(movedSubs.size())
+			+ " submeshes into a single buffer", V_HIGH);
+	}
 
-		/// @todo merge submeshes with same material
+	void MeshMergeTool::weldVertices(MeshPtr mesh) const
+	{
+		VertexWelder welder(mWeldTolerance, mWeldAttributeTolerance, mWeldAttributeTolerance);
 
-		/// @todo add parameters
-		mp->buildEdgeList();
+		// handle=0 stands for the shared vertex data, handle i (where i>0) for submesh i-1.
+		for (unsigned short handle = 0; handle <= mesh->getNumSubMeshes(); ++handle)
+		{
+			VertexData* vd = handle == 0
+				? mesh->sharedVertexData : mesh->getSubMesh(handle - 1)->vertexData;
+			if (vd == NULL || (handle > 0 && mesh->getSubMesh(handle - 1)->useSharedVertices))
+			{
+				continue;
+			}
 
-		print("Baking: Finished", V_HIGH);
+			// Poses store offsets by vertex index, which can't be remapped sensibly.
+			bool hasPose = false;
+			for (unsigned short i = 0; i < mesh->getPoseCount() && !hasPose; ++i)
+			{
+				hasPose = mesh->getPose(i)->getTarget() == handle;
+			}
+			if (hasPose)
+			{
+				warn("Vertex data " + StringConverter::toString(handle)
+					+ " is targeted by poses, not welded.");
+				continue;
+			}
 
-		reset();
+			std::vector<IndexData*> indexDatas;
+			for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+			{
+				SubMesh* sub = mesh->getSubMesh(i);
+				if (handle == 0 ? sub->useSharedVertices : i == handle - 1)
+				{
+					indexDatas.push_back(sub->indexData);
+				}
+			}
 
-		return mp;
+			std::vector<VertexAnimationTrack*> morphTracks;
+			for (unsigned short i = 0; i < mesh->getNumAnimations(); ++i)
+			{
+				Animation* anim = mesh->getAnimation(i);
+				if (anim->hasVertexTrack(handle)
+					&& anim->getVertexTrack(handle)->getAnimationType() == VAT_MORPH)
+				{
+					morphTracks.push_back(anim->getVertexTrack(handle));
+				}
+			}
+
+			Mesh::VertexBoneAssignmentList boneAssignments = handle == 0
+				? mesh->getBoneAssignments() : mesh->getSubMesh(handle - 1)->getBoneAssignments();
+
+			const size_t numVertices = vd->vertexCount;
+			const size_t numWelded = welder.weld(vd, indexDatas, boneAssignments, morphTracks);
+			if (numWelded == 0)
+			{
+				continue;
+			}
+
+			if (handle == 0)
+			{
+				mesh->clearBoneAssignments();
+			}
+			else
+			{
+				mesh->getSubMesh(handle - 1)->clearBoneAssignments();
+			}
+			for (Mesh::VertexBoneAssignmentList::const_iterator it = boneAssignments.begin();
+				it != boneAssignments.end(); ++it)
+			{
+				if (handle == 0)
+				{
+					mesh->addBoneAssignment(it->second);
+				}
+				else
+				{
+					mesh->getSubMesh(handle - 1)->addBoneAssignment(it->second);
+				}
+			}
+
+			print("Baking: welded " + StringConverter::toString(numVertices) + " vertices into "
+				+ StringConverter::toString(vd->vertexCount) + " for "
+				+ (handle == 0 ? String("shared vertices")
+					: "submesh " + StringConverter::toString(handle - 1)), V_HIGH);
+		}
 	}
 
 	void MeshMergeTool::reset()
@@ -47,12 +47,62 @@ namespace meshmagick
     OptionDefinitionSet MeshMergeToolFactory::getOptionDefinitions() const
     {
         OptionDefinitionSet optionDefs;
+        optionDefs.insert(OptionDefinition("merge-submeshes", OT_BOOL, false, false));
+        optionDefs.insert(OptionDefinition("single-buffer", OT_BOOL, false, false));
+        optionDefs.insert(OptionDefinition("weld", OT_REAL, false, false, Any(Real(1e-4))));
+        optionDefs.insert(OptionDefinition("weld-attribute-tolerance", OT_REAL, false, false,
+            Any(Real(1e-2))));
+        optionDefs.insert(OptionDefinition("pose-tolerance", OT_REAL, false, false));
+        optionDefs.insert(OptionDefinition("pose-precision", OT_REAL, false, false));
+        optionDefs.insert(OptionDefinition("cell-size", OT_VECTOR3, false, false));
+        optionDefs.insert(OptionDefinition("placements", OT_STRING, false, false));
+        optionDefs.insert(OptionDefinition("instancing", OT_INT, false, false, Any(2)));
         return optionDefs;
     }
     //------------------------------------------------------------------------
 
     void MeshMergeToolFactory::printToolHelp(std::ostream& out) const
     {
+        out << std::endl;
+        out << "Merges multiple meshes into a single mesh" << std::endl << std::endl;
+        out << "usage: meshmagick meshmerge [options] infile1 infile2 ... -- outfile" << std::endl
+            << std::endl;
+        out << "With -cell-size one mesh per grid cell is written instead, named" << std::endl
+            << "outfile_x_y_z.mesh after the cell's coordinates." << std::endl
+            << std::endl;
+        out << "All input meshes must use the same skeleton or none at all." << std::endl
+            << std::endl;
+        out << "Options:" << std::endl;
+        out << "   -merge-submeshes - Merge submeshes with the same material, operation type" << std::endl
+            << "                      and vertex declaration into one submesh. Submeshes using" << std::endl
+            << "                      shared vertices, strips, fans and submeshes with vertex" << std::endl
+            << "                      animation or poses are kept as they are." << std::endl
+            << "   -single-buffer   - Pack all vertices into one shared buffer, so the whole" << std::endl
+            << "                      mesh binds a single vertex buffer. Submeshes with" << std::endl
+            << "                      vertex animation, poses or a different vertex" << std::endl
+            << "                      declaration keep their own vertices." << std::endl
+            << "   -weld[=tolerance] - Collapse vertices, whose positions lie within tolerance" << std::endl
+            << "                      (default 1e-4) and whose other attributes, bone" << std::endl
+            << "                      assignments and morph positions match. Combine with" << std::endl
+            << "                      -merge-submeshes to weld across input meshes." << std::endl
+            << "   -weld-attribute-tolerance=val - Tolerance for normals, tangents and" << std::endl
+            << "                      texture coordinates when welding (default 1e-2)." << std::endl
+            << "   -pose-tolerance=val - Drop pose offsets not longer than val. Offsets of" << std::endl
+            << "                      zero are always dropped." << std::endl
+            << "   -pose-precision=step - Round pose offsets to multiples of step." << std::endl
+            << "   -placements=file - Place meshes as listed in file before merging. Each" << std::endl
+            << "                      line holds a mesh file name, a tab, the translation" << std::endl
+            << "                      x y z, the orientation w x y z and optionally the" << std::endl
+            << "                      scale s or x y z. A mesh may be listed many times." << std::endl
+            << "                      Input files given on the command line are placed" << std::endl
+            << "                      as they are." << std::endl
+            << "   -cell-size=x/y/z - Batch placed meshes by the grid cell their bounds'" << std::endl
+            << "                      centre lies in. Implies -merge-submeshes, so each" << std::endl
+            << "                      cell mesh has one submesh per material." << std::endl
+            << "   -instancing[=min] - Don't merge mesh files placed at least min times" << std::endl
+            << "                      (default 2). Their transformations are written to" << std::endl
+            << "                      outfile.instances for hardware instancing instead." << std::endl
+            << std::endl;
     }
     //------------------------------------------------------------------------
 
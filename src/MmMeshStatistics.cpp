@@ -0,0 +1,396 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmMeshStatistics.h"
+
+#include <OgreStringConverter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+using namespace Ogre;
+
+namespace meshmagick
+{
+    namespace
+    {
+        /// Right aligned, fixed point number column for the report tables.
+        String formatColumn(double value, unsigned short width = 12, unsigned short precision = 1)
+        {
+            return StringConverter::toString(Real(value), precision, width, ' ',
+                std::ios::fmtflags(std::ios_base::fixed));
+        }
+
+        String formatColumn(const String& value, unsigned short width)
+        {
+            return value.size() >= width ? value : String(width - value.size(), ' ') + value;
+        }
+
+        String formatLabel(const String& label, size_t width = 28)
+        {
+            return label.size() >= width ? label + " " : label + String(width - label.size(), ' ');
+        }
+    }
+    //------------------------------------------------------------------------
+
+    LogHistogram::LogHistogram()
+        : mCount(0), mSum(0.0),
+          mMin(std::numeric_limits<double>::max()),
+          mMax(-std::numeric_limits<double>::max())
+    {
+        std::fill(mBuckets, mBuckets + NUM_BUCKETS, 0);
+    }
+    //------------------------------------------------------------------------
+
+    void LogHistogram::add(double value)
+    {
+        ++mBuckets[getBucket(value)];
+        ++mCount;
+        mSum += value;
+        mMin = std::min(mMin, value);
+        mMax = std::max(mMax, value);
+    }
+    //------------------------------------------------------------------------
+
+    size_t LogHistogram::getCount() const
+    {
+        return mCount;
+    }
+    //------------------------------------------------------------------------
+
+    double LogHistogram::getMin() const
+    {
+        return mCount > 0 ? mMin : 0.0;
+    }
+    //------------------------------------------------------------------------
+
+    double LogHistogram::getMax() const
+    {
+        return mCount > 0 ? mMax : 0.0;
+    }
+    //------------------------------------------------------------------------
+
+    double LogHistogram::getMean() const
+    {
+        return mCount > 0 ? mSum / mCount : 0.0;
+    }
+    //------------------------------------------------------------------------
+
+    double LogHistogram::getPercentile(double p) const
+    {
+        if (mCount == 0)
+        {
+            return 0.0;
+        }
+        if (p <= 0.0)
+        {
+            return mMin;
+        }
+        if (p >= 100.0)
+        {
+            return mMax;
+        }
+
+        // 0-based rank of the requested value, then find the bucket holding it and
+        // assume values are spread evenly inside the bucket.
+        const double rank = p / 100.0 * (mCount - 1);
+        size_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i)
+        {
+            const size_t n = mBuckets[i];
+            if (n == 0)
+            {
+                continue;
+            }
+            if (rank < seen + n)
+            {
+                const double lo = std::max(getBucketMin(i), mMin);
+                const double hi = std::min(getBucketMax(i), mMax);
+                const double fraction = (rank - seen + 0.5) / n;
+                return lo + (hi - lo) * fraction;
+            }
+            seen += n;
+        }
+        return mMax;
+    }
+    //------------------------------------------------------------------------
+
+    size_t LogHistogram::getBucketCount(size_t bucket) const
+    {
+        return mBuckets[bucket];
+    }
+    //------------------------------------------------------------------------
+
+    double LogHistogram::getBucketMin(size_t bucket)
+    {
+        return bucket == 0 ? 0.0 : std::ldexp(1.0, static_cast<int>(bucket) - 1);
+    }
+    //------------------------------------------------------------------------
+
+    double LogHistogram::getBucketMax(size_t bucket)
+    {
+        return std::ldexp(1.0, static_cast<int>(bucket));
+    }
+    //------------------------------------------------------------------------
+
+    size_t LogHistogram::getBucket(double value)
+    {
+        if (!(value >= 1.0))
+        {
+            return 0;
+        }
+        // value = m * 2^e, m in [0.5, 1) => value in [2^(e-1), 2^e)
+        int e = 0;
+        std::frexp(value, &e);
+        return std::min(static_cast<size_t>(e), NUM_BUCKETS - 1);
+    }
+    //------------------------------------------------------------------------
+
+    MeshStatistics::MeshStatistics(size_t numTopMeshes)
+        : mNumTopMeshes(numTopMeshes), mNumMeshes(0), mNumSkeletons(0)
+    {
+    }
+    //------------------------------------------------------------------------
+
+    void MeshStatistics::addMesh(const MeshInfo& info)
+    {
+        ++mNumMeshes;
+
+        mVertexCounts.add(static_cast<double>(info.numVertices));
+        mTriangleCounts.add(static_cast<double>(info.numTrianlges));
+        mLodLevels.add(info.numLodLevels);
+
+        if (info.hasSharedVertices)
+        {
+            addVertexInfo(info.sharedVertices);
+        }
+        for (size_t i = 0; i < info.submeshes.size(); ++i)
+        {
+            const SubMeshInfo& submesh = info.submeshes[i];
+            if (!submesh.usesSharedVertices)
+            {
+                addVertexInfo(submesh.vertices);
+            }
+            if (submesh.numIndices > 0)
+            {
+                ++mIndexWidths[submesh.indexBitWidth];
+            }
+        }
+
+        for (size_t i = 0; i < info.morphAnimations.size(); ++i)
+        {
+            mAnimationLengths.add(info.morphAnimations[i].second * 1000.0);
+        }
+
+        const size_t memory = getMeshMemory(info);
+        mMeshMemory.add(static_cast<double>(memory));
+
+        // Keep the N heaviest. The heap's top is the lightest of them.
+        if (mNumTopMeshes > 0)
+        {
+            if (mTopMeshes.size() < mNumTopMeshes)
+            {
+                mTopMeshes.push_back(MemoryEntry(memory, info.name));
+                std::push_heap(mTopMeshes.begin(), mTopMeshes.end(),
+                    std::greater<MemoryEntry>());
+            }
+            else if (memory > mTopMeshes.front().first)
+            {
+                std::pop_heap(mTopMeshes.begin(), mTopMeshes.end(),
+                    std::greater<MemoryEntry>());
+                mTopMeshes.back() = MemoryEntry(memory, info.name);
+                std::push_heap(mTopMeshes.begin(), mTopMeshes.end(),
+                    std::greater<MemoryEntry>());
+            }
+        }
+    }
+    //------------------------------------------------------------------------
+
+    void MeshStatistics::addSkeleton(const SkeletonInfo& info)
+    {
+        ++mNumSkeletons;
+
+        mBoneCounts.add(static_cast<double>(info.boneNames.size()));
+        for (size_t i = 0; i < info.animations.size(); ++i)
+        {
+            mAnimationLengths.add(info.animations[i].second * 1000.0);
+        }
+    }
+    //------------------------------------------------------------------------
+
+    void MeshStatistics::addVertexInfo(const VertexInfo& info)
+    {
+        mBytesPerVertex.add(static_cast<double>(info.bytesPerVertex));
+        if (info.numBoneAssignments > 0)
+        {
+            mBonesReferenced.add(static_cast<double>(info.numBonesReferenced));
+            mInfluences.add(static_cast<double>(info.numBoneAssignments));
+        }
+
+        std::pair<size_t, size_t>& layout = mLayouts[info.layout];
+        layout.first = info.bytesPerVertex;
+        ++layout.second;
+    }
+    //------------------------------------------------------------------------
+
+    size_t MeshStatistics::getMeshMemory(const MeshInfo& info)
+    {
+        return info.vertexBufferBytes + info.indexBufferBytes;
+    }
+    //------------------------------------------------------------------------
+
+    StringVector MeshStatistics::getReport() const
+    {
+        StringVector lines;
+        lines.push_back("Aggregate statistics for " + StringConverter::toString(mNumMeshes)
+            + " meshes and " + StringConverter::toString(mNumSkeletons) + " skeletons.");
+        lines.push_back("");
+
+        lines.push_back(formatLabel("") + formatColumn("count", 12) + formatColumn("min", 12)
+            + formatColumn("p50", 12) + formatColumn("p90", 12) + formatColumn("p99", 12)
+            + formatColumn("max", 12) + formatColumn("mean", 12));
+        appendHistogramSummary(lines, "vertices per mesh", mVertexCounts);
+        appendHistogramSummary(lines, "triangles per mesh", mTriangleCounts);
+        appendHistogramSummary(lines, "bytes per mesh", mMeshMemory);
+        appendHistogramSummary(lines, "bytes per vertex", mBytesPerVertex);
+        appendHistogramSummary(lines, "LOD levels", mLodLevels);
+        appendHistogramSummary(lines, "bones referenced", mBonesReferenced);
+        appendHistogramSummary(lines, "influences per vertex", mInfluences);
+        appendHistogramSummary(lines, "bones per skeleton", mBoneCounts);
+        appendHistogramSummary(lines, "animation length (ms)", mAnimationLengths);
+        lines.push_back("");
+
+        // Index widths
+        size_t numIndexBuffers = 0;
+        for (CountMap::const_iterator it = mIndexWidths.begin(); it != mIndexWidths.end(); ++it)
+        {
+            numIndexBuffers += it->second;
+        }
+        lines.push_back("Index widths:");
+        for (CountMap::const_iterator it = mIndexWidths.begin(); it != mIndexWidths.end(); ++it)
+        {
+            lines.push_back("    " + StringConverter::toString(it->first) + " bit: "
+                + StringConverter::toString(it->second) + " submeshes ("
+                + formatColumn(100.0 * it->second / numIndexBuffers, 0) + "%)");
+        }
+        lines.push_back("");
+
+        // Vertex layouts, most frequent first.
+        std::vector<std::pair<size_t, LayoutMap::const_iterator> > layouts;
+        for (LayoutMap::const_iterator it = mLayouts.begin(); it != mLayouts.end(); ++it)
+        {
+            layouts.push_back(std::make_pair(it->second.second, it));
+        }
+        std::stable_sort(layouts.begin(), layouts.end(),
+            [](const std::pair<size_t, LayoutMap::const_iterator>& lhs,
+               const std::pair<size_t, LayoutMap::const_iterator>& rhs)
+            {
+                return lhs.first > rhs.first;
+            });
+        lines.push_back("Vertex layouts:");
+        lines.push_back(formatColumn("count", 12) + formatColumn("bytes", 8) + "  layout");
+        for (size_t i = 0; i < layouts.size(); ++i)
+        {
+            lines.push_back(formatColumn(StringConverter::toString(layouts[i].first), 12)
+                + formatColumn(StringConverter::toString(layouts[i].second->second.first), 8)
+                + "  " + layouts[i].second->first);
+        }
+        lines.push_back("");
+
+        // Heaviest meshes
+        std::vector<MemoryEntry> topMeshes = mTopMeshes;
+        std::sort(topMeshes.begin(), topMeshes.end(), std::greater<MemoryEntry>());
+        lines.push_back("Heaviest meshes by vertex and index buffer size:");
+        for (size_t i = 0; i < topMeshes.size(); ++i)
+        {
+            lines.push_back(formatColumn(StringConverter::toString(topMeshes[i].first), 12)
+                + "  " + topMeshes[i].second);
+        }
+        lines.push_back("");
+
+        appendHistogram(lines, "vertices per mesh", mVertexCounts);
+        appendHistogram(lines, "triangles per mesh", mTriangleCounts);
+        appendHistogram(lines, "bytes per mesh", mMeshMemory);
+        appendHistogram(lines, "bytes per vertex", mBytesPerVertex);
+        appendHistogram(lines, "LOD levels", mLodLevels);
+        appendHistogram(lines, "bones referenced", mBonesReferenced);
+        appendHistogram(lines, "influences per vertex", mInfluences);
+        appendHistogram(lines, "bones per skeleton", mBoneCounts);
+        appendHistogram(lines, "animation length (ms)", mAnimationLengths);
+
+        return lines;
+    }
+    //------------------------------------------------------------------------
+
+    void MeshStatistics::appendHistogramSummary(StringVector& lines, const String& name,
+        const LogHistogram& histogram) const
+    {
+        lines.push_back(formatLabel(name)
+            + formatColumn(StringConverter::toString(histogram.getCount()), 12)
+            + formatColumn(histogram.getMin())
+            + formatColumn(histogram.getPercentile(50.0))
+            + formatColumn(histogram.getPercentile(90.0))
+            + formatColumn(histogram.getPercentile(99.0))
+            + formatColumn(histogram.getMax())
+            + formatColumn(histogram.getMean()));
+    }
+    //------------------------------------------------------------------------
+
+    void MeshStatistics::appendHistogram(StringVector& lines, const String& name,
+        const LogHistogram& histogram) const
+    {
+        if (histogram.getCount() == 0)
+        {
+            return;
+        }
+
+        size_t maxCount = 0;
+        size_t firstBucket = LogHistogram::NUM_BUCKETS;
+        size_t lastBucket = 0;
+        for (size_t i = 0; i < LogHistogram::NUM_BUCKETS; ++i)
+        {
+            const size_t n = histogram.getBucketCount(i);
+            if (n > 0)
+            {
+                maxCount = std::max(maxCount, n);
+                firstBucket = std::min(firstBucket, i);
+                lastBucket = i;
+            }
+        }
+
+        const size_t barWidth = 40;
+        lines.push_back("Histogram of " + name + ":");
+        for (size_t i = firstBucket; i <= lastBucket; ++i)
+        {
+            const size_t n = histogram.getBucketCount(i);
+            lines.push_back("    ["
+                + formatColumn(LogHistogram::getBucketMin(i), 12, 0) + ", "
+                + formatColumn(LogHistogram::getBucketMax(i), 12, 0) + ")"
+                + formatColumn(StringConverter::toString(n), 10) + "  "
+                + String((n * barWidth + maxCount - 1) / maxCount, '#'));
+        }
+        lines.push_back("");
+    }
+}
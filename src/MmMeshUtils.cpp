@@ -23,10 +23,46 @@ THE SOFTWARE.
 
 #include "MmMeshUtils.h"
 
+#include <OgreHardwareBufferManager.h>
 #include <OgreSubMesh.h>
 
+#include <OgreStringConverter.h>
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+
 using namespace Ogre;
 
+namespace
+{
+    /// Element types the layout notation has a name for.
+    const VertexElementType LAYOUT_TYPES[] =
+    {
+        VET_FLOAT1, VET_FLOAT2, VET_FLOAT3, VET_FLOAT4,
+        VET_SHORT1, VET_SHORT2, VET_SHORT3, VET_SHORT4,
+        VET_UBYTE4,
+#if OGRE_VERSION_MAJOR < 3
+        VET_COLOUR_ARGB, VET_COLOUR_ABGR,
+#endif
+    };
+
+    /// Returns the semantic named by a letter of the layout notation, 0 if there is none.
+    VertexElementSemantic getLayoutSemantic(char letter)
+    {
+        for (int semantic = VES_POSITION; semantic <= VES_TANGENT; ++semantic)
+        {
+            if (meshmagick::MeshUtils::getElementLayoutString(
+                static_cast<VertexElementSemantic>(semantic), VET_FLOAT1)[0] == letter)
+            {
+                return static_cast<VertexElementSemantic>(semantic);
+            }
+        }
+        return static_cast<VertexElementSemantic>(0);
+    }
+}
+
 namespace meshmagick
 {
 	AxisAlignedBox MeshUtils::getMeshAabb(MeshPtr mesh, const Matrix4& transform)
@@ -74,4 +110,468 @@ namespace meshmagick
 
         return aabb;
     }
+
+    std::vector<uint32> MeshUtils::getIndices(const IndexData* indexData)
+    {
+        std::vector<uint32> indices;
+        if (indexData == NULL || indexData->indexCount == 0 || !indexData->indexBuffer)
+        {
+            return indices;
+        }
+
+        HardwareIndexBufferSharedPtr ib = indexData->indexBuffer;
+        indices.resize(indexData->indexCount);
+        if (ib->getType() == HardwareIndexBuffer::IT_32BIT)
+        {
+            const uint32* data = static_cast<const uint32*>(
+                ib->lock(HardwareBuffer::HBL_READ_ONLY)) + indexData->indexStart;
+            std::copy(data, data + indexData->indexCount, indices.begin());
+        }
+        else
+        {
+            const uint16* data = static_cast<const uint16*>(
+                ib->lock(HardwareBuffer::HBL_READ_ONLY)) + indexData->indexStart;
+            std::copy(data, data + indexData->indexCount, indices.begin());
+        }
+        ib->unlock();
+
+        return indices;
+    }
+
+    VertexCacheMetrics MeshUtils::getVertexCacheMetrics(const VertexData* vertexData,
+        const IndexData* indexData, RenderOperation::OperationType operationType,
+        size_t fifoSize, size_t lruSize)
+    {
+        const size_t CACHE_LINE_SIZE = 64;
+        const size_t LINE_CACHE_SIZE = 16 * 1024 / CACHE_LINE_SIZE;
+
+        VertexCacheMetrics metrics;
+
+        std::vector<uint32> indices = getIndices(indexData);
+        size_t numTriangles = 0;
+        switch (operationType)
+        {
+        case RenderOperation::OT_TRIANGLE_LIST:
+            numTriangles = indices.size() / 3;
+            break;
+        case RenderOperation::OT_TRIANGLE_STRIP:
+        case RenderOperation::OT_TRIANGLE_FAN:
+            numTriangles = indices.size() > 2 ? indices.size() - 2 : 0;
+            break;
+        default:
+            break;
+        }
+
+        const size_t vertexCount = vertexData->vertexCount;
+        if (numTriangles == 0 || vertexCount == 0 || fifoSize == 0 || lruSize == 0)
+        {
+            return metrics;
+        }
+
+        // Vertex buffers, fetched separately
+        std::vector<size_t> strides;
+        for (unsigned short source = 0, end = vertexData->vertexDeclaration->getMaxSource();
+            source <= end; ++source)
+        {
+            const size_t stride = vertexData->vertexDeclaration->getVertexSize(source);
+            if (stride > 0)
+            {
+                strides.push_back(stride);
+            }
+        }
+        size_t bytesPerVertex = 0;
+        std::vector<std::vector<size_t> > lineTimes(strides.size());
+        std::vector<size_t> lineClocks(strides.size(), 0);
+        for (size_t i = 0; i < strides.size(); ++i)
+        {
+            bytesPerVertex += strides[i];
+            lineTimes[i].resize((vertexCount * strides[i] + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE, 0);
+        }
+        size_t bytesFetched = 0;
+
+        // Timestamps are the miss count at the time the vertex entered the cache,
+        // a vertex is cached, if less than fifoSize vertices entered after it.
+        std::vector<size_t> fifoTimes(vertexCount, 0);
+        size_t fifoMisses = 0;
+
+        std::vector<uint32> lru;
+        lru.reserve(lruSize + 1);
+        size_t lruMisses = 0;
+
+        std::vector<bool> referenced(vertexCount, false);
+        size_t numReferenced = 0;
+
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            const uint32 index = indices[i];
+            if (index >= vertexCount)
+            {
+                continue;
+            }
+
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                ++numReferenced;
+            }
+
+            if (fifoTimes[index] == 0 || fifoMisses - fifoTimes[index] >= fifoSize)
+            {
+                fifoTimes[index] = ++fifoMisses;
+
+                for (size_t b = 0; b < strides.size(); ++b)
+                {
+                    const size_t first = index * strides[b] / CACHE_LINE_SIZE;
+                    const size_t last = (index * strides[b] + strides[b] - 1) / CACHE_LINE_SIZE;
+                    for (size_t line = first; line <= last; ++line)
+                    {
+                        if (lineTimes[b][line] == 0
+                            || lineClocks[b] - lineTimes[b][line] >= LINE_CACHE_SIZE)
+                        {
+                            lineTimes[b][line] = ++lineClocks[b];
+                            bytesFetched += CACHE_LINE_SIZE;
+                        }
+                    }
+                }
+            }
+
+            std::vector<uint32>::iterator it = std::find(lru.begin(), lru.end(), index);
+            if (it != lru.end())
+            {
+                lru.erase(it);
+            }
+            else
+            {
+                ++lruMisses;
+            }
+            lru.insert(lru.begin(), index);
+            if (lru.size() > lruSize)
+            {
+                lru.pop_back();
+            }
+        }
+
+        if (numReferenced == 0)
+        {
+            return metrics;
+        }
+
+        metrics.fifoAcmr = Real(fifoMisses) / numTriangles;
+        metrics.fifoAtvr = Real(fifoMisses) / numReferenced;
+        metrics.lruAcmr = Real(lruMisses) / numTriangles;
+        metrics.lruAtvr = Real(lruMisses) / numReferenced;
+        metrics.overfetch = bytesPerVertex > 0
+            ? Real(bytesFetched) / (numReferenced * bytesPerVertex) : 0;
+        metrics.unreferencedVertices = Real(vertexCount - numReferenced) / vertexCount;
+
+        return metrics;
+    }
+
+    Real MeshUtils::getUnreferencedVertices(const VertexData* vertexData,
+        const std::vector<const IndexData*>& indexDatas)
+    {
+        const size_t vertexCount = vertexData->vertexCount;
+        if (vertexCount == 0)
+        {
+            return 0;
+        }
+
+        std::vector<bool> referenced(vertexCount, false);
+        size_t numReferenced = 0;
+        for (size_t i = 0; i < indexDatas.size(); ++i)
+        {
+            std::vector<uint32> indices = getIndices(indexDatas[i]);
+            for (size_t j = 0; j < indices.size(); ++j)
+            {
+                if (indices[j] < vertexCount && !referenced[indices[j]])
+                {
+                    referenced[indices[j]] = true;
+                    ++numReferenced;
+                }
+            }
+        }
+        return Real(vertexCount - numReferenced) / vertexCount;
+    }
+
+    void MeshUtils::removeVertexElements(VertexData* vertexData, const std::vector<bool>& remove)
+    {
+        // Keep the order of the elements within their buffer.
+        std::vector<const VertexElement*> kept;
+        const VertexDeclaration::VertexElementList& elements =
+            vertexData->vertexDeclaration->getElements();
+        size_t i = 0;
+        for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+            it != elements.end(); ++it, ++i)
+        {
+            if (!remove[i])
+            {
+                kept.push_back(&*it);
+            }
+        }
+        std::stable_sort(kept.begin(), kept.end(),
+            [](const VertexElement* a, const VertexElement* b)
+            {
+                return a->getSource() != b->getSource() ?
+                    a->getSource() < b->getSource() : a->getOffset() < b->getOffset();
+            });
+
+        VertexDeclaration* decl = HardwareBufferManager::getSingleton().createVertexDeclaration();
+        std::map<unsigned short, size_t> sourceSizes;
+        for (size_t e = 0; e < kept.size(); ++e)
+        {
+            size_t& offset = sourceSizes[kept[e]->getSource()];
+            decl->addElement(kept[e]->getSource(), offset, kept[e]->getType(),
+                kept[e]->getSemantic(), kept[e]->getIndex());
+            offset += kept[e]->getSize();
+        }
+        decl->closeGapsInSource();
+        vertexData->reorganiseBuffers(decl);
+    }
+
+    String MeshUtils::getElementLayoutString(VertexElementSemantic semantic,
+        VertexElementType type)
+    {
+        String rval;
+        // Append char indicating the element semantic
+        switch (semantic)
+        {
+        case VES_POSITION:
+            rval += "p";
+            break;
+        case VES_BLEND_WEIGHTS:
+            rval += "w";
+            break;
+        case VES_BLEND_INDICES:
+            rval += "i";
+            break;
+        case VES_NORMAL:
+            rval += "n";
+            break;
+        case VES_DIFFUSE:
+            rval += "d";
+            break;
+        case VES_SPECULAR:
+            rval += "s";
+            break;
+        case VES_TEXTURE_COORDINATES:
+            rval += "u";
+            break;
+        case VES_BINORMAL:
+            rval += "b";
+            break;
+        case VES_TANGENT:
+            rval += "t";
+            break;
+        }
+        // Append substring indicating the element type
+        switch (type)
+        {
+        case VET_FLOAT1:
+            rval += "(f1)";
+            break;
+        case VET_FLOAT2:
+            rval += "(f2)";
+            break;
+        case VET_FLOAT3:
+            rval += "(f3)";
+            break;
+        case VET_FLOAT4:
+            rval += "(f4)";
+            break;
+        case VET_SHORT1:
+            rval += "(s1)";
+            break;
+        case VET_SHORT2:
+            rval += "(s2)";
+            break;
+        case VET_SHORT3:
+            rval += "(s3)";
+            break;
+        case VET_SHORT4:
+            rval += "(s4)";
+            break;
+        case VET_UBYTE4:
+            rval += "(u4)";
+            break;
+#if OGRE_VERSION_MAJOR < 3
+        case VET_COLOUR_ARGB:
+            rval += "(bgra)";
+            break;
+        case VET_COLOUR_ABGR:
+            rval += "(rgba)";
+            break;
+        case VET_COLOUR:
+            // Doesn't appear at runtime, so don't handle
+            break;
+#endif
+        }
+        return rval;
+    }
+
+    String MeshUtils::getVertexLayoutString(const VertexDeclaration* decl)
+    {
+        // First: source-ID, second: offset
+        typedef std::pair<unsigned short, size_t> ElementPosition;
+        typedef std::map<ElementPosition, const VertexElement*> ElementMap;
+
+        // We don't know in what order the elements are stored, but in order to create
+        // the layout string we need them in order of their source and offset.
+        ElementMap elements;
+        const VertexDeclaration::VertexElementList& elementList = decl->getElements();
+        for (VertexDeclaration::VertexElementList::const_iterator it = elementList.begin(),
+            end = elementList.end(); it != end; ++it)
+        {
+            elements[std::make_pair(it->getSource(), it->getOffset())] = &*it;
+        }
+
+        String layout;
+        unsigned short source = 0;
+        std::map<VertexElementSemantic, unsigned short> semanticCounts;
+        for (ElementMap::const_iterator it = elements.begin(), end = elements.end();
+            it != end; ++it)
+        {
+            // If source changed, we append a hyphen to indicate a new buffer.
+            if (it->first.first != source)
+            {
+                layout += '-';
+                source = it->first.first;
+            }
+
+            const VertexElement* elem = it->second;
+            String elemString = getElementLayoutString(elem->getSemantic(), elem->getType());
+            // The index is implied by the order, unless it deviates.
+            unsigned short& count = semanticCounts[elem->getSemantic()];
+            if (elem->getIndex() != count)
+            {
+                elemString.insert(1, StringConverter::toString(elem->getIndex()));
+            }
+            ++count;
+            layout += elemString;
+        }
+        return layout;
+    }
+
+    String MeshUtils::getElementName(VertexElementSemantic semantic, unsigned short index)
+    {
+        return getElementLayoutString(semantic, VET_FLOAT1).substr(0, 1)
+            + StringConverter::toString(index);
+    }
+
+    bool MeshUtils::parseElementName(const String& name, VertexElementSemantic& semantic,
+        unsigned short& index)
+    {
+        if (name.empty() || name.find_first_not_of("0123456789", 1) != String::npos)
+        {
+            return false;
+        }
+        semantic = getLayoutSemantic(name[0]);
+        if (semantic == 0)
+        {
+            return false;
+        }
+        index = name.size() > 1
+            ? static_cast<unsigned short>(StringConverter::parseUnsignedInt(name.substr(1))) : 0;
+        return true;
+    }
+
+    bool MeshUtils::parseVertexLayout(const String& layoutString, VertexLayout& layout)
+    {
+        layout.buffers.assign(1, VertexLayout::ElementList());
+        layout.alignments.assign(1, 1);
+        std::map<VertexElementSemantic, unsigned short> semanticCounts;
+        std::set<std::pair<VertexElementSemantic, unsigned short> > listed;
+
+        size_t pos = 0;
+        while (pos < layoutString.size())
+        {
+            const char c = layoutString[pos];
+            if (c == '-')
+            {
+                if (layout.buffers.back().empty())
+                {
+                    return false;
+                }
+                layout.buffers.push_back(VertexLayout::ElementList());
+                layout.alignments.push_back(1);
+                ++pos;
+                continue;
+            }
+            if (c == ':')
+            {
+                size_t end = layoutString.find('-', pos);
+                String alignment = layoutString.substr(pos + 1,
+                    end == String::npos ? String::npos : end - pos - 1);
+                if (alignment.empty()
+                    || alignment.find_first_not_of("0123456789") != String::npos)
+                {
+                    return false;
+                }
+                layout.alignments.back() = StringConverter::parseUnsignedInt(alignment);
+                if (layout.alignments.back() == 0)
+                {
+                    return false;
+                }
+                pos = end == String::npos ? layoutString.size() : end;
+                continue;
+            }
+
+            // Semantic letter
+            VertexLayout::Element element;
+            element.semantic = getLayoutSemantic(c);
+            if (element.semantic == 0)
+            {
+                return false;
+            }
+            ++pos;
+
+            // Optional index, else implied by the order.
+            size_t indexEnd = pos;
+            while (indexEnd < layoutString.size()
+                && isdigit(static_cast<unsigned char>(layoutString[indexEnd])))
+            {
+                ++indexEnd;
+            }
+            unsigned short& count = semanticCounts[element.semantic];
+            element.index = indexEnd > pos ? static_cast<unsigned short>(
+                StringConverter::parseUnsignedInt(layoutString.substr(pos, indexEnd - pos)))
+                : count;
+            ++count;
+            pos = indexEnd;
+
+            // Optional type
+            element.type = VET_FLOAT1;
+            element.hasType = false;
+            if (pos < layoutString.size() && layoutString[pos] == '(')
+            {
+                size_t typeEnd = layoutString.find(')', pos);
+                if (typeEnd == String::npos)
+                {
+                    return false;
+                }
+                String typeString = layoutString.substr(pos, typeEnd + 1 - pos);
+                for (size_t i = 0; i < sizeof(LAYOUT_TYPES) / sizeof(LAYOUT_TYPES[0]); ++i)
+                {
+                    if (getElementLayoutString(element.semantic, LAYOUT_TYPES[i]).substr(1)
+                        == typeString)
+                    {
+                        element.type = LAYOUT_TYPES[i];
+                        element.hasType = true;
+                    }
+                }
+                if (!element.hasType)
+                {
+                    return false;
+                }
+                pos = typeEnd + 1;
+            }
+
+            if (!listed.insert(std::make_pair(element.semantic, element.index)).second)
+            {
+                return false;
+            }
+            layout.buffers.back().push_back(element);
+        }
+
+        return !layout.buffers.back().empty();
+    }
 }
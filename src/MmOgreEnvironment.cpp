@@ -30,22 +30,66 @@ THE SOFTWARE.
 #include <OgreResourceGroupManager.h>
 #include <OgreSkeletonManager.h>
 
+#include <utility>
+#include <vector>
+
 using namespace Ogre;
 
 template<> meshmagick::OgreEnvironment* Singleton<meshmagick::OgreEnvironment>::msSingleton = NULL;
 
 struct MaterialCreator : public MeshSerializerListener
 {
+    typedef std::vector<std::pair<String, String> > ResourceNameList;
+
+    /// Placeholder materials and skeletons created while loading meshes, as (name, group).
+    ResourceNameList materials;
+    ResourceNameList skeletons;
+
     void processMaterialName(Mesh *mesh, String *name)
     {
         // create material because we do not load any .material files
-        MaterialManager::getSingleton().create(*name, mesh->getGroup());
+        MaterialManager& mm = MaterialManager::getSingleton();
+        if (!mm.resourceExists(*name, mesh->getGroup()))
+        {
+            mm.create(*name, mesh->getGroup());
+            materials.push_back(std::make_pair(*name, mesh->getGroup()));
+        }
+    }
+
+    void processSkeletonName(Mesh *mesh, String *name)
+    {
+        // The mesh creates the skeleton resource when its link is set.
+        if (!name->empty()
+            && !SkeletonManager::getSingleton().resourceExists(*name, mesh->getGroup()))
+        {
+            skeletons.push_back(std::make_pair(*name, mesh->getGroup()));
+        }
     }
 
-    void processSkeletonName(Mesh *mesh, String *name) {}
     void processMeshCompleted(Mesh *mesh) {}
+
+    void releaseResources()
+    {
+        releaseResources(SkeletonManager::getSingleton(), skeletons);
+        releaseResources(MaterialManager::getSingleton(), materials);
+    }
+
+    void releaseResources(ResourceManager& manager, ResourceNameList& names)
+    {
+        for (ResourceNameList::const_iterator it = names.begin(); it != names.end(); ++it)
+        {
+            ResourcePtr res = manager.getResourceByName(it->first, it->second);
+            if (res)
+            {
+                manager.remove(res);
+            }
+        }
+        names.clear();
+    }
 };
 
+static MaterialCreator matCreator;
+
 namespace meshmagick
 {
     OgreEnvironment::OgreEnvironment()
@@ -113,7 +157,6 @@ namespace meshmagick
 		mMeshSerializer = new StatefulMeshSerializer();
         mSkeletonSerializer = new StatefulSkeletonSerializer();
 
-        static MaterialCreator matCreator;
         mMeshSerializer->setListener(&matCreator);
 	}
 
@@ -136,4 +179,12 @@ namespace meshmagick
     {
         return mSkeletonSerializer;
     }
+
+    void OgreEnvironment::releaseFileResources()
+    {
+        // Meshes first, they hold references to skeletons and materials.
+        mMeshSerializer->releaseResources();
+        mSkeletonSerializer->releaseResources();
+        matCreator.releaseResources();
+    }
 }
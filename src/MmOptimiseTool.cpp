@@ -23,23 +23,58 @@ THE SOFTWARE.
 
 #include "MmOptimiseTool.h"
 
+#include "MmMeshUtils.h"
 #include "MmOgreEnvironment.h"
 #include "MmStatefulMeshSerializer.h"
 #include "MmStatefulSkeletonSerializer.h"
+#include "MmThreadPool.h"
 
 #ifdef __APPLE__
+#	include <Ogre/OgreAnimation.h>
+#	include <Ogre/OgreAnimationTrack.h>
 #	include <Ogre/OgreStringConverter.h>
 #else
+#	include <OgreAnimation.h>
+#	include <OgreAnimationTrack.h>
 #	include <OgreStringConverter.h>
 #endif
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <functional>
+#include <numeric>
 
 #include "MmToolUtils.h"
 
 using namespace Ogre;
 
+namespace
+{
+	/// Whether the element has the same value in all vertices.
+	bool isConstantElement(const VertexData* vd, const VertexElement& element)
+	{
+		if (vd->vertexCount < 2)
+		{
+			return false;
+		}
+
+		HardwareVertexBufferSharedPtr buffer =
+			vd->vertexBufferBinding->getBuffer(element.getSource());
+		const size_t vertexSize = buffer->getVertexSize();
+		const unsigned char* first = static_cast<const unsigned char*>(
+			buffer->lock(HardwareBuffer::HBL_READ_ONLY))
+			+ vd->vertexStart * vertexSize + element.getOffset();
+		bool constant = true;
+		for (size_t v = 1; v < vd->vertexCount && constant; ++v)
+		{
+			constant = memcmp(first, first + v * vertexSize, element.getSize()) == 0;
+		}
+		buffer->unlock();
+		return constant;
+	}
+}
+
 namespace meshmagick
 {
 	//------------------------------------------------------------------------
@@ -64,6 +99,10 @@ namespace meshmagick
 
 		mPosTolerance = mNormTolerance = mUVTolerance = 1e-06f;
 		mKeepIdentityTracks = OptionsUtil::isOptionSet(toolOptions, "keep-identity-tracks");
+		mStrip = OptionsUtil::isOptionSet(toolOptions, "strip");
+		mStripConstantUVs = OptionsUtil::isOptionSet(toolOptions, "strip-constant-uvs");
+		mStrip |= mStripConstantUVs;
+		mStripElements.clear();
 		for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
 		{
 			if (it->first == "tolerance")
@@ -82,13 +121,28 @@ namespace meshmagick
 			{
 				mUVTolerance = static_cast<float>(any_cast<Real>(it->second));
 			}
+			else if (it->first == "strip-element")
+			{
+				String name = any_cast<String>(it->second);
+				ElementList::value_type element;
+				if (!MeshUtils::parseElementName(name, element.first, element.second))
+				{
+					fail("unknown vertex element " + name + ".");
+				}
+				if (element.first == VES_POSITION)
+				{
+					fail("positions can't be stripped.");
+				}
+				mStripElements.push_back(element);
+				mStrip = true;
+			}
 		}
 
 
 		StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
 
 		// Process the meshes
-		for (size_t i = 0, end = inFileNames.size(); i < end; ++i)
+		forEachFile(inFileNames.size(), [&](size_t i)
 		{
 			if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
 			{
@@ -103,7 +157,7 @@ namespace meshmagick
 				warn("unrecognised name ending for file " + inFileNames[i]);
 				warn("file skipped.");
 			}
-		}
+		});
 	}
 	//---------------------------------------------------------------------
 	void OptimiseTool::processMeshFile(Ogre::String file, Ogre::String outFile)
@@ -126,8 +180,14 @@ namespace meshmagick
 		}
 		print("Optimising mesh...");
 		processMesh(mesh);
-		meshSerializer->saveMesh(outFile, true);
-		print("Mesh saved as " + outFile + ".");
+		if (meshSerializer->saveMesh(outFile, true))
+		{
+			print("Mesh saved as " + outFile + ".");
+		}
+		else
+		{
+			print("Mesh " + outFile + " unchanged, not written.");
+		}
 
 		if (mFollowSkeletonLink && mesh->hasSkeleton())
 		{
@@ -149,6 +209,12 @@ namespace meshmagick
 		StatefulSkeletonSerializer* skeletonSerializer =
 			OgreEnvironment::getSingleton().getSkeletonSerializer();
 
+		// Skeletons shared by several meshes of the batch are only optimised once.
+		if (isSkeletonProcessed(file, outFile))
+		{
+			return;
+		}
+
 		print("Loading skeleton " + file + "...");
 		SkeletonPtr skeleton;
 		try
@@ -164,9 +230,15 @@ namespace meshmagick
 		}
 		print("Optimising skeleton...");
 		processSkeleton(skeleton);
-		skeletonSerializer->saveSkeleton(outFile, true);
-		print("Skeleton saved as " + outFile + ".");
-
+		if (skeletonSerializer->saveSkeleton(outFile, true))
+		{
+			print("Skeleton saved as " + outFile + ".");
+		}
+		else
+		{
+			print("Skeleton " + outFile + " unchanged, not written.");
+		}
+		setSkeletonProcessed(file, outFile);
 	}
 	//---------------------------------------------------------------------
 	void OptimiseTool::processMesh(Ogre::MeshPtr mesh)
@@ -177,52 +249,46 @@ namespace meshmagick
 	void OptimiseTool::processMesh(Ogre::Mesh* mesh)
 	{
 		bool rebuildEdgeList = false;
+		const bool skinned = mesh->getSkeletonName() != Ogre::BLANKSTRING;
 		// Shared geometry
 		if (mesh->sharedVertexData)
 		{
 			print("Optimising mesh shared vertex data...");
+			if (mStrip)
+			{
+				stripVertexElements(mesh->sharedVertexData, skinned);
+			}
 			setTargetVertexData(mesh->sharedVertexData);
 
+			SubMesh::LODFaceList lodFaces;
 			for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
 			{
 				SubMesh* sm = mesh->getSubMesh(i);
 				if (sm->useSharedVertices)
 				{
 					addIndexData(sm->indexData, sm->operationType);
+					lodFaces.insert(lodFaces.end(),
+						sm->mLodFaceList.begin(), sm->mLodFaceList.end());
 				}
 			}
 
 			if (optimiseGeometry())
 			{
-				if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
+				fixSharedVertexReferences(mesh);
+				rebuildEdgeList = true;
+			}
+
+			if (mStrip)
+			{
+				if (hasVertexAnimation(mesh, 0))
 				{
-					print("    fixing bone assignments...");
-					const auto& bas = mesh->getBoneAssignments ();
-					auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end());
-					mesh->clearBoneAssignments();
-					for (const auto& boneAssignment : newList)
-						mesh->addBoneAssignment (boneAssignment.second);
+					print("    vertex animation refers to vertices, unreferenced vertices kept.");
 				}
-
-				for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+				else if (stripUnreferencedVertices(lodFaces))
 				{
-					SubMesh* sm = mesh->getSubMesh(i);
-					if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
-					{
-						print("    fixing bone assignments...");
-						const auto& bas = sm->getBoneAssignments ();
-						auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end());
-						sm->clearBoneAssignments();
-						for (const auto& boneAssignment : newList)
-							sm->addBoneAssignment (boneAssignment.second);
-					}
-					if (sm->useSharedVertices)
-					{
-						fixLOD(sm->mLodFaceList);
-					}
+					fixSharedVertexReferences(mesh);
+					rebuildEdgeList = true;
 				}
-				rebuildEdgeList = true;
-
 			}
 		}
 
@@ -234,22 +300,29 @@ namespace meshmagick
 			{
 				print("Optimising submesh " +
 					StringConverter::toString(i) + " dedicated vertex data ");
+				if (mStrip)
+				{
+					stripVertexElements(sm->vertexData, skinned);
+				}
 				setTargetVertexData(sm->vertexData);
 				addIndexData(sm->indexData, sm->operationType);
 				if (optimiseGeometry())
 				{
-					if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
+					fixDedicatedVertexReferences(mesh, sm);
+					rebuildEdgeList = true;
+				}
+
+				if (mStrip)
+				{
+					if (hasVertexAnimation(mesh, i + 1))
 					{
-						print("    fixing bone assignments...");
-						const auto& bas = sm->getBoneAssignments();
-						auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end());
-						sm->clearBoneAssignments();
-						for (auto& boneAssignment : newList)
-							sm->addBoneAssignment(boneAssignment.second);
+						print("    vertex animation refers to vertices, unreferenced vertices kept.");
+					}
+					else if (stripUnreferencedVertices(sm->mLodFaceList))
+					{
+						fixDedicatedVertexReferences(mesh, sm);
+						rebuildEdgeList = true;
 					}
-
-					fixLOD(sm->mLodFaceList);
-					rebuildEdgeList = true;
 				}
 			}
 		}
@@ -262,6 +335,44 @@ namespace meshmagick
 		}
 
 
+	}
+	//---------------------------------------------------------------------
+	void OptimiseTool::fixSharedVertexReferences(Ogre::Mesh* mesh)
+	{
+		// Only the mesh holds bone assignments for shared vertices.
+		if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
+		{
+			print("    fixing bone assignments...");
+			const auto& bas = mesh->getBoneAssignments ();
+			auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end());
+			mesh->clearBoneAssignments();
+			for (const auto& boneAssignment : newList)
+				mesh->addBoneAssignment (boneAssignment.second);
+		}
+
+		for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+		{
+			SubMesh* sm = mesh->getSubMesh(i);
+			if (sm->useSharedVertices)
+			{
+				fixLOD(sm->mLodFaceList);
+			}
+		}
+	}
+	//---------------------------------------------------------------------
+	void OptimiseTool::fixDedicatedVertexReferences(Ogre::Mesh* mesh, Ogre::SubMesh* sm)
+	{
+		if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
+		{
+			print("    fixing bone assignments...");
+			const auto& bas = sm->getBoneAssignments();
+			auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end());
+			sm->clearBoneAssignments();
+			for (auto& boneAssignment : newList)
+				sm->addBoneAssignment(boneAssignment.second);
+		}
+
+		fixLOD(sm->mLodFaceList);
 	}
 	//---------------------------------------------------------------------
 	void OptimiseTool::fixLOD(SubMesh::LODFaceList lodFaces)
@@ -292,7 +403,7 @@ namespace meshmagick
 			if (ii.isOriginal)
 			{
 				ass.vertexIndex = static_cast<unsigned int>(ii.targetIndex);
-				assert (ass.vertexIndex < mUniqueVertexMap.size());
+				assert (ass.vertexIndex < mUniqueVertexList.size());
 				newList.insert(Mesh::VertexBoneAssignmentList::value_type(
 					ass.vertexIndex, ass));
 
@@ -311,7 +422,76 @@ namespace meshmagick
 	//---------------------------------------------------------------------
 	void OptimiseTool::processSkeleton(Ogre::Skeleton* skeleton)
 	{
-		skeleton->optimiseAllAnimations(mKeepIdentityTracks);
+		// Does the same as Skeleton::optimiseAllAnimations, but on the thread pool.
+		// Removing a key frame marks the key frame times of its animation dirty,
+		// so all tracks of one animation are optimised by the same worker.
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		const unsigned short numAnimations = skeleton->getNumAnimations();
+		std::vector<Animation*> animations(numAnimations);
+		std::vector<size_t> numKeyFrames(numAnimations, 0);
+		std::vector<const NodeAnimationTrack*> tracks;
+		std::vector<unsigned short> trackHandles;
+		for (unsigned short i = 0; i < numAnimations; ++i)
+		{
+			animations[i] = skeleton->getAnimation(i);
+			const Animation::NodeTrackList& trackList = animations[i]->_getNodeTrackList();
+			for (Animation::NodeTrackList::const_iterator it = trackList.begin();
+				it != trackList.end(); ++it)
+			{
+				numKeyFrames[i] += it->second->getNumKeyFrames();
+				tracks.push_back(it->second);
+				trackHandles.push_back(it->first);
+			}
+		}
+
+		// Largest animations first, so that no worker is left with a big one at the end.
+		std::vector<size_t> order(numAnimations);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+			[&numKeyFrames](size_t a, size_t b) { return numKeyFrames[a] > numKeyFrames[b]; });
+
+		ThreadPool pool(mNumThreads);
+		if (!mKeepIdentityTracks)
+		{
+			// A bone's tracks are only discarded, if they are identity in all animations.
+			// Checking a track doesn't modify anything, so these jobs are per track.
+			std::vector<char> nonZero(tracks.size(), 0);
+			pool.run(tracks.size(), [&](size_t t)
+			{
+				nonZero[t] = tracks[t]->hasNonZeroKeyFrames() ? 1 : 0;
+			});
+
+			Animation::TrackHandleList tracksToDestroy;
+			for (unsigned short h = 0; h < skeleton->getNumBones(); ++h)
+			{
+				tracksToDestroy.insert(h);
+			}
+			for (size_t t = 0; t < tracks.size(); ++t)
+			{
+				if (nonZero[t])
+				{
+					tracksToDestroy.erase(trackHandles[t]);
+				}
+			}
+
+			pool.run(numAnimations, [&](size_t i)
+			{
+				animations[order[i]]->_destroyNodeTracks(tracksToDestroy);
+			});
+		}
+
+		pool.run(numAnimations, [&](size_t i)
+		{
+			// Identity tracks have been dealt with above.
+			animations[order[i]]->optimise(false);
+		});
+
+		std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+		print("Optimised " + StringConverter::toString(numAnimations) + " animations in "
+			+ StringConverter::toString(static_cast<long>(
+				std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()))
+			+ " ms using " + StringConverter::toString(pool.getNumThreads()) + " threads.", V_HIGH);
 	}
 	//---------------------------------------------------------------------
 	void OptimiseTool::setTargetVertexData(Ogre::VertexData* vd)
@@ -321,6 +501,7 @@ namespace meshmagick
 		mUniqueVertexList.clear();
 		mIndexDataList.clear();
 		mIndexRemap.clear();
+		mRemappedIndexBuffers.clear();
 	}
 	//---------------------------------------------------------------------
 	void OptimiseTool::addIndexData(Ogre::IndexData* id, RenderOperation::OperationType ot)
@@ -354,6 +535,147 @@ namespace meshmagick
 		return verticesChanged;
 	}
 	//---------------------------------------------------------------------
+	bool OptimiseTool::stripUnreferencedVertices(const SubMesh::LODFaceList& lodFaces)
+	{
+		// Unindexed geometry uses all of its vertices
+		if (mIndexDataList.empty())
+			return false;
+
+		const size_t vertexCount = mTargetVertexData->vertexCount;
+		std::vector<bool> referenced(vertexCount, false);
+		std::vector<IndexData*> indexDatas;
+		for (IndexDataList::iterator i = mIndexDataList.begin(); i != mIndexDataList.end(); ++i)
+		{
+			indexDatas.push_back(i->indexData);
+		}
+		indexDatas.insert(indexDatas.end(), lodFaces.begin(), lodFaces.end());
+		for (size_t i = 0; i < indexDatas.size(); ++i)
+		{
+			std::vector<uint32> indices = MeshUtils::getIndices(indexDatas[i]);
+			for (size_t j = 0; j < indices.size(); ++j)
+			{
+				if (indices[j] < vertexCount)
+				{
+					referenced[indices[j]] = true;
+				}
+			}
+		}
+
+		// Same remap as for duplicates, except that dropped vertices have no target.
+		mUniqueVertexMap.clear();
+		mUniqueVertexList.clear();
+		mIndexRemap.clear();
+		mRemappedIndexBuffers.clear();
+		for (uint32 v = 0; v < vertexCount; ++v)
+		{
+			if (referenced[v])
+			{
+				uint32 newIndex = static_cast<uint32>(mUniqueVertexList.size());
+				mUniqueVertexList.push_back(VertexInfo(v, newIndex));
+				mIndexRemap.push_back(IndexInfo(newIndex, true));
+			}
+			else
+			{
+				mIndexRemap.push_back(IndexInfo(0, false));
+			}
+		}
+
+		if (mUniqueVertexList.empty() || mUniqueVertexList.size() == vertexCount)
+			return false;
+
+		print("    " + StringConverter::toString(vertexCount - mUniqueVertexList.size()) +
+			" unreferenced vertices to be removed.");
+		print("    rebuilding vertex buffers...");
+		rebuildVertexBuffers();
+		print("    re-indexing faces...");
+		remapIndexDataList();
+		print("    done.");
+		return true;
+	}
+	//---------------------------------------------------------------------
+	void OptimiseTool::stripVertexElements(VertexData* vd, bool skinned)
+	{
+		const VertexDeclaration::VertexElementList& elements =
+			vd->vertexDeclaration->getElements();
+		VertexDeclaration::VertexElementList::const_iterator it;
+
+		// A binormal can be derived from normal and tangent, if the tangent carries
+		// the handedness in its fourth component.
+		bool hasTangentWithHandedness = false;
+		for (it = elements.begin(); it != elements.end(); ++it)
+		{
+			if (it->getSemantic() == VES_TANGENT
+				&& VertexElement::getTypeCount(it->getType()) == 4)
+			{
+				hasTangentWithHandedness = true;
+			}
+		}
+
+		std::vector<bool> remove;
+		size_t removedBytes = 0;
+		for (it = elements.begin(); it != elements.end(); ++it)
+		{
+			const VertexElementSemantic semantic = it->getSemantic();
+			bool dead = std::find(mStripElements.begin(), mStripElements.end(),
+				ElementList::value_type(semantic, it->getIndex())) != mStripElements.end();
+			if (!dead)
+			{
+				switch (semantic)
+				{
+				case VES_BINORMAL:
+					dead = hasTangentWithHandedness;
+					break;
+				case VES_BLEND_INDICES:
+				case VES_BLEND_WEIGHTS:
+					dead = !skinned;
+					break;
+				case VES_TEXTURE_COORDINATES:
+					// Constant sets may still be read, e.g. for palette lookups.
+					dead = mStripConstantUVs && isConstantElement(vd, *it);
+					break;
+				default:
+					break;
+				}
+			}
+
+			if (dead)
+			{
+				print("    removing vertex element "
+					+ MeshUtils::getElementName(it->getSemantic(), it->getIndex()) + "...", V_HIGH);
+				removedBytes += it->getSize();
+			}
+			remove.push_back(dead);
+		}
+
+		if (removedBytes > 0)
+		{
+			print("    " + StringConverter::toString(removedBytes) +
+				" bytes per vertex removed.");
+			MeshUtils::removeVertexElements(vd, remove);
+		}
+	}
+	//---------------------------------------------------------------------
+	bool OptimiseTool::hasVertexAnimation(const Mesh* mesh, unsigned short target) const
+	{
+		const PoseList& poses = mesh->getPoseList();
+		for (PoseList::const_iterator it = poses.begin(); it != poses.end(); ++it)
+		{
+			if ((*it)->getTarget() == target)
+			{
+				return true;
+			}
+		}
+
+		for (unsigned short i = 0; i < mesh->getNumAnimations(); ++i)
+		{
+			if (mesh->getAnimation(i)->hasVertexTrack(target))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	//---------------------------------------------------------------------
 	bool OptimiseTool::calculateDuplicateVertices()
 	{
 		bool duplicates = false;
@@ -378,61 +700,8 @@ namespace meshmagick
 		for (uint32 v = 0; v < mTargetVertexData->vertexCount; ++v)
 		{
 			UniqueVertex uniqueVertex;
-			const VertexDeclaration::VertexElementList& elemList =
-				mTargetVertexData->vertexDeclaration->getElements();
-			VertexDeclaration::VertexElementList::const_iterator elemi;
-			unsigned short uvSets = 0;
-			for (elemi = elemList.begin(); elemi != elemList.end(); ++elemi)
-			{
-				// all float pointers for the moment
-				float *pFloat;
-				elemi->baseVertexPointerToElement(
-					bufferLocks[elemi->getSource()], &pFloat);
-
-				switch(elemi->getSemantic())
-				{
-				case VES_POSITION:
-					uniqueVertex.position.x = *pFloat++;
-					uniqueVertex.position.y = *pFloat++;
-					uniqueVertex.position.z = *pFloat++;
-					break;
-				case VES_NORMAL:
-					uniqueVertex.normal.x = *pFloat++;
-					uniqueVertex.normal.y = *pFloat++;
-					uniqueVertex.normal.z = *pFloat++;
-					break;
-				case VES_TANGENT:
-					uniqueVertex.tangent.x = *pFloat++;
-					uniqueVertex.tangent.y = *pFloat++;
-					uniqueVertex.tangent.z = *pFloat++;
-					// support w-component on tangent if present
-					if (VertexElement::getTypeCount(elemi->getType()) == 4)
-					{
-						uniqueVertex.tangent.w = *pFloat++;
-					}
-					break;
-				case VES_BINORMAL:
-					uniqueVertex.binormal.x = *pFloat++;
-					uniqueVertex.binormal.y = *pFloat++;
-					uniqueVertex.binormal.z = *pFloat++;
-					break;
-				case VES_TEXTURE_COORDINATES:
-					// supports up to 4 dimensions
-					for (unsigned short dim = 0;
-						dim < VertexElement::getTypeCount(elemi->getType()); ++dim)
-					{
-						uniqueVertex.uv[elemi->getIndex()][dim] = *pFloat++;
-					}
-					++uvSets;
-					break;
-				case VES_BLEND_INDICES:
-				case VES_BLEND_WEIGHTS:
-				case VES_DIFFUSE:
-				case VES_SPECULAR:
-					// No action needed for these semantics.
-					break;
-				};
-			}
+			unsigned short uvSets = uniqueVertex.read(
+				mTargetVertexData->vertexDeclaration, bufferLocks);
 
 			if (v == 0)
 			{
@@ -590,6 +859,15 @@ namespace meshmagick
 		uint16* p16 = 0;
 		uint32* p32 = 0;
 
+		// All faces may have been removed as degenerate
+		if (!idata->indexBuffer)
+			return;
+
+		// Compressed LOD levels share one index buffer with overlapping ranges. The remap
+		// must not be applied twice, so the whole buffer is remapped once.
+		if (!mRemappedIndexBuffers.insert(idata->indexBuffer.get()).second)
+			return;
+
 		// Lock for read & write
 		if (idata->indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT)
 		{
@@ -600,11 +878,20 @@ namespace meshmagick
 			p16 = static_cast<uint16*>(idata->indexBuffer->lock(HardwareBuffer::HBL_NORMAL));
 		}
 
-		for (size_t j = 0; j < idata->indexCount; ++j)
+		for (size_t j = 0; j < idata->indexBuffer->getNumIndexes(); ++j)
 		{
 			uint32 oldIndex = p32? *p32 : *p16;
+			if (oldIndex >= mIndexRemap.size())
+			{
+				// Not an index of the target, leave it alone
+				if (p32)
+					++p32;
+				else
+					++p16;
+				continue;
+			}
 			uint32 newIndex = static_cast<uint32>(mIndexRemap[oldIndex].targetIndex);
-			assert(newIndex < mUniqueVertexMap.size());
+			assert(newIndex < mUniqueVertexList.size());
 			if (newIndex != oldIndex)
 			{
 				if (p32)
@@ -761,7 +1048,67 @@ namespace meshmagick
 
 	}
 	//---------------------------------------------------------------------
-	bool OptimiseTool::UniqueVertexLess::equals(
+	unsigned short UniqueVertex::read(const VertexDeclaration* decl,
+		const std::vector<char*>& bufferLocks)
+	{
+		const VertexDeclaration::VertexElementList& elemList = decl->getElements();
+		VertexDeclaration::VertexElementList::const_iterator elemi;
+		unsigned short uvSets = 0;
+		for (elemi = elemList.begin(); elemi != elemList.end(); ++elemi)
+		{
+			// all float pointers for the moment
+			float *pFloat;
+			elemi->baseVertexPointerToElement(
+				bufferLocks[elemi->getSource()], &pFloat);
+
+			switch(elemi->getSemantic())
+			{
+			case VES_POSITION:
+				position.x = *pFloat++;
+				position.y = *pFloat++;
+				position.z = *pFloat++;
+				break;
+			case VES_NORMAL:
+				normal.x = *pFloat++;
+				normal.y = *pFloat++;
+				normal.z = *pFloat++;
+				break;
+			case VES_TANGENT:
+				tangent.x = *pFloat++;
+				tangent.y = *pFloat++;
+				tangent.z = *pFloat++;
+				// support w-component on tangent if present
+				if (VertexElement::getTypeCount(elemi->getType()) == 4)
+				{
+					tangent.w = *pFloat++;
+				}
+				break;
+			case VES_BINORMAL:
+				binormal.x = *pFloat++;
+				binormal.y = *pFloat++;
+				binormal.z = *pFloat++;
+				break;
+			case VES_TEXTURE_COORDINATES:
+				// supports up to 4 dimensions
+				for (unsigned short dim = 0;
+					dim < VertexElement::getTypeCount(elemi->getType()); ++dim)
+				{
+					uv[elemi->getIndex()][dim] = *pFloat++;
+				}
+				++uvSets;
+				break;
+			case VES_BLEND_INDICES:
+			case VES_BLEND_WEIGHTS:
+			case VES_DIFFUSE:
+			case VES_SPECULAR:
+				// No action needed for these semantics.
+				break;
+			};
+		}
+		return uvSets;
+	}
+	//---------------------------------------------------------------------
+	bool UniqueVertexLess::equals(
 		const Vector3& a, const Vector3& b, Real tolerance) const
 	{
 		// note during this comparison we treat directions as positions
@@ -770,19 +1117,19 @@ namespace meshmagick
 		return a.positionEquals(b, tolerance);
 	}
 	//---------------------------------------------------------------------
-	bool OptimiseTool::UniqueVertexLess::equals(
+	bool UniqueVertexLess::equals(
 		const Vector4& a, const Vector4& b, Real tolerance) const
 	{
 		// no built-in position equals
 		for (int i = 0; i < 4; ++i)
 		{
-			if (Math::RealEqual(a[i], b[i], tolerance))
-				return true;
+			if (!Math::RealEqual(a[i], b[i], tolerance))
+				return false;
 		}
-		return false;
+		return true;
 	}
 	//---------------------------------------------------------------------
-	bool OptimiseTool::UniqueVertexLess::less(
+	bool UniqueVertexLess::less(
 		const Vector3& a, const Vector3& b, Real tolerance) const
 	{
 		// don't use built-in operator, we need sorting
@@ -795,7 +1142,7 @@ namespace meshmagick
 		return a.x < b.x;
 	}
 	//---------------------------------------------------------------------
-	bool OptimiseTool::UniqueVertexLess::less(
+	bool UniqueVertexLess::less(
 		const Vector4& a, const Vector4& b, Real tolerance) const
 	{
 		// don't use built-in operator, we need sorting
@@ -808,7 +1155,7 @@ namespace meshmagick
 		return a.x < b.x;
 	}
 	//---------------------------------------------------------------------
-	bool OptimiseTool::UniqueVertexLess::operator ()(
+	bool UniqueVertexLess::operator ()(
 		const UniqueVertex &a,
 		const UniqueVertex &b) const
 	{
@@ -50,6 +50,9 @@ namespace meshmagick
 		optionDefs.insert(OptionDefinition("norm_tolerance", OT_REAL, false, false, Ogre::Any(1e-06)));
 		optionDefs.insert(OptionDefinition("uv_tolerance", OT_REAL, false, false, Ogre::Any(1e-06)));
 		optionDefs.insert(OptionDefinition("keep-identity-tracks", OT_BOOL, false, false));
+		optionDefs.insert(OptionDefinition("strip", OT_BOOL, false, false));
+		optionDefs.insert(OptionDefinition("strip-constant-uvs", OT_BOOL, false, false));
+		optionDefs.insert(OptionDefinition("strip-element", OT_STRING, false, true));
 
 		return optionDefs;
 	}
@@ -69,6 +72,24 @@ namespace meshmagick
 			<< std::endl;
 		out << "   -keep-identity-tracks - When optimising skeletons, keep tracks which do nothing"
 			<< std::endl;
+		out << "   -strip - Remove vertices no index refers to and vertex elements nothing uses:"
+			<< std::endl;
+		out << "            binormals if tangents have a w component and blend elements of"
+			<< std::endl;
+		out << "            meshes without skeleton"
+			<< std::endl;
+		out << "   -strip-constant-uvs - Also remove texture coordinate sets that are the same"
+			<< std::endl;
+		out << "            for all vertices, implies -strip. Only safe, if no material reads"
+			<< std::endl;
+		out << "            them, e.g. for palette lookups."
+			<< std::endl;
+		out << "   -strip-element=name - Remove named vertex element, implies -strip. Named like"
+			<< std::endl;
+		out << "            in the info tool's layout strings, e.g. b or u1 for texture set 1."
+			<< std::endl;
+		out << "            Can be given multiple times."
+			<< std::endl;
 
 	}
 
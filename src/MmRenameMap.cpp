@@ -0,0 +1,153 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmRenameMap.h"
+
+#include <OgreStringConverter.h>
+
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+
+using namespace Ogre;
+
+namespace meshmagick
+{
+    RenameMap::RenameMap()
+    {
+    }
+
+    void RenameMap::load(const String& fileName)
+    {
+        std::ifstream ifs(fileName.c_str());
+        if (!ifs)
+        {
+            throw std::ios_base::failure(("cannot open file " + fileName).c_str());
+        }
+
+        const char* kindNames[RK_COUNT] = {"material", "submesh", "bone", "animation"};
+        const String separator = " -> ";
+        String line;
+        size_t lineNumber = 0;
+        while (std::getline(ifs, line))
+        {
+            ++lineNumber;
+            StringUtil::trim(line);
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            const String::size_type kindEnd = line.find_first_of(" \t");
+            const String::size_type arrow = line.find(separator);
+            if (kindEnd == String::npos || arrow == String::npos || arrow < kindEnd)
+            {
+                throw std::logic_error("malformed rule in line "
+                    + StringConverter::toString(lineNumber) + " of " + fileName);
+            }
+
+            String kindName = line.substr(0, kindEnd);
+            const bool isRegex = StringUtil::endsWith(kindName, "-regex", false);
+            if (isRegex)
+            {
+                kindName.resize(kindName.size() - 6);
+            }
+            int kind = 0;
+            while (kind < RK_COUNT && kindName != kindNames[kind])
+            {
+                ++kind;
+            }
+            if (kind == RK_COUNT)
+            {
+                throw std::logic_error("unknown rule kind '" + line.substr(0, kindEnd)
+                    + "' in line " + StringConverter::toString(lineNumber) + " of " + fileName);
+            }
+
+            String before = line.substr(kindEnd, arrow - kindEnd);
+            String after = line.substr(arrow + separator.size());
+            StringUtil::trim(before);
+            StringUtil::trim(after);
+            if (isRegex)
+            {
+                try
+                {
+                    addRegex(static_cast<RenameKind>(kind), before, after);
+                }
+                catch (std::regex_error& e)
+                {
+                    throw std::logic_error("invalid regular expression in line "
+                        + StringConverter::toString(lineNumber) + " of " + fileName + ": "
+                        + e.what());
+                }
+            }
+            else
+            {
+                add(static_cast<RenameKind>(kind), before, after);
+            }
+        }
+    }
+
+    void RenameMap::add(RenameKind kind, const String& before, const String& after)
+    {
+        mNames[kind][before] = after;
+    }
+
+    void RenameMap::addRegex(RenameKind kind, const String& pattern, const String& replacement)
+    {
+        mRegexes[kind].push_back(std::make_pair(std::regex(pattern), replacement));
+    }
+
+    bool RenameMap::apply(RenameKind kind, String& name) const
+    {
+        NameMap::const_iterator it = mNames[kind].find(name);
+        if (it != mNames[kind].end())
+        {
+            const bool changed = it->second != name;
+            name = it->second;
+            return changed;
+        }
+
+        for (RegexList::const_iterator re = mRegexes[kind].begin(); re != mRegexes[kind].end(); ++re)
+        {
+            std::smatch match;
+            if (std::regex_match(name, match, re->first))
+            {
+                const String renamed = match.format(re->second);
+                const bool changed = renamed != name;
+                name = renamed;
+                return changed;
+            }
+        }
+        return false;
+    }
+
+    size_t RenameMap::size() const
+    {
+        size_t numRules = 0;
+        for (int kind = 0; kind < RK_COUNT; ++kind)
+        {
+            numRules += mNames[kind].size() + mRegexes[kind].size();
+        }
+        return numRules;
+    }
+}
@@ -27,21 +27,25 @@ THE SOFTWARE.
 #include <OgreLog.h>
 #include <OgreMesh.h>
 #include <OgreSkeleton.h>
+#include <OgreStringConverter.h>
 #include <OgreSubMesh.h>
 
+#include "MmBufferedFileWriter.h"
+#include "MmChunkPatcher.h"
 #include "MmEditableBone.h"
 #include "MmEditableMesh.h"
 #include "MmEditableSkeleton.h"
 #include "MmOgreEnvironment.h"
 #include "MmStatefulMeshSerializer.h"
 #include "MmStatefulSkeletonSerializer.h"
+#include "MmToolUtils.h"
 
 using namespace Ogre;
 
 namespace meshmagick
 {
 	RenameTool::RenameTool()
-	: Tool()
+	: Tool(), mFullReserialise(false)
 	{
 	}
 
@@ -67,24 +71,101 @@ namespace meshmagick
         }
 
         StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
+        mFullReserialise = OptionsUtil::isOptionSet(toolOptions, "full-reserialise");
 
-        // Process the meshes
-        for (size_t i = 0, end = inFileNames.size(); i < end; ++i)
+        const String mapFileName = OptionsUtil::getStringOption(toolOptions, "map");
+        if (!mapFileName.empty())
         {
-            if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
+            try
             {
-                processMeshFile(toolOptions, inFileNames[i], outFileNames[i]);
+                mRenameMap.load(mapFileName);
             }
-            else if (StringUtil::endsWith(inFileNames[i], ".skeleton", true))
+            catch (std::exception& e)
             {
-                processSkeletonFile(toolOptions, inFileNames[i], outFileNames[i]);
+                fail(e.what());
             }
-            else
+            print("Loaded " + StringConverter::toString(mRenameMap.size()) + " rename rules from "
+                + mapFileName + ".", V_HIGH);
+        }
+
+        ChunkPatcher meshPatcher;
+        ChunkPatcher skeletonPatcher;
+        StringVector meshWarnings;
+        StringVector skeletonWarnings;
+        setupPatcher(meshPatcher, toolOptions, true, meshWarnings);
+        setupPatcher(skeletonPatcher, toolOptions, false, skeletonWarnings);
+
+        // Files that can't be patched are reserialised on this thread.
+        std::vector<PatchResult> results(inFileNames.size(), PR_RESERIALISE);
+        StringVector errors(inFileNames.size());
+        forEachFile(inFileNames.size(), [&](size_t i)
+        {
+            if (mFullReserialise)
+            {
+                return;
+            }
+            const String& inFile = inFileNames[i];
+            if (StringUtil::endsWith(inFile, ".mesh", true))
             {
-                warn("unrecognised name ending for file " + inFileNames[i]);
+                results[i] = patchFile(meshPatcher, inFile, outFileNames[i],
+                    true, errors[i]);
+            }
+            else if (StringUtil::endsWith(inFile, ".skeleton", true))
+            {
+                results[i] = patchFile(skeletonPatcher, inFile, outFileNames[i],
+                    false, errors[i]);
+            }
+        },
+        [&](size_t i)
+        {
+            const String& inFile = inFileNames[i];
+            const String& outFile = outFileNames[i];
+            const bool isMesh = StringUtil::endsWith(inFile, ".mesh", true);
+            if (!isMesh && !StringUtil::endsWith(inFile, ".skeleton", true))
+            {
+                warn("unrecognised name ending for file " + inFile);
                 warn("file skipped.");
+                return;
             }
-        }
+
+            if (results[i] == PR_RESERIALISE)
+            {
+                if (!mFullReserialise)
+                {
+                    print(inFile + " can't be patched, reserialising it.", V_HIGH);
+                }
+                if (isMesh)
+                {
+                    processMeshFile(toolOptions, inFile, outFile);
+                }
+                else
+                {
+                    processSkeletonFile(toolOptions, inFile, outFile);
+                }
+                return;
+            }
+
+            print("Patching " + inFile + "...");
+            const StringVector& warnings = isMesh ? meshWarnings : skeletonWarnings;
+            for (StringVector::const_iterator it = warnings.begin(); it != warnings.end(); ++it)
+            {
+                warn(*it);
+            }
+            const String kind = isMesh ? "Mesh " : "Skeleton ";
+            if (results[i] == PR_WRITTEN)
+            {
+                print(kind + "saved as " + outFile + ".");
+            }
+            else if (results[i] == PR_UNCHANGED)
+            {
+                print(kind + outFile + " unchanged, not written.");
+            }
+            else
+            {
+                warn(errors[i]);
+                warn("Unable to write " + outFile);
+            }
+        });
 	}
 
 	void RenameTool::processSkeletonFile(
@@ -139,8 +220,44 @@ namespace meshmagick
                 warn("Materials can only be renamed in meshes, skipped skeleton.");
             }
 		}
-        skeletonSerializer->saveSkeleton(outFile, true);
-        print("Skeleton saved as " + outFile + ".");
+
+        if (mRenameMap.size() > 0)
+        {
+            for (unsigned short i = 0; i < skeleton->getNumBones(); ++i)
+            {
+                String name = skeleton->getBone(i)->getName();
+                if (mRenameMap.apply(RenameMap::RK_BONE, name))
+                {
+                    static_cast<EditableBone*>(skeleton->getBone(i))->setName(name);
+                }
+            }
+
+            EditableSkeleton* eskel = dynamic_cast<EditableSkeleton*>(skeleton.get());
+            StringVector animationNames;
+            for (unsigned short i = 0; i < eskel->getNumAnimations(); ++i)
+            {
+                animationNames.push_back(eskel->getAnimation(i)->getName());
+            }
+            for (StringVector::const_iterator it = animationNames.begin();
+                it != animationNames.end(); ++it)
+            {
+                String name = *it;
+                if (mRenameMap.apply(RenameMap::RK_ANIMATION, name))
+                {
+                    Animation* anim = eskel->getAnimation(*it)->clone(name);
+                    eskel->removeAnimation(*it);
+                    eskel->addAnimation(anim);
+                }
+            }
+        }
+        if (skeletonSerializer->saveSkeleton(outFile, true))
+        {
+            print("Skeleton saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Skeleton " + outFile + " unchanged, not written.");
+        }
     }
 
     void RenameTool::processMeshFile(
@@ -203,9 +320,133 @@ namespace meshmagick
                 pMesh->renameSubmesh(before, after);
             }
 		}
+
+        if (mRenameMap.size() > 0)
+        {
+            for (const auto& submesh : mesh->getSubMeshes())
+            {
+                String material = submesh->getMaterialName();
+                if (mRenameMap.apply(RenameMap::RK_MATERIAL, material))
+                {
+                    submesh->setMaterialName(material);
+                }
+            }
+
+            // Iterate a copy, renaming changes the map.
+            const Mesh::SubMeshNameMap names = mesh->getSubMeshNameMap();
+            EditableMesh* pMesh = dynamic_cast<EditableMesh*>(mesh.get());
+            for (Mesh::SubMeshNameMap::const_iterator it = names.begin(); it != names.end(); ++it)
+            {
+                String name = it->first;
+                if (mRenameMap.apply(RenameMap::RK_SUBMESH, name))
+                {
+                    pMesh->renameSubmesh(it->first, name);
+                }
+            }
+        }
 		
-		meshSerializer->saveMesh(outFile, true);
-        print("Mesh saved as " + outFile + ".");
+        if (meshSerializer->saveMesh(outFile, true))
+        {
+            print("Mesh saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Mesh " + outFile + " unchanged, not written.");
+        }
+    }
+
+    void RenameTool::setupPatcher(ChunkPatcher& patcher, const OptionList &toolOptions,
+        bool isMesh, StringVector& warnings) const
+    {
+        for (OptionList::const_iterator
+            it = toolOptions.begin(); it != toolOptions.end(); ++it)
+        {
+            if (it->first == "skeleton")
+            {
+                if (isMesh)
+                {
+                    patcher.setSkeletonName(any_cast<String>(it->second));
+                }
+                else
+                {
+                    warnings.push_back("Skeletons can only be renamed in meshes, skipped skeleton.");
+                }
+            }
+            else if (it->first == "bone")
+            {
+                if (isMesh)
+                {
+                    warnings.push_back("Bones can only be renamed in skeletons, skipped mesh.");
+                }
+                else
+                {
+                    StringPair names = split(any_cast<String>(it->second));
+                    patcher.addBoneRename(names.first, names.second);
+                }
+            }
+            else if (it->first == "animation")
+            {
+                if (isMesh)
+                {
+                    warnings.push_back("Animations must be renamed in skeletons, skipped mesh.");
+                }
+                else
+                {
+                    StringPair names = split(any_cast<String>(it->second));
+                    patcher.addAnimationRename(names.first, names.second);
+                }
+            }
+            else if (it->first == "material")
+            {
+                if (isMesh)
+                {
+                    StringPair names = split(any_cast<String>(it->second));
+                    patcher.addMaterialRename(names.first, names.second);
+                }
+                else
+                {
+                    warnings.push_back("Materials can only be renamed in meshes, skipped skeleton.");
+                }
+            }
+            else if (it->first == "submesh")
+            {
+                StringPair names = split(any_cast<String>(it->second));
+                patcher.addSubMeshRename(names.first, names.second);
+            }
+        }
+
+        if (mRenameMap.size() > 0)
+        {
+            patcher.setRenameMap(&mRenameMap);
+        }
+    }
+
+    RenameTool::PatchResult RenameTool::patchFile(const ChunkPatcher& patcher,
+        const Ogre::String& inFile, const Ogre::String& outFile, bool isMesh,
+        Ogre::String& error) const
+    {
+        std::vector<unsigned char> contents;
+        ToolUtils::readFile(inFile, contents);
+        std::vector<unsigned char> patched;
+        if (contents.empty() || !(isMesh ? patcher.patchMesh(contents, patched)
+            : patcher.patchSkeleton(contents, patched)))
+        {
+            // Leave it to the serialiser to report errors.
+            return PR_RESERIALISE;
+        }
+        contents = std::vector<unsigned char>();
+
+        try
+        {
+            BufferedFileWriter writer(patched.size());
+            writer.getStream()->write(&patched[0], patched.size());
+            return writer.commit(outFile) ? PR_WRITTEN : PR_UNCHANGED;
+        }
+        catch (std::exception& e)
+        {
+            error = e.what();
+            return PR_FAILED;
+        }
     }
 
 	RenameTool::StringPair RenameTool::split(const Ogre::String& value) const
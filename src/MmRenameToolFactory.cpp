@@ -55,6 +55,8 @@ namespace meshmagick
 		optionDefs.insert(OptionDefinition("skeleton", OT_STRING, false, false));
 		optionDefs.insert(OptionDefinition("material", OT_STRING, false, true));
         optionDefs.insert(OptionDefinition("submesh", OT_STRING, false, true));
+        optionDefs.insert(OptionDefinition("full-reserialise", OT_BOOL, false, false));
+        optionDefs.insert(OptionDefinition("map", OT_STRING, false, false));
 		return optionDefs;
 	}
 
@@ -83,9 +85,17 @@ namespace meshmagick
             << std::endl;
         out << "   -submesh=/before/after/ - renames all submeshes 'before' to 'after'"
             << std::endl;
+        out << "   -map=file - applies the renamings listed in file, one per line, e.g." << std::endl
+            << "        material Rock/Old -> Rock/New" << std::endl
+            << "        bone-regex Bip01_(.*) -> $1" << std::endl
+            << "      Kinds are material, submesh, bone and animation, with -regex the old" << std::endl
+            << "      name is a regular expression that has to match the whole name." << std::endl;
         out << "Any other char can be used instead of '/', just be careful that it is not part of any name."
             << std::endl;
         out << "All options can be used more than once to execute multiple renamings at once."
+            << std::endl;
+        out << "Files are patched in place, copying all unaffected data as it is. Use" << std::endl
+            << "-full-reserialise to load and save them with the current file format instead."
             << std::endl
             << std::endl;
 	}
@@ -0,0 +1,421 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmReorganiseTool.h"
+
+#include "MmOgreEnvironment.h"
+#include "MmStatefulMeshSerializer.h"
+
+#include <OgreAnimation.h>
+#include <OgreHardwareBufferManager.h>
+#include <OgreKeyFrame.h>
+#include <OgreStringConverter.h>
+#include <OgreSubMesh.h>
+
+#include <cstring>
+#include <map>
+
+using namespace Ogre;
+
+namespace
+{
+    /// Where an element of the layout comes from and goes to.
+    struct ElementMapping
+    {
+        const VertexElement* src;
+        VertexElementType type;
+        unsigned short source;
+        size_t offset;
+    };
+}
+
+namespace meshmagick
+{
+    ReorganiseTool::ReorganiseTool()
+        : Tool(), mLayout()
+    {
+    }
+
+    String ReorganiseTool::getName() const
+    {
+        return "reorganise";
+    }
+
+    void ReorganiseTool::doInvoke(const OptionList& toolOptions,
+        const StringVector& inFileNames, const StringVector& outFileNamesArg)
+    {
+        // Name count has to match, else we have no way to figure out how to apply output
+        // names to input files.
+        if (!(outFileNamesArg.empty() || inFileNames.size() == outFileNamesArg.size()))
+        {
+            fail("number of output files must match number of input files.");
+        }
+
+        const String layoutString = OptionsUtil::getStringOption(toolOptions, "layout");
+        if (layoutString.empty())
+        {
+            fail("no layout given.");
+        }
+        if (!MeshUtils::parseVertexLayout(layoutString, mLayout))
+        {
+            fail("invalid layout " + layoutString);
+        }
+
+        StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
+
+        forEachFile(inFileNames.size(), [&](size_t i)
+        {
+            if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
+            {
+                processMeshFile(inFileNames[i], outFileNames[i]);
+            }
+            else
+            {
+                warn("unrecognised name ending for file " + inFileNames[i]);
+                warn("file skipped.");
+            }
+        });
+    }
+
+    void ReorganiseTool::processMeshFile(const String& inFile, const String& outFile)
+    {
+        StatefulMeshSerializer* meshSerializer =
+            OgreEnvironment::getSingleton().getMeshSerializer();
+
+        print("Loading mesh " + inFile + "...");
+        MeshPtr mesh;
+        try
+        {
+            mesh = meshSerializer->loadMesh(inFile);
+        }
+        catch (std::exception& e)
+        {
+            warn(e.what());
+            warn("Unable to open mesh file " + inFile);
+            warn("file skipped.");
+            return;
+        }
+
+        print("Reorganising vertex buffers...");
+        processMesh(mesh.get());
+        if (meshSerializer->saveMesh(outFile, true))
+        {
+            print("Mesh saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Mesh " + outFile + " unchanged, not written.");
+        }
+    }
+
+    bool ReorganiseTool::processMesh(Mesh* mesh)
+    {
+        bool allDone = true;
+        if (mesh->sharedVertexData != NULL)
+        {
+            allDone &= reorganiseVertexData(mesh, mesh->sharedVertexData, 0,
+                "shared vertex data");
+        }
+        for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+        {
+            SubMesh* subMesh = mesh->getSubMesh(i);
+            if (!subMesh->useSharedVertices && subMesh->vertexData != NULL)
+            {
+                allDone &= reorganiseVertexData(mesh, subMesh->vertexData, i + 1,
+                    "submesh " + StringConverter::toString(i));
+            }
+        }
+        return allDone;
+    }
+
+    bool ReorganiseTool::reorganiseVertexData(Mesh* mesh, VertexData* vd,
+        unsigned short target, const String& name)
+    {
+        if (vd->vertexCount == 0)
+        {
+            return true;
+        }
+
+        bool morphed = false;
+        for (unsigned short i = 0; i < mesh->getNumAnimations(); ++i)
+        {
+            Animation* anim = mesh->getAnimation(i);
+            morphed |= anim->hasVertexTrack(target)
+                && anim->getVertexTrack(target)->getAnimationType() == VAT_MORPH;
+        }
+
+        // Find the current element for each one of the layout.
+        const VertexDeclaration* oldDecl = vd->vertexDeclaration;
+        std::vector<ElementMapping> mappings;
+        std::vector<size_t> vertexSizes;
+        for (unsigned short b = 0; b < mLayout.buffers.size(); ++b)
+        {
+            size_t offset = 0;
+            const VertexLayout::ElementList& elements = mLayout.buffers[b];
+            for (size_t e = 0; e < elements.size(); ++e)
+            {
+                const VertexLayout::Element& element = elements[e];
+                ElementMapping mapping;
+                mapping.src = oldDecl->findElementBySemantic(element.semantic, element.index);
+                if (mapping.src == NULL)
+                {
+                    warn(name + " has no vertex element "
+                        + MeshUtils::getElementName(element.semantic, element.index) + ", skipped.");
+                    return false;
+                }
+                mapping.type = element.hasType ? element.type : mapping.src->getType();
+                if (!canConvert(mapping.src->getType(), mapping.type))
+                {
+                    warn(name + ": can't convert "
+                        + MeshUtils::getElementLayoutString(element.semantic, mapping.src->getType())
+                        + " to " + MeshUtils::getElementLayoutString(element.semantic, mapping.type)
+                        + ", skipped.");
+                    return false;
+                }
+                mapping.source = b;
+                mapping.offset = offset;
+                offset += VertexElement::getTypeSize(mapping.type);
+                mappings.push_back(mapping);
+            }
+            const size_t alignment = mLayout.alignments[b];
+            vertexSizes.push_back((offset + alignment - 1) / alignment * alignment);
+        }
+
+        // Morphing swaps the buffer holding the positions, so nothing else may live there.
+        bool morphNormals = false;
+        if (morphed)
+        {
+            for (size_t m = 0; m < mappings.size(); ++m)
+            {
+                if (mappings[m].src->getSemantic() != VES_POSITION)
+                {
+                    continue;
+                }
+                const VertexLayout::ElementList& buffer = mLayout.buffers[mappings[m].source];
+                const bool positionsOnly = buffer.size() == 1;
+                morphNormals = buffer.size() == 2 && buffer[1].semantic == VES_NORMAL
+                    && mappings[m + 1].type == VET_FLOAT3;
+                if (mappings[m].type != VET_FLOAT3 || !(positionsOnly || morphNormals)
+                    || vertexSizes[mappings[m].source] != mappings[m].offset
+                        + (positionsOnly ? 12 : 24))
+                {
+                    warn(name + " has morph animation, which needs float3 positions in a"
+                        " buffer of their own, optionally followed by float3 normals, skipped.");
+                    return false;
+                }
+            }
+        }
+
+        const VertexDeclaration::VertexElementList& oldElements = oldDecl->getElements();
+        for (VertexDeclaration::VertexElementList::const_iterator it = oldElements.begin();
+            it != oldElements.end(); ++it)
+        {
+            bool listed = false;
+            for (size_t m = 0; m < mappings.size() && !listed; ++m)
+            {
+                listed = mappings[m].src == &*it;
+            }
+            if (!listed)
+            {
+                print("    " + name + ": dropping vertex element "
+                    + MeshUtils::getElementName(it->getSemantic(), it->getIndex()) + ".");
+            }
+        }
+
+        HardwareBufferManager& hbm = HardwareBufferManager::getSingleton();
+        VertexDeclaration* newDecl = hbm.createVertexDeclaration();
+        for (size_t m = 0; m < mappings.size(); ++m)
+        {
+            newDecl->addElement(mappings[m].source, mappings[m].offset, mappings[m].type,
+                mappings[m].src->getSemantic(), mappings[m].src->getIndex());
+        }
+
+        // Lock source buffers
+        const VertexBufferBinding::VertexBufferBindingMap& srcBindings =
+            vd->vertexBufferBinding->getBindings();
+        std::map<unsigned short, const unsigned char*> srcLocks;
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = srcBindings.begin();
+            it != srcBindings.end(); ++it)
+        {
+            srcLocks[it->first] = static_cast<const unsigned char*>(
+                it->second->lock(HardwareBuffer::HBL_READ_ONLY))
+                + vd->vertexStart * it->second->getVertexSize();
+        }
+
+        // Create new buffers, usage is taken from the buffer of their first element.
+        VertexBufferBinding* newBind = hbm.createVertexBufferBinding();
+        std::vector<unsigned char*> destLocks;
+        for (unsigned short b = 0; b < mLayout.buffers.size(); ++b)
+        {
+            const VertexElement* first = oldDecl->findElementBySemantic(
+                mLayout.buffers[b][0].semantic, mLayout.buffers[b][0].index);
+            HardwareVertexBufferSharedPtr srcBuf =
+                vd->vertexBufferBinding->getBuffer(first->getSource());
+            HardwareVertexBufferSharedPtr newBuf = hbm.createVertexBuffer(vertexSizes[b],
+                vd->vertexCount, srcBuf->getUsage(), srcBuf->hasShadowBuffer());
+            newBind->setBinding(b, newBuf);
+            unsigned char* lock = static_cast<unsigned char*>(
+                newBuf->lock(HardwareBuffer::HBL_DISCARD));
+            // Zero padding
+            memset(lock, 0, vertexSizes[b] * vd->vertexCount);
+            destLocks.push_back(lock);
+        }
+
+        for (size_t v = 0; v < vd->vertexCount; ++v)
+        {
+            for (size_t m = 0; m < mappings.size(); ++m)
+            {
+                const ElementMapping& mapping = mappings[m];
+                const unsigned short srcSource = mapping.src->getSource();
+                const unsigned char* pSrc = srcLocks[srcSource]
+                    + v * vd->vertexBufferBinding->getBuffer(srcSource)->getVertexSize()
+                    + mapping.src->getOffset();
+                unsigned char* pDest = destLocks[mapping.source]
+                    + v * vertexSizes[mapping.source] + mapping.offset;
+                convertElement(pSrc, mapping.src->getType(), pDest, mapping.type);
+            }
+        }
+
+        // unlock the buffers now
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = srcBindings.begin();
+            it != srcBindings.end(); ++it)
+        {
+            it->second->unlock();
+        }
+        for (unsigned short b = 0; b < mLayout.buffers.size(); ++b)
+        {
+            newBind->getBuffer(b)->unlock();
+        }
+
+        // now switch over declaration and bindings, and thus the buffers
+        hbm.destroyVertexDeclaration(vd->vertexDeclaration);
+        vd->vertexDeclaration = newDecl;
+        hbm.destroyVertexBufferBinding(vd->vertexBufferBinding);
+        vd->vertexBufferBinding = newBind;
+        vd->vertexStart = 0;
+
+        print("    " + name + ": " + MeshUtils::getVertexLayoutString(newDecl), V_HIGH);
+
+        if (morphNormals)
+        {
+            addMorphNormals(mesh, vd, target);
+        }
+        return true;
+    }
+
+    void ReorganiseTool::addMorphNormals(Mesh* mesh, VertexData* vd, unsigned short target)
+    {
+        const VertexElement* normalElem = vd->vertexDeclaration->findElementBySemantic(VES_NORMAL);
+        HardwareVertexBufferSharedPtr normalBuf =
+            vd->vertexBufferBinding->getBuffer(normalElem->getSource());
+        const unsigned char* pNormals = static_cast<const unsigned char*>(
+            normalBuf->lock(HardwareBuffer::HBL_READ_ONLY)) + normalElem->getOffset();
+        const size_t normalStride = normalBuf->getVertexSize();
+
+        size_t numKeyFrames = 0;
+        for (unsigned short i = 0; i < mesh->getNumAnimations(); ++i)
+        {
+            Animation* anim = mesh->getAnimation(i);
+            if (!anim->hasVertexTrack(target))
+            {
+                continue;
+            }
+            VertexAnimationTrack* track = anim->getVertexTrack(target);
+            for (unsigned short k = 0; k < track->getNumKeyFrames(); ++k)
+            {
+                VertexMorphKeyFrame* kf = track->getVertexMorphKeyFrame(k);
+                HardwareVertexBufferSharedPtr oldBuf = kf->getVertexBuffer();
+                if (oldBuf->getVertexSize() != sizeof(float) * 3)
+                {
+                    continue;
+                }
+
+                HardwareVertexBufferSharedPtr newBuf =
+                    HardwareBufferManager::getSingleton().createVertexBuffer(
+                        sizeof(float) * 6, vd->vertexCount, oldBuf->getUsage(),
+                        oldBuf->hasShadowBuffer());
+                const float* pSrc = static_cast<const float*>(
+                    oldBuf->lock(HardwareBuffer::HBL_READ_ONLY));
+                float* pDest = static_cast<float*>(newBuf->lock(HardwareBuffer::HBL_DISCARD));
+                for (size_t v = 0; v < vd->vertexCount; ++v)
+                {
+                    memcpy(pDest, pSrc + v * 3, sizeof(float) * 3);
+                    memcpy(pDest + 3, pNormals + v * normalStride, sizeof(float) * 3);
+                    pDest += 6;
+                }
+                oldBuf->unlock();
+                newBuf->unlock();
+                kf->setVertexBuffer(newBuf);
+                ++numKeyFrames;
+            }
+        }
+        normalBuf->unlock();
+
+        if (numKeyFrames > 0)
+        {
+            print("    added normals to " + StringConverter::toString(numKeyFrames)
+                + " morph key frames.", V_HIGH);
+        }
+    }
+
+    bool ReorganiseTool::canConvert(VertexElementType from, VertexElementType to)
+    {
+        if (from == to)
+        {
+            return true;
+        }
+        if (VertexElement::getBaseType(from) == VET_FLOAT1
+            && VertexElement::getBaseType(to) == VET_FLOAT1)
+        {
+            return true;
+        }
+#if OGRE_VERSION_MAJOR < 3
+        return (from == VET_COLOUR_ARGB || from == VET_COLOUR_ABGR)
+            && (to == VET_COLOUR_ARGB || to == VET_COLOUR_ABGR);
+#else
+        return false;
+#endif
+    }
+
+    void ReorganiseTool::convertElement(const unsigned char* src, VertexElementType srcType,
+        unsigned char* dest, VertexElementType destType)
+    {
+        if (srcType == destType)
+        {
+            memcpy(dest, src, VertexElement::getTypeSize(srcType));
+        }
+        else if (VertexElement::getBaseType(srcType) == VET_FLOAT1)
+        {
+            float values[4] = {0, 0, 0, 1};
+            memcpy(values, src, VertexElement::getTypeSize(srcType));
+            memcpy(dest, values, VertexElement::getTypeSize(destType));
+        }
+        else
+        {
+            uint32 colour;
+            memcpy(&colour, src, sizeof(colour));
+            VertexElement::convertColourValue(srcType, destType, &colour);
+            memcpy(dest, &colour, sizeof(colour));
+        }
+    }
+}
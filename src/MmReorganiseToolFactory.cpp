@@ -0,0 +1,88 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmReorganiseToolFactory.h"
+
+#include "MmOptionsParser.h"
+#include "MmReorganiseTool.h"
+
+namespace meshmagick
+{
+
+	ReorganiseToolFactory::ReorganiseToolFactory()
+	{
+	}
+
+	ReorganiseToolFactory::~ReorganiseToolFactory()
+	{
+	}
+
+	Tool* ReorganiseToolFactory::createTool()
+	{
+		return new ReorganiseTool();
+	}
+
+	void ReorganiseToolFactory::destroyTool(Tool* tool)
+	{
+		delete tool;
+	}
+
+	OptionDefinitionSet ReorganiseToolFactory::getOptionDefinitions() const
+	{
+		OptionDefinitionSet optionDefs;
+		optionDefs.insert(OptionDefinition("layout", OT_STRING, true));
+		return optionDefs;
+	}
+
+	Ogre::String ReorganiseToolFactory::getToolName() const
+	{
+		return "reorganise";
+	}
+
+	Ogre::String ReorganiseToolFactory::getToolDescription() const
+	{
+		return "Rewrite vertex buffers to a given layout.";
+	}
+
+	void ReorganiseToolFactory::printToolHelp(std::ostream& out) const
+	{
+		out << std::endl;
+		out << "Rewrite vertex buffers to a given layout" << std::endl
+			<< std::endl;
+		out << "The layout is written like the info tool prints it. Each element is a letter" << std::endl
+			<< "for its semantic, an optional index and an optional type in parentheses:" << std::endl
+			<< "p position, w blend weights, i blend indices, n normal, d diffuse, s specular," << std::endl
+			<< "u texture coordinates, b binormal, t tangent; types f1-f4, s1-s4, u4, bgra and" << std::endl
+			<< "rgba. Without index, elements of the same semantic are numbered in order," << std::endl
+			<< "without type the current one is kept. Buffers are separated by '-', ':n' at" << std::endl
+			<< "the end of a buffer pads its vertex size to a multiple of n bytes. Elements" << std::endl
+			<< "not in the layout are dropped. Float types convert into each other, as do" << std::endl
+			<< "colour types. Vertex data lacking an element of the layout is left as it is." << std::endl
+			<< std::endl;
+		out << "Options:" << std::endl;
+		out << "   -layout=str    - Target layout, e.g. p(f3)-n(f3)u(f2)t(f4) to give" << std::endl
+			<< "                    positions a buffer of their own for depth and shadow" << std::endl
+			<< "                    passes, or p(f3)n(f3)u(f2):32 to interleave fully." << std::endl
+			<< std::endl;
+	}
+}
@@ -0,0 +1,344 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmResampleTool.h"
+
+#include "MmOgreEnvironment.h"
+#include "MmStatefulSkeletonSerializer.h"
+#include "MmThreadPool.h"
+
+#include <OgreAnimationTrack.h>
+#include <OgreKeyFrame.h>
+#include <OgreStringConverter.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Ogre;
+
+namespace meshmagick
+{
+    ResampleTool::ResampleTool()
+        : Tool(),
+          mFrameRate(30),
+          mReduce(false),
+          mKeepIdentityTracks(false),
+          mTolerance(1e-3f),
+          mAngleTolerance(Degree(0.05f))
+    {
+    }
+
+    String ResampleTool::getName() const
+    {
+        return "resample";
+    }
+
+    void ResampleTool::doInvoke(const OptionList& toolOptions,
+        const StringVector& inFileNames, const StringVector& outFileNamesArg)
+    {
+        // Name count has to match, else we have no way to figure out how to apply output
+        // names to input files.
+        if (!(outFileNamesArg.empty() || inFileNames.size() == outFileNamesArg.size()))
+        {
+            fail("number of output files must match number of input files.");
+        }
+
+        mFrameRate = 30;
+        mReduce = false;
+        mKeepIdentityTracks = OptionsUtil::isOptionSet(toolOptions, "keep-identity-tracks");
+        mTolerance = 1e-3f;
+        mAngleTolerance = Degree(0.05f);
+        for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
+        {
+            if (it->first == "fps")
+            {
+                mFrameRate = any_cast<Real>(it->second);
+                if (!(mFrameRate > 0))
+                {
+                    fail("fps must be greater than zero.");
+                }
+            }
+            else if (it->first == "reduce")
+            {
+                mReduce = true;
+            }
+            else if (it->first == "tolerance")
+            {
+                mTolerance = any_cast<Real>(it->second);
+            }
+            else if (it->first == "angle-tolerance")
+            {
+                mAngleTolerance = Degree(any_cast<Real>(it->second));
+            }
+        }
+
+        StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
+
+        forEachFile(inFileNames.size(), [&](size_t i)
+        {
+            if (StringUtil::endsWith(inFileNames[i], ".skeleton", true))
+            {
+                processSkeletonFile(inFileNames[i], outFileNames[i]);
+            }
+            else
+            {
+                warn("unrecognised name ending for file " + inFileNames[i]);
+                warn("file skipped.");
+            }
+        });
+    }
+
+    void ResampleTool::processSkeletonFile(const String& inFile, const String& outFile)
+    {
+        StatefulSkeletonSerializer* skeletonSerializer =
+            OgreEnvironment::getSingleton().getSkeletonSerializer();
+
+        print("Loading skeleton " + inFile + "...");
+        SkeletonPtr skeleton;
+        try
+        {
+            skeleton = skeletonSerializer->loadSkeleton(inFile);
+        }
+        catch (std::exception& e)
+        {
+            warn(e.what());
+            warn("Unable to open skeleton file " + inFile);
+            warn("file skipped.");
+            return;
+        }
+
+        print("Resampling skeleton...");
+        processSkeleton(skeleton.get());
+        if (skeletonSerializer->saveSkeleton(outFile, true))
+        {
+            print("Skeleton saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Skeleton " + outFile + " unchanged, not written.");
+        }
+    }
+
+    void ResampleTool::processSkeleton(Skeleton* skeleton)
+    {
+        // Gather the tracks of all animations, tracks of one animation are contiguous.
+        const unsigned short numAnimations = skeleton->getNumAnimations();
+        std::vector<TrackSamples> tracks;
+        std::vector<size_t> firstTrack(numAnimations + 1, 0);
+        std::vector<size_t> keysBefore(numAnimations, 0);
+        for (unsigned short i = 0; i < numAnimations; ++i)
+        {
+            Animation* anim = skeleton->getAnimation(i);
+            firstTrack[i] = tracks.size();
+            Animation::NodeTrackIterator trackIt = anim->getNodeTrackIterator();
+            while (trackIt.hasMoreElements())
+            {
+                TrackSamples track;
+                track.animation = anim;
+                track.handle = trackIt.peekNextKey();
+                track.track = trackIt.getNext();
+                track.hasMotion = false;
+                track.isIdentity = true;
+                keysBefore[i] += track.track->getNumKeyFrames();
+                tracks.push_back(track);
+            }
+        }
+        firstTrack[numAnimations] = tracks.size();
+
+        // Sampling only reads the track, so every track is a job of its own.
+        ThreadPool pool(mNumThreads);
+        pool.run(tracks.size(), [&](size_t t)
+        {
+            sampleTrack(tracks[t]);
+        });
+
+        // Bones are only dropped from animations, if they stay in their binding pose in all
+        // of them. With averaging blend mode, a track in binding pose still weighs in, so
+        // all tracks are kept.
+        const bool dropIdentityTracks = !mKeepIdentityTracks
+            && skeleton->getBlendMode() != ANIMBLEND_AVERAGE;
+        std::vector<bool> isStatic(skeleton->getNumBones(), dropIdentityTracks);
+        for (size_t t = 0; t < tracks.size(); ++t)
+        {
+            if (!tracks[t].isIdentity && tracks[t].handle < isStatic.size())
+            {
+                isStatic[tracks[t].handle] = false;
+            }
+        }
+
+        // Replacing key frames marks the key frame times of their animation dirty,
+        // so all tracks of one animation are replaced by the same worker.
+        pool.run(numAnimations, [&](size_t i)
+        {
+            for (size_t t = firstTrack[i]; t < firstTrack[i + 1]; ++t)
+            {
+                TrackSamples& track = tracks[t];
+                if (track.handle < isStatic.size() && isStatic[track.handle])
+                {
+                    track.animation->destroyNodeTrack(track.handle);
+                    track.track = 0;
+                }
+                else if (!track.samples.empty())
+                {
+                    track.track->removeAllKeyFrames();
+                    for (KeySampleList::const_iterator it = track.samples.begin();
+                        it != track.samples.end(); ++it)
+                    {
+                        TransformKeyFrame* keyFrame = track.track->createNodeKeyFrame(it->time);
+                        keyFrame->setTranslate(it->translate);
+                        keyFrame->setRotation(it->rotation);
+                        keyFrame->setScale(it->scale);
+                    }
+                }
+            }
+        });
+
+        size_t totalTracksAfter = 0;
+        size_t totalKeysBefore = 0;
+        size_t totalKeysAfter = 0;
+        for (unsigned short i = 0; i < numAnimations; ++i)
+        {
+            size_t keysAfter = 0;
+            for (size_t t = firstTrack[i]; t < firstTrack[i + 1]; ++t)
+            {
+                if (tracks[t].track)
+                {
+                    ++totalTracksAfter;
+                    keysAfter += tracks[t].track->getNumKeyFrames();
+                }
+            }
+            print("Animation " + skeleton->getAnimation(i)->getName() + ": "
+                + StringConverter::toString(keysBefore[i]) + " -> "
+                + StringConverter::toString(keysAfter) + " key frames", V_HIGH);
+            totalKeysBefore += keysBefore[i];
+            totalKeysAfter += keysAfter;
+        }
+
+        // Each key frame is an object of its own, referenced from its track's list.
+        const size_t keyFrameSize = sizeof(TransformKeyFrame) + sizeof(KeyFrame*);
+        print("Tracks: " + StringConverter::toString(tracks.size()) + " -> "
+            + StringConverter::toString(totalTracksAfter));
+        print("Key frames: " + StringConverter::toString(totalKeysBefore) + " -> "
+            + StringConverter::toString(totalKeysAfter));
+        print("Key frame memory: " + StringConverter::toString(totalKeysBefore * keyFrameSize / 1024)
+            + " KB -> " + StringConverter::toString(totalKeysAfter * keyFrameSize / 1024) + " KB");
+    }
+
+    void ResampleTool::sampleTrack(TrackSamples& track) const
+    {
+        track.samples.clear();
+        track.hasMotion = false;
+        // The same test as Skeleton::optimiseAllAnimations, on the original key frames.
+        track.isIdentity = !track.track->hasNonZeroKeyFrames();
+        if (track.track->getNumKeyFrames() == 0)
+        {
+            return;
+        }
+
+        // The slack keeps rounding errors from adding a frame.
+        const Real length = track.animation->getLength();
+        const size_t numFrames = static_cast<size_t>(
+            std::max(Real(0), std::ceil(length * mFrameRate - 1e-3f)));
+        track.samples.resize(numFrames + 1);
+
+        TransformKeyFrame keyFrame(0, 0);
+        for (size_t k = 0; k <= numFrames; ++k)
+        {
+            KeySample& sample = track.samples[k];
+            // The last key sits at the end of the animation, so the last interval is
+            // shorter, if the length isn't a multiple of the frame time.
+            sample.time = std::min(k / mFrameRate, length);
+            track.track->getInterpolatedKeyFrame(TimeIndex(sample.time), &keyFrame);
+            sample.translate = keyFrame.getTranslate();
+            sample.rotation = keyFrame.getRotation();
+            sample.scale = keyFrame.getScale();
+        }
+
+        for (KeySampleList::const_iterator it = track.samples.begin(); it != track.samples.end(); ++it)
+        {
+            track.hasMotion = track.hasMotion || !equals(*it, track.samples.front());
+        }
+
+        if (!track.hasMotion)
+        {
+            track.samples.resize(1);
+        }
+        else if (mReduce && track.animation->getInterpolationMode() == Animation::IM_LINEAR)
+        {
+            reduceSamples(track.samples, track.animation->getRotationInterpolationMode(),
+                track.track->getUseShortestRotationPath());
+        }
+    }
+
+    void ResampleTool::reduceSamples(KeySampleList& samples,
+        Animation::RotationInterpolationMode mode, bool shortestPath) const
+    {
+        if (samples.size() < 3)
+        {
+            return;
+        }
+
+        // Greedily extend the span from the last kept key as long as interpolation
+        // reproduces every key within it.
+        KeySampleList reduced;
+        reduced.push_back(samples.front());
+        size_t anchor = 0;
+        for (size_t i = 1; i + 1 < samples.size(); ++i)
+        {
+            bool reproduced = true;
+            for (size_t j = anchor + 1; j <= i && reproduced; ++j)
+            {
+                reproduced = equals(interpolate(samples[anchor], samples[i + 1], samples[j].time,
+                    mode, shortestPath), samples[j]);
+            }
+            if (!reproduced)
+            {
+                reduced.push_back(samples[i]);
+                anchor = i;
+            }
+        }
+        reduced.push_back(samples.back());
+        samples.swap(reduced);
+    }
+
+    ResampleTool::KeySample ResampleTool::interpolate(const KeySample& a, const KeySample& b,
+        Real time, Animation::RotationInterpolationMode mode, bool shortestPath) const
+    {
+        const Real t = (time - a.time) / (b.time - a.time);
+        KeySample result;
+        result.time = time;
+        result.translate = a.translate + (b.translate - a.translate) * t;
+        result.scale = a.scale + (b.scale - a.scale) * t;
+        result.rotation = mode == Animation::RIM_LINEAR ?
+            Quaternion::nlerp(t, a.rotation, b.rotation, shortestPath) :
+            Quaternion::Slerp(t, a.rotation, b.rotation, shortestPath);
+        return result;
+    }
+
+    bool ResampleTool::equals(const KeySample& a, const KeySample& b) const
+    {
+        return a.translate.distance(b.translate) <= mTolerance
+            && a.scale.distance(b.scale) <= mTolerance
+            && a.rotation.equals(b.rotation, mAngleTolerance);
+    }
+}
@@ -0,0 +1,96 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmResampleToolFactory.h"
+
+#include "MmOptionsParser.h"
+#include "MmResampleTool.h"
+
+namespace meshmagick
+{
+
+	ResampleToolFactory::ResampleToolFactory()
+	{
+	}
+
+	ResampleToolFactory::~ResampleToolFactory()
+	{
+	}
+
+	Tool* ResampleToolFactory::createTool()
+	{
+		return new ResampleTool();
+	}
+
+	void ResampleToolFactory::destroyTool(Tool* tool)
+	{
+		delete tool;
+	}
+
+	OptionDefinitionSet ResampleToolFactory::getOptionDefinitions() const
+	{
+		OptionDefinitionSet optionDefs;
+		optionDefs.insert(OptionDefinition("fps", OT_REAL, false, false, Ogre::Any(Ogre::Real(30))));
+		optionDefs.insert(OptionDefinition("reduce", OT_BOOL, false, false));
+		optionDefs.insert(OptionDefinition("keep-identity-tracks", OT_BOOL, false, false));
+		optionDefs.insert(OptionDefinition("tolerance", OT_REAL, false, false,
+			Ogre::Any(Ogre::Real(1e-3))));
+		optionDefs.insert(OptionDefinition("angle-tolerance", OT_REAL, false, false,
+			Ogre::Any(Ogre::Real(0.05))));
+		return optionDefs;
+	}
+
+	Ogre::String ResampleToolFactory::getToolName() const
+	{
+		return "resample";
+	}
+
+	Ogre::String ResampleToolFactory::getToolDescription() const
+	{
+		return "Resample skeleton animations to a fixed frame rate.";
+	}
+
+	void ResampleToolFactory::printToolHelp(std::ostream& out) const
+	{
+		out << std::endl;
+		out << "Resample skeleton animations to a fixed frame rate" << std::endl
+			<< std::endl;
+		out << "Every bone track is sampled at uniformly spaced times and its key frames are" << std::endl
+			<< "replaced by the samples. The last sample is taken at the end of the animation," << std::endl
+			<< "so the last interval is shorter, if the length isn't a multiple of the frame" << std::endl
+			<< "time. Tracks without motion keep a single key frame, tracks" << std::endl
+			<< "of bones staying in binding pose in all animations are removed, unless the" << std::endl
+			<< "skeleton's blend mode is average." << std::endl
+			<< "Key frame counts and memory before and after are reported." << std::endl
+			<< std::endl;
+		out << "Options:" << std::endl;
+		out << "   -fps=val       - Key frames per second. (default 30)" << std::endl;
+		out << "   -reduce        - Afterwards remove keys, that linear interpolation of their" << std::endl
+			<< "                    neighbours reproduces within the tolerances. Keys are not" << std::endl
+			<< "                    uniformly spaced anymore then." << std::endl;
+		out << "   -keep-identity-tracks - Keep tracks of bones staying in binding pose." << std::endl;
+		out << "   -tolerance=val - Maximum translation and scale error. (default 0.001)" << std::endl;
+		out << "   -angle-tolerance=deg - Maximum rotation error in degrees. (default 0.05)" << std::endl
+			<< std::endl;
+	}
+}
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include <iostream>
 #include <stdexcept>
 
+#include "MmBufferedFileWriter.h"
 #include "MmEditableMesh.h"
 
 using namespace Ogre;
@@ -40,11 +41,6 @@ namespace meshmagick
 
     MeshPtr StatefulMeshSerializer::loadMesh(const String& name)
     {
-        MeshManager* mm = MeshManager::getSingletonPtr();
-        MeshPtr mesh = mm->create(name, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
-        mMesh = MeshPtr(new EditableMesh(mm, name, mesh->getHandle(),
-			ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
-
         std::ifstream ifs;
         ifs.open(name.c_str(), std::ios_base::in | std::ios_base::binary);
         if (!ifs)
@@ -53,17 +49,29 @@ namespace meshmagick
         }
 
         DataStreamPtr stream(new FileStreamDataStream(name, &ifs, false));
+        MeshPtr mesh = loadMesh(name, stream);
+
+        ifs.close();
+
+        return mesh;
+    }
+
+    MeshPtr StatefulMeshSerializer::loadMesh(const String& name, DataStreamPtr stream)
+    {
+        MeshManager* mm = MeshManager::getSingletonPtr();
+        MeshPtr mesh = mm->create(name, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+        mCreatedResources.push_back(name);
+        mMesh = MeshPtr(new EditableMesh(mm, name, mesh->getHandle(),
+			ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
 
         determineFileFormat(stream);
 
         importMesh(stream, mMesh.get());
 
-        ifs.close();
-
         return mMesh;
     }
 
-    void StatefulMeshSerializer::saveMesh(const Ogre::String& name, bool keepEndianess)
+    bool StatefulMeshSerializer::saveMesh(const Ogre::String& name, bool keepEndianess)
     {
         if (!mMesh)
         {
@@ -71,7 +79,15 @@ namespace meshmagick
         }
 
         Endian endianMode = keepEndianess ? mMeshFileEndian : ENDIAN_NATIVE;
-        exportMesh(mMesh.get(), name, endianMode);
+        return saveMesh(mMesh.get(), name, endianMode);
+    }
+
+    bool StatefulMeshSerializer::saveMesh(const Mesh* mesh, const Ogre::String& name,
+        Endian endianMode)
+    {
+        BufferedFileWriter writer;
+        exportMesh(mesh, writer.getStream(), endianMode);
+        return writer.commit(name);
     }
 
     void StatefulMeshSerializer::clear()
@@ -81,6 +97,24 @@ namespace meshmagick
         mMeshFileVersion = "";
     }
 
+    void StatefulMeshSerializer::releaseResources()
+    {
+        clear();
+
+        MeshManager* mm = MeshManager::getSingletonPtr();
+        for (StringVector::const_iterator it = mCreatedResources.begin();
+            it != mCreatedResources.end(); ++it)
+        {
+            ResourcePtr res = mm->getResourceByName(*it,
+                ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+            if (res)
+            {
+                mm->remove(res);
+            }
+        }
+        mCreatedResources.clear();
+    }
+
     MeshPtr StatefulMeshSerializer::getMesh() const
     {
         return mMesh;
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include <iostream>
 #include <stdexcept>
 
+#include "MmBufferedFileWriter.h"
 #include "MmEditableSkeleton.h"
 
 using namespace Ogre;
@@ -39,6 +40,23 @@ namespace meshmagick
     const unsigned short HEADER_CHUNK_ID = 0x1000;
 
     SkeletonPtr StatefulSkeletonSerializer::loadSkeleton(const String& name)
+    {
+        std::ifstream ifs;
+        ifs.open(name.c_str(), std::ios_base::in | std::ios_base::binary);
+        if (!ifs)
+        {
+            throw std::ios_base::failure(("cannot open file " + name).c_str());
+        }
+
+        DataStreamPtr stream(new FileStreamDataStream(name, &ifs, false));
+        SkeletonPtr skeleton = loadSkeleton(name, stream);
+
+        ifs.close();
+
+		return skeleton;
+    }
+
+    SkeletonPtr StatefulSkeletonSerializer::loadSkeleton(const String& name, DataStreamPtr stream)
     {
         // Resource already created upon mesh loading?
         mSkeleton = SkeletonManager::getSingleton().getByName(name, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
@@ -47,29 +65,19 @@ namespace meshmagick
             // Nope. We create it here then.
             mSkeleton = SkeletonManager::getSingleton().create(name, 
                 ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+            mCreatedResources.push_back(name);
         }
 
 		mSkeleton = SkeletonPtr(new EditableSkeleton(*mSkeleton.get()));
 
-        std::ifstream ifs;
-        ifs.open(name.c_str(), std::ios_base::in | std::ios_base::binary);
-        if (!ifs)
-        {
-            throw std::ios_base::failure(("cannot open file " + name).c_str());
-        }
-
-        DataStreamPtr stream(new FileStreamDataStream(name, &ifs, false));
-
         determineFileFormat(stream);
 
         importSkeleton(stream, mSkeleton.get());
 
-        ifs.close();
-
 		return mSkeleton;
     }
 
-    void StatefulSkeletonSerializer::saveSkeleton(const String& name, bool keepEndianess)
+    bool StatefulSkeletonSerializer::saveSkeleton(const String& name, bool keepEndianess)
     {
         if (!mSkeleton)
         {
@@ -77,7 +85,15 @@ namespace meshmagick
         }
 
         Endian endianMode = keepEndianess ? mSkeletonFileEndian : ENDIAN_NATIVE;
-        exportSkeleton(mSkeleton.get(), name, SKELETON_VERSION_LATEST, endianMode);
+        return saveSkeleton(mSkeleton.get(), name, endianMode);
+    }
+
+    bool StatefulSkeletonSerializer::saveSkeleton(const Skeleton* skeleton, const String& name,
+        Endian endianMode)
+    {
+        BufferedFileWriter writer;
+        exportSkeleton(skeleton, writer.getStream(), SKELETON_VERSION_LATEST, endianMode);
+        return writer.commit(name);
     }
 
     void StatefulSkeletonSerializer::clear()
@@ -85,11 +101,34 @@ namespace meshmagick
         mSkeleton.reset();
     }
 
+    void StatefulSkeletonSerializer::releaseResources()
+    {
+        clear();
+
+        SkeletonManager* sm = SkeletonManager::getSingletonPtr();
+        for (StringVector::const_iterator it = mCreatedResources.begin();
+            it != mCreatedResources.end(); ++it)
+        {
+            ResourcePtr res = sm->getResourceByName(*it,
+                ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+            if (res)
+            {
+                sm->remove(res);
+            }
+        }
+        mCreatedResources.clear();
+    }
+
     SkeletonPtr StatefulSkeletonSerializer::getSkeleton() const
     {
         return mSkeleton;
     }
 
+    Ogre::Serializer::Endian StatefulSkeletonSerializer::getEndianMode() const
+    {
+        return mSkeletonFileEndian;
+    }
+
     void StatefulSkeletonSerializer::determineFileFormat(DataStreamPtr stream)
     {
         determineEndianness(stream);
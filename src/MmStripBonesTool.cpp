@@ -0,0 +1,397 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmStripBonesTool.h"
+
+#include "MmEditableSkeleton.h"
+#include "MmOgreEnvironment.h"
+#include "MmStatefulMeshSerializer.h"
+#include "MmStatefulSkeletonSerializer.h"
+
+#include <OgreAnimation.h>
+#include <OgreAnimationTrack.h>
+#include <OgreBone.h>
+#include <OgreKeyFrame.h>
+#include <OgreStringConverter.h>
+#include <OgreSubMesh.h>
+
+using namespace Ogre;
+
+namespace meshmagick
+{
+    const unsigned short StripBonesTool::NO_BONE;
+
+    StripBonesTool::StripBonesTool()
+        : Tool(), mKeepBones()
+    {
+    }
+
+    String StripBonesTool::getName() const
+    {
+        return "stripbones";
+    }
+
+    void StripBonesTool::doInvoke(const OptionList& toolOptions,
+        const StringVector& inFileNames, const StringVector& outFileNamesArg)
+    {
+        // Name count has to match, else we have no way to figure out how to apply output
+        // names to input files.
+        if (!(outFileNamesArg.empty() || inFileNames.size() == outFileNamesArg.size()))
+        {
+            fail("number of output files must match number of input files.");
+        }
+        const StringVector& outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
+
+        mKeepBones.clear();
+        for (OptionList::const_iterator it = toolOptions.begin(); it != toolOptions.end(); ++it)
+        {
+            if (it->first == "keep")
+            {
+                mKeepBones.push_back(any_cast<String>(it->second));
+            }
+        }
+
+        const size_t noFile = static_cast<size_t>(-1);
+        size_t skeletonFile = noFile;
+        std::vector<size_t> meshFiles;
+        for (size_t i = 0; i < inFileNames.size(); ++i)
+        {
+            if (StringUtil::endsWith(inFileNames[i], ".skeleton", true))
+            {
+                if (skeletonFile != noFile)
+                {
+                    fail("only one skeleton can be stripped at a time.");
+                }
+                skeletonFile = i;
+            }
+            else if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
+            {
+                meshFiles.push_back(i);
+            }
+            else
+            {
+                warn("unrecognised name ending for file " + inFileNames[i]);
+                warn("file skipped.");
+            }
+        }
+        if (skeletonFile == noFile)
+        {
+            fail("no skeleton file given.");
+        }
+        if (meshFiles.empty())
+        {
+            fail("no mesh file given, all meshes using the skeleton are needed.");
+        }
+
+        StatefulSkeletonSerializer* skeletonSerializer =
+            OgreEnvironment::getSingleton().getSkeletonSerializer();
+        StatefulMeshSerializer* meshSerializer =
+            OgreEnvironment::getSingleton().getMeshSerializer();
+
+        const String& skeletonInFile = inFileNames[skeletonFile];
+        print("Loading skeleton " + skeletonInFile + "...");
+        SkeletonPtr skeleton;
+        try
+        {
+            skeleton = skeletonSerializer->loadSkeleton(skeletonInFile);
+        }
+        catch (std::exception& e)
+        {
+            warn(e.what());
+            fail("Unable to open skeleton file " + skeletonInFile);
+        }
+        const Serializer::Endian skeletonEndian = skeletonSerializer->getEndianMode();
+
+        // A mesh left out would lose the bones it needs, so all of them have to load.
+        String skeletonBaseName, path;
+        StringUtil::splitFilename(skeletonInFile, skeletonBaseName, path);
+        std::vector<MeshPtr> meshes;
+        std::vector<Mesh*> meshPtrs;
+        std::vector<Serializer::Endian> meshEndians;
+        for (size_t i = 0; i < meshFiles.size(); ++i)
+        {
+            const String& inFile = inFileNames[meshFiles[i]];
+            print("Loading mesh " + inFile + "...");
+            MeshPtr mesh;
+            try
+            {
+                mesh = meshSerializer->loadMesh(inFile);
+            }
+            catch (std::exception& e)
+            {
+                warn(e.what());
+                fail("Unable to open mesh file " + inFile);
+            }
+
+            String linkedBaseName;
+            StringUtil::splitFilename(mesh->getSkeletonName(), linkedBaseName, path);
+            if (linkedBaseName != skeletonBaseName)
+            {
+                warn("mesh " + inFile + " references skeleton '" + mesh->getSkeletonName()
+                    + "', not " + skeletonBaseName + ".");
+            }
+
+            meshes.push_back(mesh);
+            meshPtrs.push_back(mesh.get());
+            meshEndians.push_back(meshSerializer->getEndianMode());
+        }
+
+        print("Stripping bones...");
+        SkeletonPtr stripped = stripBones(skeleton.get(), meshPtrs);
+        if (!stripped)
+        {
+            print("All bones are used.");
+            stripped = skeleton;
+        }
+        else
+        {
+            print("Removed " + StringConverter::toString(
+                skeleton->getNumBones() - stripped->getNumBones()) + " of "
+                + StringConverter::toString(skeleton->getNumBones()) + " bones.");
+        }
+
+        const String& skeletonOutFile = outFileNames[skeletonFile];
+        if (skeletonSerializer->saveSkeleton(stripped.get(), skeletonOutFile, skeletonEndian))
+        {
+            print("Skeleton saved as " + skeletonOutFile + ".");
+        }
+        else
+        {
+            print("Skeleton " + skeletonOutFile + " unchanged, not written.");
+        }
+
+        for (size_t i = 0; i < meshFiles.size(); ++i)
+        {
+            const String& outFile = outFileNames[meshFiles[i]];
+            if (meshSerializer->saveMesh(meshes[i].get(), outFile, meshEndians[i]))
+            {
+                print("Mesh saved as " + outFile + ".");
+            }
+            else
+            {
+                print("Mesh " + outFile + " unchanged, not written.");
+            }
+        }
+
+        OgreEnvironment::getSingleton().releaseFileResources();
+    }
+
+    SkeletonPtr StripBonesTool::stripBones(const Skeleton* skeleton,
+        const std::vector<Mesh*>& meshes)
+    {
+        const unsigned short numBones = skeleton->getNumBones();
+        std::vector<bool> keep(numBones, false);
+
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            Mesh* mesh = meshes[i];
+            markReferencedBones(mesh->getBoneAssignments(), mesh->getName(), keep);
+            for (unsigned short s = 0; s < mesh->getNumSubMeshes(); ++s)
+            {
+                markReferencedBones(mesh->getSubMesh(s)->getBoneAssignments(), mesh->getName(), keep);
+            }
+        }
+
+        for (StringVector::const_iterator it = mKeepBones.begin(); it != mKeepBones.end(); ++it)
+        {
+            if (skeleton->hasBone(*it))
+            {
+                keep[skeleton->getBone(*it)->getHandle()] = true;
+            }
+            else
+            {
+                warn("bone " + *it + " to keep not found in skeleton.");
+            }
+        }
+
+        // Ancestors of kept bones have to stay, their transforms are inherited.
+        for (unsigned short handle = 0; handle < numBones; ++handle)
+        {
+            if (!keep[handle])
+            {
+                continue;
+            }
+            for (Node* parent = skeleton->getBone(handle)->getParent(); parent != 0;
+                parent = parent->getParent())
+            {
+                keep[static_cast<Bone*>(parent)->getHandle()] = true;
+            }
+        }
+
+        BoneHandleMap handleMap(numBones, NO_BONE);
+        unsigned short numKept = 0;
+        for (unsigned short handle = 0; handle < numBones; ++handle)
+        {
+            if (keep[handle])
+            {
+                handleMap[handle] = numKept++;
+            }
+            else
+            {
+                print("Removing bone " + skeleton->getBone(handle)->getName(), V_HIGH);
+            }
+        }
+
+        if (numKept == numBones)
+        {
+            return SkeletonPtr();
+        }
+
+        SkeletonPtr stripped = createStrippedSkeleton(skeleton, handleMap);
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            remapBoneAssignments(meshes[i], handleMap);
+        }
+        return stripped;
+    }
+
+    void StripBonesTool::markReferencedBones(const Mesh::VertexBoneAssignmentList& assignments,
+        const String& meshName, std::vector<bool>& keep) const
+    {
+        for (Mesh::VertexBoneAssignmentList::const_iterator it = assignments.begin();
+            it != assignments.end(); ++it)
+        {
+            if (it->second.boneIndex >= keep.size())
+            {
+                fail("mesh " + meshName + " references bone "
+                    + StringConverter::toString(it->second.boneIndex)
+                    + ", which is not in the skeleton.");
+            }
+            keep[it->second.boneIndex] = true;
+        }
+    }
+
+    SkeletonPtr StripBonesTool::createStrippedSkeleton(const Skeleton* skeleton,
+        const BoneHandleMap& handleMap) const
+    {
+        SkeletonPtr stripped(new EditableSkeleton(*skeleton));
+        stripped->setBlendMode(skeleton->getBlendMode());
+
+        const unsigned short numBones = skeleton->getNumBones();
+        for (unsigned short handle = 0; handle < numBones; ++handle)
+        {
+            if (handleMap[handle] == NO_BONE)
+            {
+                continue;
+            }
+            const Bone* bone = skeleton->getBone(handle);
+            Bone* newBone = stripped->createBone(bone->getName(), handleMap[handle]);
+            newBone->setPosition(bone->getPosition());
+            newBone->setOrientation(bone->getOrientation());
+            newBone->setScale(bone->getScale());
+        }
+
+        // Parents are kept along with their children, so the hierarchy stays intact.
+        for (unsigned short handle = 0; handle < numBones; ++handle)
+        {
+            const Node* parent = skeleton->getBone(handle)->getParent();
+            if (handleMap[handle] != NO_BONE && parent)
+            {
+                stripped->getBone(handleMap[static_cast<const Bone*>(parent)->getHandle()])
+                    ->addChild(stripped->getBone(handleMap[handle]));
+            }
+        }
+        stripped->setBindingPose();
+
+        for (unsigned short i = 0; i < skeleton->getNumAnimations(); ++i)
+        {
+            const Animation* anim = skeleton->getAnimation(i);
+            Animation* newAnim = stripped->createAnimation(anim->getName(), anim->getLength());
+            newAnim->setInterpolationMode(anim->getInterpolationMode());
+            newAnim->setRotationInterpolationMode(anim->getRotationInterpolationMode());
+            if (anim->getUseBaseKeyFrame())
+            {
+                newAnim->setUseBaseKeyFrame(true, anim->getBaseKeyFrameTime(),
+                    anim->getBaseKeyFrameAnimationName());
+            }
+
+            // Tracks of removed bones are dropped.
+            const Animation::NodeTrackList& tracks = anim->_getNodeTrackList();
+            for (Animation::NodeTrackList::const_iterator it = tracks.begin();
+                it != tracks.end(); ++it)
+            {
+                if (it->first >= numBones || handleMap[it->first] == NO_BONE)
+                {
+                    continue;
+                }
+                const NodeAnimationTrack* track = it->second;
+                const unsigned short newHandle = handleMap[it->first];
+                NodeAnimationTrack* newTrack =
+                    newAnim->createNodeTrack(newHandle, stripped->getBone(newHandle));
+                newTrack->setUseShortestRotationPath(track->getUseShortestRotationPath());
+                for (unsigned short k = 0; k < track->getNumKeyFrames(); ++k)
+                {
+                    const TransformKeyFrame* keyFrame = track->getNodeKeyFrame(k);
+                    TransformKeyFrame* newKeyFrame = newTrack->createNodeKeyFrame(keyFrame->getTime());
+                    newKeyFrame->setTranslate(keyFrame->getTranslate());
+                    newKeyFrame->setRotation(keyFrame->getRotation());
+                    newKeyFrame->setScale(keyFrame->getScale());
+                }
+            }
+        }
+
+        Skeleton::LinkedSkeletonAnimSourceIterator linkIt =
+            skeleton->getLinkedSkeletonAnimationSourceIterator();
+        while (linkIt.hasMoreElements())
+        {
+            const LinkedSkeletonAnimationSource& link = linkIt.getNext();
+            warn("animations linked from " + link.skeletonName
+                + " still use the old bone handles.");
+            try
+            {
+                stripped->addLinkedSkeletonAnimationSource(link.skeletonName, link.scale);
+            }
+            catch (std::exception& e)
+            {
+                warn(e.what());
+            }
+        }
+
+        return stripped;
+    }
+
+    void StripBonesTool::remapBoneAssignments(Mesh* mesh, const BoneHandleMap& handleMap)
+    {
+        Mesh::VertexBoneAssignmentList assignments = mesh->getBoneAssignments();
+        mesh->clearBoneAssignments();
+        for (Mesh::VertexBoneAssignmentList::iterator it = assignments.begin();
+            it != assignments.end(); ++it)
+        {
+            it->second.boneIndex = handleMap[it->second.boneIndex];
+            mesh->addBoneAssignment(it->second);
+        }
+
+        for (unsigned short s = 0; s < mesh->getNumSubMeshes(); ++s)
+        {
+            SubMesh* submesh = mesh->getSubMesh(s);
+            SubMesh::VertexBoneAssignmentList subAssignments = submesh->getBoneAssignments();
+            submesh->clearBoneAssignments();
+            for (SubMesh::VertexBoneAssignmentList::iterator it = subAssignments.begin();
+                it != subAssignments.end(); ++it)
+            {
+                it->second.boneIndex = handleMap[it->second.boneIndex];
+                submesh->addBoneAssignment(it->second);
+            }
+        }
+    }
+}
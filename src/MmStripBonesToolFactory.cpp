@@ -0,0 +1,83 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmStripBonesToolFactory.h"
+
+#include "MmOptionsParser.h"
+#include "MmStripBonesTool.h"
+
+namespace meshmagick
+{
+
+	StripBonesToolFactory::StripBonesToolFactory()
+	{
+	}
+
+	StripBonesToolFactory::~StripBonesToolFactory()
+	{
+	}
+
+	Tool* StripBonesToolFactory::createTool()
+	{
+		return new StripBonesTool();
+	}
+
+	void StripBonesToolFactory::destroyTool(Tool* tool)
+	{
+		delete tool;
+	}
+
+	OptionDefinitionSet StripBonesToolFactory::getOptionDefinitions() const
+	{
+		OptionDefinitionSet optionDefs;
+		optionDefs.insert(OptionDefinition("keep", OT_STRING, false, true));
+		return optionDefs;
+	}
+
+	Ogre::String StripBonesToolFactory::getToolName() const
+	{
+		return "stripbones";
+	}
+
+	Ogre::String StripBonesToolFactory::getToolDescription() const
+	{
+		return "Remove bones no vertex is assigned to from a skeleton.";
+	}
+
+	void StripBonesToolFactory::printToolHelp(std::ostream& out) const
+	{
+		out << std::endl;
+		out << "Remove bones no vertex is assigned to from a skeleton" << std::endl
+			<< std::endl;
+		out << "Input files are one skeleton and all meshes using it. Bones referenced by a" << std::endl
+			<< "bone assignment of one of the meshes are kept along with their ancestors," << std::endl
+			<< "all others are removed. Bone handles are renumbered, bone assignments and" << std::endl
+			<< "animation tracks are remapped accordingly. Meshes using the skeleton, that" << std::endl
+			<< "are not given, won't work with the stripped skeleton anymore." << std::endl
+			<< std::endl;
+		out << "Options:" << std::endl;
+		out << "   -keep=name     - Keep named bone, e.g. one objects are attached to." << std::endl
+			<< "                    Can be given multiple times." << std::endl
+			<< std::endl;
+	}
+}
@@ -0,0 +1,129 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace meshmagick
+{
+    ThreadPool::ThreadPool(size_t numThreads)
+        : mNumThreads(numThreads > 0 ? numThreads : getHardwareThreadCount())
+    {
+    }
+
+    size_t ThreadPool::getNumThreads() const
+    {
+        return mNumThreads;
+    }
+
+    void ThreadPool::run(size_t numJobs, const Job& job) const
+    {
+        const size_t numWorkers = std::min(mNumThreads, numJobs);
+        if (numWorkers <= 1)
+        {
+            // Not worth spinning up threads.
+            for (size_t i = 0; i < numJobs; ++i)
+            {
+                job(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> nextJob(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr firstError;
+        std::mutex errorMutex;
+
+        auto worker = [&]()
+        {
+            for (size_t i = nextJob++; i < numJobs && !failed; i = nextJob++)
+            {
+                try
+                {
+                    job(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!firstError)
+                    {
+                        firstError = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+
+        // The calling thread is one of the workers.
+        std::vector<std::thread> threads;
+        threads.reserve(numWorkers - 1);
+        for (size_t i = 1; i < numWorkers; ++i)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            threads[i].join();
+        }
+
+        if (firstError)
+        {
+            std::rethrow_exception(firstError);
+        }
+    }
+
+    void ThreadPool::runWindowed(size_t numJobs, const Job& parallelJob, const Job& serialJob,
+        const WindowJob& windowJob) const
+    {
+        const size_t windowSize = mNumThreads * 4;
+        for (size_t first = 0; first < numJobs; first += windowSize)
+        {
+            const size_t count = std::min(windowSize, numJobs - first);
+            run(count, [&](size_t i)
+            {
+                parallelJob(first + i);
+            });
+            for (size_t i = 0; i < count; ++i)
+            {
+                serialJob(first + i);
+            }
+            if (windowJob)
+            {
+                windowJob(first, count);
+            }
+        }
+    }
+
+    size_t ThreadPool::getHardwareThreadCount()
+    {
+        unsigned int count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+}
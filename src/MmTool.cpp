@@ -23,17 +23,22 @@ THE SOFTWARE.
 
 #include "MmTool.h"
 
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <OgreLog.h>
+#include <OgreStringConverter.h>
 
+#include "MmBufferedFileWriter.h"
 #include "MmOgreEnvironment.h"
+#include "MmToolUtils.h"
 
 using namespace Ogre;
 
 namespace meshmagick
 {
-    Tool::Tool() : mVerbosity(V_NORMAL), mFollowSkeletonLink(true)
+    Tool::Tool() : mVerbosity(V_NORMAL), mFollowSkeletonLink(true), mReportMemory(false),
+        mMemoryBudget(0), mNumThreads(0)
     {
     }
 
@@ -45,7 +50,14 @@ namespace meshmagick
         const StringVector& inFileNames, const StringVector& outFileNames)
     {
         setGlobalOptions(globalOptions);
+        mProcessedSkeletons.clear();
         doInvoke(toolOptions, inFileNames, outFileNames);
+        mProcessedSkeletons.clear();
+
+        if (mReportMemory)
+        {
+            reportMemoryUse();
+        }
     }
 
     void Tool::setGlobalOptions(const OptionList& globalOptions)
@@ -53,6 +65,9 @@ namespace meshmagick
         // Reset to defaults..
         mVerbosity = V_NORMAL;
         mFollowSkeletonLink = true;
+        mReportMemory = false;
+        mMemoryBudget = 0;
+        mNumThreads = 0;
 
         for (OptionList::const_iterator it = globalOptions.begin(); it != globalOptions.end(); ++it)
         {
@@ -68,6 +83,36 @@ namespace meshmagick
             {
                 mVerbosity = V_HIGH;
             }
+            else if (it->first == "memory-budget")
+            {
+                int budget = any_cast<int>(it->second);
+                mReportMemory = true;
+                mMemoryBudget = budget > 0 ? static_cast<size_t>(budget) : 0;
+            }
+            else if (it->first == "threads")
+            {
+                int threads = any_cast<int>(it->second);
+                mNumThreads = threads > 0 ? static_cast<size_t>(threads) : 0;
+            }
+        }
+    }
+
+    void Tool::reportMemoryUse() const
+    {
+        size_t peak = ToolUtils::getPeakResidentMemory() / (1024 * 1024);
+        if (peak == 0)
+        {
+            warn("peak resident memory not available on this platform.");
+            return;
+        }
+
+        // Diagnostics go to stderr, so that they don't end up in json or csv output.
+        print("Peak resident memory: " + StringConverter::toString(peak) + " MB", V_NORMAL,
+            std::cerr);
+        if (mMemoryBudget > 0 && peak > mMemoryBudget)
+        {
+            warn("peak resident memory exceeds the budget of "
+                + StringConverter::toString(mMemoryBudget) + " MB.");
         }
     }
 
@@ -95,4 +140,72 @@ namespace meshmagick
         print("fatal error: " + msg, V_QUIET, std::cerr);
         throw std::logic_error(msg);
     }
+
+    bool Tool::isSkeletonProcessed(const Ogre::String& inFile, const Ogre::String& outFile)
+    {
+        ProcessedSkeletonMap::const_iterator it =
+            mProcessedSkeletons.find(ToolUtils::getResolvedFileName(inFile));
+        if (it == mProcessedSkeletons.end())
+        {
+            return false;
+        }
+
+        if (it->second == ToolUtils::getResolvedFileName(outFile))
+        {
+            print("Skeleton " + inFile + " already processed.", V_HIGH);
+            return true;
+        }
+
+        // Processed before, but written somewhere else. Copy the result over.
+        std::ifstream in(it->second.c_str(), std::ios::in | std::ios::binary);
+        if (!in)
+        {
+            // Previous output vanished, let the caller process it again.
+            return false;
+        }
+        BufferedFileWriter writer;
+        DataStreamPtr stream = writer.getStream();
+        char buffer[64 * 1024];
+        while (in)
+        {
+            in.read(buffer, sizeof(buffer));
+            stream->write(buffer, static_cast<size_t>(in.gcount()));
+        }
+        if (writer.commit(outFile))
+        {
+            print("Skeleton " + inFile + " already processed, copied to " + outFile + ".");
+        }
+        else
+        {
+            print("Skeleton " + outFile + " unchanged, not written.");
+        }
+        return true;
+    }
+
+    void Tool::setSkeletonProcessed(const Ogre::String& inFile, const Ogre::String& outFile)
+    {
+        mProcessedSkeletons[ToolUtils::getResolvedFileName(inFile)] =
+            ToolUtils::getResolvedFileName(outFile);
+    }
+
+    void Tool::forEachFile(size_t numFiles, const ThreadPool::Job& job) const
+    {
+        for (size_t i = 0; i < numFiles; ++i)
+        {
+            job(i);
+            OgreEnvironment::getSingleton().releaseFileResources();
+        }
+    }
+
+    void Tool::forEachFile(size_t numFiles, const ThreadPool::Job& parallelJob,
+        const ThreadPool::Job& job, const ThreadPool::WindowJob& windowJob) const
+    {
+        ThreadPool pool(mNumThreads);
+        pool.runWindowed(numFiles, parallelJob, [&](size_t i)
+        {
+            job(i);
+            OgreEnvironment::getSingleton().releaseFileResources();
+        },
+        windowJob);
+    }
 }
@@ -23,9 +23,25 @@ THE SOFTWARE.
 
 #include "MmToolUtils.h"
 
+#include <OgreArchiveManager.h>
 #include <OgreMesh.h>
 #include <OgreStringConverter.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+#   include <stdlib.h>
+#   include <windows.h>
+#   include <psapi.h>
+#else
+#   include <limits.h>
+#   include <sys/resource.h>
+#endif
+
 using namespace Ogre;
 
 namespace meshmagick
@@ -133,5 +149,142 @@ namespace meshmagick
         fin.close();
         return false;
     }
-}
 
+    String ToolUtils::getResolvedFileName(const String& fileName)
+    {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        char resolved[_MAX_PATH];
+        if (_fullpath(resolved, fileName.c_str(), _MAX_PATH) == NULL)
+        {
+            return fileName;
+        }
+        String rval = resolved;
+        // Windows file names are case insensitive.
+        StringUtil::toLowerCase(rval);
+        return rval;
+#else
+        char resolved[PATH_MAX];
+        if (realpath(fileName.c_str(), resolved) == NULL)
+        {
+            return fileName;
+        }
+        return resolved;
+#endif
+    }
+
+    size_t ToolUtils::getPeakResidentMemory()
+    {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#   if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+        // Reported in bytes on Mac OS X...
+        return static_cast<size_t>(usage.ru_maxrss);
+#   else
+        // ...and in kilobytes elsewhere.
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#   endif
+#endif
+    }
+
+    bool ToolUtils::isDirectory(const Ogre::String& fileName)
+    {
+        struct stat st;
+        return stat(fileName.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+    }
+
+    StringVector ToolUtils::findFiles(const String& directory, const StringVector& patterns)
+    {
+        StringVector rval;
+
+        Archive* archive = ArchiveManager::getSingleton().load(directory, "FileSystem", true);
+        const String path = StringUtil::standardisePath(directory);
+        for (size_t i = 0; i < patterns.size(); ++i)
+        {
+            StringVectorPtr files = archive->find(patterns[i], true, false);
+            for (StringVector::const_iterator it = files->begin(); it != files->end(); ++it)
+            {
+                rval.push_back(path + *it);
+            }
+        }
+        ArchiveManager::getSingleton().unload(archive);
+
+        // Order depends on the file system otherwise.
+        std::sort(rval.begin(), rval.end());
+        rval.erase(std::unique(rval.begin(), rval.end()), rval.end());
+        return rval;
+    }
+
+    void ToolUtils::readFile(const String& fileName, std::vector<unsigned char>& contents)
+    {
+        std::ifstream ifs(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+        if (!ifs)
+        {
+            // Leave it to the loader to report the error.
+            return;
+        }
+        ifs.seekg(0, std::ios_base::end);
+        const std::streamoff size = ifs.tellg();
+        ifs.seekg(0, std::ios_base::beg);
+        if (size <= 0)
+        {
+            return;
+        }
+        contents.resize(static_cast<size_t>(size));
+        if (!ifs.read(reinterpret_cast<char*>(&contents[0]), size))
+        {
+            contents.clear();
+        }
+    }
+
+    String ToolUtils::getJsonString(const String& str)
+    {
+        String rval = "\"";
+        for (String::const_iterator it = str.begin(); it != str.end(); ++it)
+        {
+            const unsigned char c = static_cast<unsigned char>(*it);
+            switch (c)
+            {
+            case '"':
+                rval += "\\\"";
+                break;
+            case '\\':
+                rval += "\\\\";
+                break;
+            case '\n':
+                rval += "\\n";
+                break;
+            case '\r':
+                rval += "\\r";
+                break;
+            case '\t':
+                rval += "\\t";
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    char buf[8];
+                    sprintf(buf, "\\u%04x", c);
+                    rval += buf;
+                }
+                else
+                {
+                    // Everything else, including UTF-8 sequences, is passed through.
+                    rval += *it;
+                }
+            }
+        }
+        rval += "\"";
+        return rval;
+    }
+}
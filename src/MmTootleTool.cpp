@@ -26,13 +26,19 @@ THE SOFTWARE.
 #include <tootlelib.h>
 
 #include <OgreMesh.h>
+#include <OgreStringConverter.h>
 #include <OgreSubMesh.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
 #include <sstream>
 
 #include "MmOgreEnvironment.h"
-#include "MmOptimiseTool.h"
 #include "MmStatefulMeshSerializer.h"
+#include "MmThreadPool.h"
 
 using namespace Ogre;
 
@@ -83,255 +89,175 @@ namespace meshmagick
 		}
 	}
 
-	void FillMeshData(HardwareIndexBufferSharedPtr indexBuffer,
-		VertexDeclaration *vertexDeclaration,
-		VertexBufferBinding* vertexBufferBinding,
-		std::vector<UniqueVertex> & vertices,
-		std::vector<unsigned int> &indices,
-		size_t numvertices)
+	/// Vertex data referenced by one or more Tootle jobs. Its positions are extracted
+	/// only once and shared by all submeshes and LOD levels using it.
+	struct TootleVertexSource
 	{
-		// Lock all the buffers first
-		typedef std::vector<char*> BufferLocks;
-		BufferLocks bufferLocks;
-		const auto& bindings =
-			vertexBufferBinding->getBindings();
-		VertexBufferBinding::VertexBufferBindingMap::const_iterator bindi;
-		bufferLocks.resize(vertexBufferBinding->getLastBoundIndex()+1);
-		for (bindi = bindings.begin(); bindi != bindings.end(); ++bindi)
-		{
-			char* lock = static_cast<char*>(bindi->second->lock(HardwareBuffer::HBL_READ_ONLY));
-			bufferLocks[bindi->first] = lock;
-		}
+		Ogre::VertexData* vertexData;
+		/// Submesh owning the vertex data, 0 for the mesh's shared vertex data.
+		Ogre::SubMesh* subMesh;
+		/// Packed x, y, z per vertex.
+		std::vector<float> positions;
+		/// New index of each vertex after vertex memory optimisation, empty if not optimised.
+		std::vector<unsigned int> remapping;
+		Ogre::String error;
+	};
 
-		for(size_t i=0;i<numvertices;i++)
-		{
-			UniqueVertex uniqueVertex;
-			const auto& elemList =
-				vertexDeclaration->getElements();
-			VertexDeclaration::VertexElementList::const_iterator elemi;
-			unsigned short uvSets = 0;
-			for (elemi = elemList.begin(); elemi != elemList.end(); ++elemi)
-			{
-				// all float pointers for the moment
-				float *pFloat;
-				elemi->baseVertexPointerToElement(
-					bufferLocks[elemi->getSource()], &pFloat);
+	/// Triangle order optimisation of one LOD level of one submesh.
+	struct TootleJob
+	{
+		size_t source;
+		unsigned short subMeshIndex;
+		unsigned short lodIndex;
+		Ogre::IndexData* indexData;
+		std::vector<unsigned int> indices;
+		TootleStats stats;
+		Ogre::String error;
+	};
 
-				switch(elemi->getSemantic())
-				{
-				case VES_POSITION:
-					uniqueVertex.position.x = *pFloat++;
-					uniqueVertex.position.y = *pFloat++;
-					uniqueVertex.position.z = *pFloat++;
-					break;
-				case VES_NORMAL:
-					uniqueVertex.normal.x = *pFloat++;
-					uniqueVertex.normal.y = *pFloat++;
-					uniqueVertex.normal.z = *pFloat++;
-					break;
-				case VES_TANGENT:
-					uniqueVertex.tangent.x = *pFloat++;
-					uniqueVertex.tangent.y = *pFloat++;
-					uniqueVertex.tangent.z = *pFloat++;
-					// support w-component on tangent if present
-					if (VertexElement::getTypeCount(elemi->getType()) == 4)
-					{
-						uniqueVertex.tangent.w = *pFloat++;
-					}
-					break;
-				case VES_BINORMAL:
-					uniqueVertex.binormal.x = *pFloat++;
-					uniqueVertex.binormal.y = *pFloat++;
-					uniqueVertex.binormal.z = *pFloat++;
-					break;
-				case VES_TEXTURE_COORDINATES:
-					// supports up to 4 dimensions
-					for (unsigned short dim = 0;
-						dim < VertexElement::getTypeCount(elemi->getType()); ++dim)
+	void cleanupTootle()
 	{
-						uniqueVertex.uv[elemi->getIndex()][dim] = *pFloat++;
-					}
-					++uvSets;
-					break;
-				case VES_BLEND_INDICES:
-				case VES_BLEND_WEIGHTS:
-				case VES_DIFFUSE:
-				case VES_SPECULAR:
-					// No action needed for these semantics.
-					break;
-				};
-			}
+		TootleCleanup();
+	}
 
-			vertices.push_back(uniqueVertex);
+	/// Initialises Tootle on the first call. Tootle is cleaned up when the process exits.
+	TootleResult initialiseTootle()
+	{
+		static const TootleResult result = TootleInit();
+		static const bool cleanupRegistered =
+			result == TOOTLE_OK && std::atexit(cleanupTootle) == 0;
+		(void)cleanupRegistered;
+		return result;
+	}
 
-			// increment buffer lock pointers
-			for (bindi = bindings.begin(); bindi != bindings.end(); ++bindi)
+	/// Returns the index data of the given LOD level of a submesh, 0 if there is none.
+	IndexData* getLodIndexData(SubMesh* smesh, size_t lod)
+	{
+		if (lod == 0)
 		{
-				bufferLocks[bindi->first] += bindi->second->getVertexSize();
-			}
+			return smesh->indexData;
 		}
+		return lod <= smesh->mLodFaceList.size() ? smesh->mLodFaceList[lod - 1] : 0;
+	}
 
-		// unlock the buffers now
-		for (bindi = bindings.begin(); bindi != bindings.end(); ++bindi)
+	/// Extracts the vertex positions as tightly packed float triples, the only vertex
+	/// data Tootle reads.
+	void FillPositions(VertexData* vertexData, std::vector<float> & positions)
+	{
+		const VertexElement* posElem =
+			vertexData->vertexDeclaration->findElementBySemantic(VES_POSITION);
+		HardwareVertexBufferSharedPtr vbuf =
+			vertexData->vertexBufferBinding->getBuffer(posElem->getSource());
+		const size_t vertexSize = vbuf->getVertexSize();
+		unsigned char* pVertex = static_cast<unsigned char*>(
+			vbuf->lock(HardwareBuffer::HBL_READ_ONLY)) + vertexData->vertexStart * vertexSize;
+
+		positions.resize(vertexData->vertexCount * 3);
+		float* pDest = positions.empty() ? 0 : &positions[0];
+		for (size_t i = 0; i < vertexData->vertexCount; ++i, pVertex += vertexSize)
 		{
-			bindi->second->unlock();
+			float* pFloat;
+			posElem->baseVertexPointerToElement(pVertex, &pFloat);
+			*pDest++ = *pFloat++;
+			*pDest++ = *pFloat++;
+			*pDest++ = *pFloat++;
 		}
+		vbuf->unlock();
+	}
 
-		//fill the index buffer
-		//tootle only work with 32Bit buffers 
+	void FillIndexData(IndexData* indexData, std::vector<unsigned int> &indices)
+	{
+		//tootle only work with 32Bit buffers
 		//,so we'll had to recompress them later before saving
+		HardwareIndexBufferSharedPtr indexBuffer = indexData->indexBuffer;
+		const size_t indexSize = indexBuffer->getIndexSize();
+		const void* data = indexBuffer->lock(indexData->indexStart * indexSize,
+			indexData->indexCount * indexSize, HardwareBuffer::HBL_READ_ONLY);
 
-		// retrieve buffer pointers
-		uint16	*pVIndices16 = NULL;    // the face indices buffer, read only
-		uint32	*pVIndices32 = NULL;    // the face indices buffer, read only
-		bool use32bit = false;
-
+		indices.resize(indexData->indexCount);
 		if (indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT)
 		{
-			pVIndices32 = static_cast<uint32*>(
-				indexBuffer->lock(HardwareBuffer::HBL_READ_ONLY));
-			use32bit = true;
-			for(size_t i=0;i<indexBuffer->getNumIndexes();i++)
-			{
-				indices.push_back((unsigned int)(*pVIndices32));
-				pVIndices32++;
-			}
-
+			const uint32* pVIndices32 = static_cast<const uint32*>(data);
+			std::copy(pVIndices32, pVIndices32 + indexData->indexCount, indices.begin());
 		}
 		else
 		{
-			pVIndices16 = static_cast<uint16*>(
-				indexBuffer->lock(HardwareBuffer::HBL_READ_ONLY));
-			size_t nm_indices=indexBuffer->getNumIndexes();
-			for(size_t i=0;i<nm_indices;i++)
-			{
-				indices.push_back((unsigned int)(*pVIndices16));
-				pVIndices16++;
-			}
+			const uint16* pVIndices16 = static_cast<const uint16*>(data);
+			std::copy(pVIndices16, pVIndices16 + indexData->indexCount, indices.begin());
 		}
 		indexBuffer->unlock();
-		int a=0;
-
 	}
 
-	void CopyBackMeshData(HardwareIndexBufferSharedPtr indexBuffer,
-		VertexDeclaration *vertexDeclaration,
-		VertexBufferBinding* vertexBufferBinding,
-		std::vector<UniqueVertex> & vertices,
-		std::vector<unsigned int> & verticesRemap,
-		std::vector<unsigned int> &indices,
-		size_t numvertices)
+	/// Moves vertex verticesRemap[i] to position i, in all buffers bound to the vertex data.
+	/// Vertices are copied as raw bytes, so every element keeps its exact value.
+	void PermuteVertexData(VertexData* vertexData,
+		const std::vector<unsigned int> & verticesRemap)
 	{
-		// Lock all the buffers first
-		typedef std::vector<char*> BufferLocks;
-		BufferLocks bufferLocks;
+		std::vector<unsigned char> original;
 		const auto& bindings =
-			vertexBufferBinding->getBindings();
+			vertexData->vertexBufferBinding->getBindings();
 		VertexBufferBinding::VertexBufferBindingMap::const_iterator bindi;
-		bufferLocks.resize(vertexBufferBinding->getLastBoundIndex()+1);
 		for (bindi = bindings.begin(); bindi != bindings.end(); ++bindi)
 		{
-			char* lock = static_cast<char*>(bindi->second->lock(HardwareBuffer::HBL_NORMAL));
-			bufferLocks[bindi->first] = lock;
-		}
+			const size_t vertexSize = bindi->second->getVertexSize();
+			unsigned char* pData = static_cast<unsigned char*>(
+				bindi->second->lock(HardwareBuffer::HBL_NORMAL)) + vertexData->vertexStart * vertexSize;
 
-		for(size_t i=0;i<numvertices;i++)
-		{
-			unsigned int nVID = verticesRemap[i];
-			const auto& elemList =
-				vertexDeclaration->getElements();
-			VertexDeclaration::VertexElementList::const_iterator elemi;
-			unsigned short uvSets = 0;
-			for (elemi = elemList.begin(); elemi != elemList.end(); ++elemi)
+			original.assign(pData, pData + vertexData->vertexCount * vertexSize);
+			for (size_t i = 0; i < vertexData->vertexCount; ++i)
 			{
-				// all float pointers for the moment
-				float *pFloat;
-				elemi->baseVertexPointerToElement(
-					bufferLocks[elemi->getSource()], &pFloat);
-
-				switch(elemi->getSemantic())
-				{
-				case VES_POSITION:
-					*pFloat++ = vertices[nVID].position.x;
-					*pFloat++ = vertices[nVID].position.y;
-					*pFloat++ = vertices[nVID].position.z;
-					break;
-				case VES_NORMAL:
-					*pFloat++ = vertices[nVID].normal.x;
-					*pFloat++ = vertices[nVID].normal.y;
-					*pFloat++ = vertices[nVID].normal.z;
-					break;
-				case VES_TANGENT:
-					*pFloat++ = vertices[nVID].tangent.x;
-					*pFloat++ = vertices[nVID].tangent.y;
-					*pFloat++ = vertices[nVID].tangent.z;
-					// support w-component on tangent if present
-					if (VertexElement::getTypeCount(elemi->getType()) == 4)
-					{
-						*pFloat++ = vertices[nVID].tangent.w;
-					}
-					break;
-				case VES_BINORMAL:
-					*pFloat++ = vertices[nVID].binormal.x;
-					*pFloat++ = vertices[nVID].binormal.y;
-					*pFloat++ = vertices[nVID].binormal.z;
-					break;
-				case VES_TEXTURE_COORDINATES:
-					// supports up to 4 dimensions
-					for (unsigned short dim = 0;
-						dim < VertexElement::getTypeCount(elemi->getType()); ++dim)
-					{
-						*pFloat++ = vertices[nVID].uv[elemi->getIndex()][dim];
-					}
-					++uvSets;
-					break;
-				case VES_BLEND_INDICES:
-				case VES_BLEND_WEIGHTS:
-				case VES_DIFFUSE:
-				case VES_SPECULAR:
-					// No action needed for these semantics.
-					break;
-				};
+				memcpy(pData + i * vertexSize, &original[verticesRemap[i] * vertexSize], vertexSize);
 			}
+			bindi->second->unlock();
+		}
+	}
+
+	void CopyBackIndexData(IndexData* indexData, const std::vector<unsigned int> &indices)
+	{
+		//copy the index buffer back to where it came from
+		HardwareIndexBufferSharedPtr indexBuffer = indexData->indexBuffer;
+		const size_t indexSize = indexBuffer->getIndexSize();
+		void* data = indexBuffer->lock(indexData->indexStart * indexSize,
+			indexData->indexCount * indexSize, HardwareBuffer::HBL_NORMAL);
 
-			// increment buffer lock pointers
-			for (bindi = bindings.begin(); bindi != bindings.end(); ++bindi)
+		if (indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT)
+		{
+			uint32* pVIndices32 = static_cast<uint32*>(data);
+			for (size_t i = 0; i < indices.size(); ++i)
 			{
-				bufferLocks[bindi->first] += bindi->second->getVertexSize();
+				*pVIndices32++ = static_cast<uint32>(indices[i]);
 			}
 		}
-
-		// unlock the buffers now
-		for (bindi = bindings.begin(); bindi != bindings.end(); ++bindi)
+		else
 		{
-			bindi->second->unlock();
+			uint16* pVIndices16 = static_cast<uint16*>(data);
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				*pVIndices16++ = static_cast<uint16>(indices[i]);
+			}
 		}
+		indexBuffer->unlock();
+	}
 
-		//copy the index buffer back to where it came from
+	/// Replaces every index in the buffer by its entry in verticesRemap.
+	void RemapIndexBuffer(HardwareIndexBufferSharedPtr indexBuffer,
+		const std::vector<unsigned int> & verticesRemap)
+	{
+		void* data = indexBuffer->lock(HardwareBuffer::HBL_NORMAL);
 		if (indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT)
 		{
-			uint32	*pVIndices32 = NULL;    // the face indices buffer
-			std::vector<unsigned int>::iterator srci = indices.begin();
-
-			pVIndices32 = static_cast<uint32*>(
-				indexBuffer->lock(HardwareBuffer::HBL_NORMAL));
-			for(size_t i=0;i<indexBuffer->getNumIndexes();i++)
+			uint32* pVIndices32 = static_cast<uint32*>(data);
+			for (size_t i = 0; i < indexBuffer->getNumIndexes(); ++i, ++pVIndices32)
 			{
-				*pVIndices32++ = static_cast<uint32>(*srci++);
+				*pVIndices32 = static_cast<uint32>(verticesRemap[*pVIndices32]);
 			}
-
 		}
 		else
 		{
-			uint16	*pVIndices16 = NULL;    // the face indices buffer
-			std::vector<unsigned int>::iterator srci = indices.begin();
-
-			pVIndices16 = static_cast<uint16*>(
-				indexBuffer->lock(HardwareBuffer::HBL_NORMAL));
-			size_t nm_indices=indexBuffer->getNumIndexes();
-			for(size_t i=0;i<nm_indices;i++)
+			uint16* pVIndices16 = static_cast<uint16*>(data);
+			for (size_t i = 0; i < indexBuffer->getNumIndexes(); ++i, ++pVIndices16)
 			{
-				*pVIndices16++ = static_cast<uint16>(*srci++);
+				*pVIndices16 = static_cast<uint16>(verticesRemap[*pVIndices16]);
 			}
 		}
 		indexBuffer->unlock();
@@ -394,7 +320,7 @@ namespace meshmagick
 		StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
 
 		// Process the meshes
-		for (size_t i = 0, end = inFileNames.size(); i < end; ++i)
+		forEachFile(inFileNames.size(), [&](size_t i)
 		{
 			if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
 			{
@@ -405,7 +331,7 @@ namespace meshmagick
 				warn("unrecognised name ending for file " + inFileNames[i]);
 				warn("file skipped.");
 			}
-		}
+		});
 	}
 
 	void TootleTool::setOptions(const OptionList& options)
@@ -458,8 +384,14 @@ namespace meshmagick
 
 		processMesh(mesh);
 
-		meshSerializer->saveMesh(outFile, true);
-		print("Mesh saved as " + outFile + ".");
+		if (meshSerializer->saveMesh(outFile, true))
+		{
+			print("Mesh saved as " + outFile + ".");
+		}
+		else
+		{
+			print("Mesh " + outFile + " unchanged, not written.");
+		}
 
 	}
 
@@ -472,230 +404,317 @@ namespace meshmagick
 	{
 		print("Processing mesh...");
 
-		std::vector<UniqueVertex> vertices;
-		std::vector<unsigned int> indices;
+		TootleResult result = initialiseTootle();
+		if( result != TOOTLE_OK )
+			fail(getTootleError(result, "TootleInit"));
 
 		// Init options
 		bool gatherStats = OgreEnvironment::getSingleton().isStandalone() && mVerbosity >= V_HIGH;
 		unsigned int cacheSize = mVCacheSize ? mVCacheSize : TOOTLE_DEFAULT_VCACHE_SIZE;
 		TootleFaceWinding winding = mClockwise ? TOOTLE_CW : TOOTLE_CCW;
-		float* pViewpoints = mViewpointList.empty() ? 0 : mViewpointList.begin()->ptr();
+		const float* pViewpoints = mViewpointList.empty() ? 0 : mViewpointList.begin()->ptr();
 		unsigned int numViewpoints = static_cast<unsigned int>(mViewpointList.size());
+		bool qualityOptimization = mQualityOptimization;
 
+		// position only
+		const unsigned int nStride = 3 * sizeof(float);
 
-		int num_lods = mesh->getNumLodLevels();
-		int num_submeshes = mesh->getNumSubMeshes();
-		for(int i = 0; i < num_submeshes; i++)
-		{
-			vertices.clear();
-			indices.clear();
-
-			// build buffers containing only the vertex positions and indices, since this is what Tootle requires
-			SubMesh * smesh=mesh->getSubMesh(i);
+		// Manual LOD levels are meshes of their own, generated ones are index lists of the submeshes.
+		const size_t numLods = mesh->hasManualLodLevel() ? 1 : mesh->getNumLodLevels();
+		const unsigned short numSubMeshes = mesh->getNumSubMeshes();
 
-			// Skip empty submeshes
-			if (!VP_NORMAL(smesh->indexData)->indexCount)
-				continue;
-
-			if(smesh->operationType!=OT_TRIANGLE_LIST)
+		// Compressed LOD levels share one index buffer with overlapping ranges.
+		// Reordering one of them would break the others, so these are left alone.
+		std::map<HardwareIndexBuffer*, size_t> bufferUseCount;
+		for (unsigned short i = 0; i < numSubMeshes; ++i)
+		{
+			for (size_t lod = 0; lod < numLods; ++lod)
 			{
-				continue;
+				IndexData* indexData = getLodIndexData(mesh->getSubMesh(i), lod);
+				if (indexData && indexData->indexBuffer)
+				{
+					++bufferUseCount[indexData->indexBuffer.get()];
+				}
 			}
-			if(smesh->useSharedVertices)
+		}
+
+		// Gather the jobs, one per submesh and LOD level.
+		std::vector<TootleVertexSource> sources;
+		std::vector<TootleJob> jobs;
+		const size_t noSource = static_cast<size_t>(-1);
+		size_t sharedSource = noSource;
+		for (unsigned short i = 0; i < numSubMeshes; ++i)
+		{
+			SubMesh* smesh = mesh->getSubMesh(i);
+			VertexData* vertexData = smesh->useSharedVertices ?
+				mesh->sharedVertexData : smesh->vertexData;
+			if (smesh->operationType != OT_TRIANGLE_LIST || !vertexData
+				|| !vertexData->vertexDeclaration->findElementBySemantic(VES_POSITION))
 			{
-				FillMeshData(VP_NORMAL(smesh->indexData)->indexBuffer,
-                    VP_NORMAL(mesh->sharedVertexData)->vertexDeclaration,
-                    VP_NORMAL(mesh->sharedVertexData)->vertexBufferBinding,
-					vertices,indices,
-					VP_NORMAL(mesh->sharedVertexData)->vertexCount);
+				continue;
 			}
-			else
-			{
-                FillMeshData(VP_NORMAL(smesh->indexData)->indexBuffer,
-                    VP_NORMAL(smesh->vertexData)->vertexDeclaration,
-                    VP_NORMAL(smesh->vertexData)->vertexBufferBinding,
-                    vertices,indices,
-                    VP_NORMAL(smesh->vertexData)->vertexCount);
 
-			}
-			if(indices.size()>0)
+			size_t source = smesh->useSharedVertices ? sharedSource : noSource;
+			for (size_t lod = 0; lod < numLods; ++lod)
 			{
-				//start tootle work
-
-
-#if 0
-				// Dump to .obj for diagnostics for when Tootle asserts
-				if (mVerbosity >= V_HIGH)
+				// Skip empty index lists
+				IndexData* indexData = getLodIndexData(smesh, lod);
+				if (!indexData || !indexData->indexBuffer || !indexData->indexCount)
+				{
+					continue;
+				}
+				if (bufferUseCount[indexData->indexBuffer.get()] > 1)
 				{
-					std::ofstream ofstream;
-					String filename = String("TootleInput_") + mesh->getName() + "_" + StringConverter::toString(i) + ".obj";
-					ofstream.open(filename.c_str());
+					print("Submesh " + StringConverter::toString(i) + " LOD "
+						+ StringConverter::toString(lod)
+						+ " shares its index buffer, triangle order kept.", V_HIGH);
+					continue;
+				}
 
-					for (std::vector<Vector3>::iterator v = vertices.begin(); v != vertices.end(); ++v)
-					{
-						ofstream << "v " << v->x << " " << v->y << " " << v->z << std::endl;
-					}
-					for (std::vector<unsigned int>::iterator f = indices.begin(); f != indices.end();)
+				if (source == noSource)
+				{
+					TootleVertexSource vertexSource;
+					vertexSource.vertexData = vertexData;
+					vertexSource.subMesh = smesh->useSharedVertices ? 0 : smesh;
+					source = sources.size();
+					sources.push_back(vertexSource);
+					if (smesh->useSharedVertices)
 					{
-						ofstream << "f " << (*f++ + 1) << " " << (*f++ + 1) << " " << (*f++ + 1) << std::endl;
+						sharedSource = source;
 					}
-					ofstream.close();
-
 				}
-#endif
 
+				TootleJob job;
+				job.source = source;
+				job.subMeshIndex = i;
+				job.lodIndex = static_cast<unsigned short>(lod);
+				job.indexData = indexData;
+				memset(&job.stats, 0, sizeof(job.stats));
+				jobs.push_back(job);
+			}
+		}
 
-				// *****************************************************************
-				//   Optimize the mesh
-				// *****************************************************************
+		// Buffers are locked on this thread only.
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			FillPositions(sources[i].vertexData, sources[i].positions);
+		}
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			FillIndexData(jobs[i].indexData, jobs[i].indices);
+		}
 
-				unsigned int nTriangles = (unsigned int) indices.size() / 3;
-				unsigned int nVertices = (unsigned int) vertices.size();
-				const float* pVB = (float*) &vertices[0];
-				unsigned int* pIB = (unsigned int*) &indices[0];
-
-				// position: 3 * sizeof(float)
-				// normal:   3 * sizeof(float)
-				// tangent:  4 * sizeof(float)
-				// binormal: 3 * sizeof(float)
-				// uv:       3 * OGRE_MAX_TEXTURE_COORD_SETS * sizeof(float)
-				unsigned int nStride = (3 + 3 + 4 + 3 + 3 * OGRE_MAX_TEXTURE_COORD_SETS) * sizeof(float);
-
-				TootleStats stats;
-				TootleResult result;
-
-				// initialize Tootle
-				result = TootleInit();
-				if( result != TOOTLE_OK )
-					fail(getTootleError(result, "TootleInit"));
+		ThreadPool pool(mNumThreads);
+		// Tootle's Direct3D overdraw measurement can't be used from several threads at once.
+		const TootleOverdrawOptimizer overdrawOptimizer =
+			pool.getNumThreads() > 1 ? TOOTLE_OVERDRAW_RAYTRACE : TOOTLE_OVERDRAW_AUTO;
+
+		// *****************************************************************
+		//   Optimize the triangle order
+		// *****************************************************************
+		pool.run(jobs.size(), [&](size_t j)
+		{
+			TootleJob& job = jobs[j];
+			const TootleVertexSource& source = sources[job.source];
 
+			unsigned int nTriangles = (unsigned int) job.indices.size() / 3;
+			unsigned int nVertices = (unsigned int) source.positions.size() / 3;
+			const float* pVB = &source.positions[0];
+			unsigned int* pIB = (unsigned int*) &job.indices[0];
+			TootleStats& stats = job.stats;
+			TootleResult result;
+
+			if (gatherStats)
+			{
+				// measure input VCache efficiency
+				result = TootleMeasureCacheEfficiency( pIB, nTriangles, cacheSize, &stats.fVCacheIn );
+				if( result != TOOTLE_OK )
+				{
+					job.error = getTootleError(result, "TootleMeasureCacheEfficiency");
+					return;
+				}
 
-				if (gatherStats)
+				// measure input overdraw
+				result = TootleMeasureOverdraw( pVB, pIB, nVertices, nTriangles, nStride,
+					pViewpoints, numViewpoints, winding,
+					&stats.fOverdrawIn, &stats.fMaxOverdrawIn, overdrawOptimizer );
+				if( result != TOOTLE_OK )
 				{
-					// measure input VCache efficiency
-					result = TootleMeasureCacheEfficiency( pIB, nTriangles, cacheSize, &stats.fVCacheIn );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleMeasureCacheEfficiency"));
-
-
-					// measure input overdraw.  Note that we assume counter-clockwise vertex winding. 
-					result = TootleMeasureOverdraw( pVB, pIB, nVertices, nTriangles, nStride, 
-						pViewpoints, numViewpoints, winding, 
-						&stats.fOverdrawIn, &stats.fMaxOverdrawIn );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleMeasureOverdraw"));
+					job.error = getTootleError(result, "TootleMeasureOverdraw");
+					return;
 				}
+			}
 
-				if (mQualityOptimization)
+			if (qualityOptimization)
+			{
+				result = TootleOptimize( pVB, pIB, nVertices, nTriangles, nStride, cacheSize,
+					pViewpoints, numViewpoints, winding,
+					pIB, &stats.nClusters, TOOTLE_VCACHE_AUTO, overdrawOptimizer );
+				if( result != TOOTLE_OK )
 				{
-					result = TootleOptimize( pVB, pIB, nVertices, nTriangles, nStride, cacheSize,
-						pViewpoints, numViewpoints, winding,
-						pIB, &stats.nClusters );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleOptimize"));
+					job.error = getTootleError(result, "TootleOptimize");
+					return;
 				}
-				else
+			}
+			else
+			{
+				result = TootleFastOptimize( pVB, pIB, nVertices, nTriangles, nStride, cacheSize, winding,
+					pIB, &stats.nClusters );
+				if( result != TOOTLE_OK )
 				{
-					result = TootleFastOptimize( pVB, pIB, nVertices, nTriangles, nStride, cacheSize, winding,
-						pIB, &stats.nClusters );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleFastOptimize"));
+					job.error = getTootleError(result, "TootleFastOptimize");
+					return;
 				}
+			}
 
+			if (gatherStats)
+			{
+				// measure output VCache efficiency
+				result = TootleMeasureCacheEfficiency( pIB, nTriangles, cacheSize, &stats.fVCacheOut );
+				if( result != TOOTLE_OK )
+				{
+					job.error = getTootleError(result, "TootleMeasureCacheEfficiency");
+					return;
+				}
 
-				if (gatherStats)
+				// measure output overdraw
+				result = TootleMeasureOverdraw( pVB, pIB, nVertices, nTriangles, nStride,
+					pViewpoints, numViewpoints, winding,
+					&stats.fOverdrawOut, &stats.fMaxOverdrawOut, overdrawOptimizer );
+				if( result != TOOTLE_OK )
 				{
-					// measure output VCache efficiency
-					result = TootleMeasureCacheEfficiency( pIB, nTriangles, cacheSize, &stats.fVCacheOut );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleMeasureCacheEfficiency"));
-
-					// measure output overdraw
-					result = TootleMeasureOverdraw( pVB, pIB, nVertices, nTriangles, nStride,  
-						pViewpoints, numViewpoints, winding, 
-						&stats.fOverdrawOut, &stats.fMaxOverdrawOut );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleMeasureOverdraw"));
-
-					// print tootle statistics (only in verbose mode)
-					Ogre::StringStream statsStr;
-					statsStr 
-						<< "Tootle Stats for submesh " << i << ": " << std::endl
-						<< "  Clusters: " << stats.nClusters << std::endl
-						<< "  Cache In/Out: " << stats.fVCacheIn << " / " << stats.fVCacheOut << " = " << (stats.fVCacheIn/stats.fVCacheOut) << std::endl
-						<< "  Overdraw In/Out: " << stats.fOverdrawIn << " / " << stats.fOverdrawOut << " = " << (stats.fOverdrawIn/stats.fOverdrawOut) << std::endl
-						<< "  Max Overdraw In/Out: " << stats.fMaxOverdrawIn << " / " << stats.fMaxOverdrawOut << " = " << (stats.fMaxOverdrawIn/stats.fMaxOverdrawOut);
-					print(statsStr.str(), V_HIGH);
+					job.error = getTootleError(result, "TootleMeasureOverdraw");
+					return;
 				}
+			}
+		});
 
-				std::vector<unsigned int> pnVertexRemapping(nVertices);
-				std::vector<unsigned int> pnVertexInverseRemapping(nVertices);
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			if (!jobs[i].error.empty())
+				fail(jobs[i].error);
+		}
 
-				if (mVMemoryOptimization)
-				{
-					result = TootleOptimizeVertexMemory( pVB, pIB, nVertices, nTriangles, nStride,
-						NULL, pIB, &pnVertexRemapping[0] );
-					if( result != TOOTLE_OK )
-						fail(getTootleError(result, "TootleOptimize"));
+		// *****************************************************************
+		//   Optimize the vertex order
+		// *****************************************************************
+		if (mVMemoryOptimization)
+		{
+			pool.run(sources.size(), [&](size_t s)
+			{
+				TootleVertexSource& source = sources[s];
 
-					for (unsigned int i = 0; i < nVertices; i++)
+				// All submeshes using the vertex data have to agree on one vertex order.
+				// It is derived from the full detail triangles of all of them.
+				std::vector<unsigned int> indices;
+				for (size_t j = 0; j < jobs.size(); ++j)
+				{
+					if (jobs[j].source == s && jobs[j].lodIndex == 0)
 					{
-						unsigned int nVID = pnVertexRemapping[i];
-						pnVertexInverseRemapping[nVID] = i;
+						indices.insert(indices.end(), jobs[j].indices.begin(), jobs[j].indices.end());
 					}
 				}
-				else
+				if (indices.empty())
 				{
-					for (unsigned int i = 0; i < nVertices; i++)
-					{
-						pnVertexRemapping[i] = i;
-						pnVertexInverseRemapping[i] = i;
-					}
+					return;
 				}
 
-				// clean up tootle
-				TootleCleanup();
+				unsigned int nTriangles = (unsigned int) indices.size() / 3;
+				unsigned int nVertices = (unsigned int) source.positions.size() / 3;
+				const float* pVB = &source.positions[0];
+				std::vector<unsigned int> indicesOut(indices.size());
+				source.remapping.resize(nVertices);
 
-				if(smesh->useSharedVertices)
+				TootleResult result = TootleOptimizeVertexMemory( pVB, &indices[0], nVertices, nTriangles,
+					nStride, NULL, &indicesOut[0], &source.remapping[0] );
+				if( result != TOOTLE_OK )
 				{
-					CopyBackMeshData(VP_NORMAL(smesh->indexData)->indexBuffer,
-                        VP_NORMAL(mesh->sharedVertexData)->vertexDeclaration,
-                        VP_NORMAL(mesh->sharedVertexData)->vertexBufferBinding,
-						vertices, pnVertexInverseRemapping, indices,
-						VP_NORMAL(mesh->sharedVertexData)->vertexCount);
+					source.error = getTootleError(result, "TootleOptimizeVertexMemory");
+					source.remapping.clear();
+				}
+			});
 
-					if (i == 0)
-				{
-						if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
-					{
-							const auto& bas = mesh->getBoneAssignments ();
-							auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end(), pnVertexRemapping);
-							mesh->clearBoneAssignments();
-							for (const auto& boneAssignment : newList)
-								mesh->addBoneAssignment (boneAssignment.second);
-						}
-					}
+			for (size_t i = 0; i < sources.size(); ++i)
+			{
+				if (!sources[i].error.empty())
+					fail(sources[i].error);
+			}
+		}
+
+		// Write results back in submesh order.
+		for (size_t j = 0; j < jobs.size(); ++j)
+		{
+			const TootleJob& job = jobs[j];
+			if (gatherStats)
+			{
+				// print tootle statistics (only in verbose mode)
+				const TootleStats& stats = job.stats;
+				Ogre::StringStream statsStr;
+				statsStr
+					<< "Tootle Stats for submesh " << job.subMeshIndex << " LOD " << job.lodIndex << ": " << std::endl
+					<< "  Clusters: " << stats.nClusters << std::endl
+					<< "  Cache In/Out: " << stats.fVCacheIn << " / " << stats.fVCacheOut << " = " << (stats.fVCacheIn/stats.fVCacheOut) << std::endl
+					<< "  Overdraw In/Out: " << stats.fOverdrawIn << " / " << stats.fOverdrawOut << " = " << (stats.fOverdrawIn/stats.fOverdrawOut) << std::endl
+					<< "  Max Overdraw In/Out: " << stats.fMaxOverdrawIn << " / " << stats.fMaxOverdrawOut << " = " << (stats.fMaxOverdrawIn/stats.fMaxOverdrawOut);
+				print(statsStr.str(), V_HIGH);
+			}
+
+			CopyBackIndexData(job.indexData, job.indices);
+		}
+
+		for (size_t s = 0; s < sources.size(); ++s)
+		{
+			TootleVertexSource& source = sources[s];
+			if (source.remapping.empty())
+			{
+				continue;
+			}
 
+			std::vector<unsigned int> inverseRemapping(source.remapping.size());
+			for (unsigned int i = 0; i < source.remapping.size(); i++)
+			{
+				inverseRemapping[source.remapping[i]] = i;
+			}
+			PermuteVertexData(source.vertexData, inverseRemapping);
+
+			// Every index list referencing the vertex data has to follow, whatever its
+			// operation type or LOD level. Buffers shared by several lists are remapped once.
+			std::set<HardwareIndexBuffer*> remappedBuffers;
+			for (unsigned short i = 0; i < numSubMeshes; ++i)
+			{
+				SubMesh* smesh = mesh->getSubMesh(i);
+				if (source.subMesh ? smesh != source.subMesh : !smesh->useSharedVertices)
+				{
+					continue;
 				}
-				else
+				for (size_t lod = 0; lod <= smesh->mLodFaceList.size(); ++lod)
 				{
-					CopyBackMeshData(VP_NORMAL(smesh->indexData)->indexBuffer,
-                        VP_NORMAL(smesh->vertexData)->vertexDeclaration,
-                        VP_NORMAL(smesh->vertexData)->vertexBufferBinding,
-						vertices, pnVertexInverseRemapping, indices,
-						VP_NORMAL(smesh->vertexData)->vertexCount);
-
+					IndexData* indexData = getLodIndexData(smesh, lod);
+					if (indexData && indexData->indexBuffer
+						&& remappedBuffers.insert(indexData->indexBuffer.get()).second)
+					{
+						RemapIndexBuffer(indexData->indexBuffer, source.remapping);
 					}
+				}
+			}
 
-				const auto& bas = smesh->getBoneAssignments ();
-				auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end(), pnVertexRemapping);
-				smesh->clearBoneAssignments();
+			if (source.subMesh)
+			{
+				const auto& bas = source.subMesh->getBoneAssignments ();
+				auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end(), source.remapping);
+				source.subMesh->clearBoneAssignments();
 				for (const auto& boneAssignment : newList)
-					smesh->addBoneAssignment (boneAssignment.second);
-				}
+					source.subMesh->addBoneAssignment (boneAssignment.second);
+			}
+			else if (mesh->getSkeletonName() != Ogre::BLANKSTRING)
+			{
+				const auto& bas = mesh->getBoneAssignments ();
+				auto newList = getAdjustedBoneAssignments(bas.begin(), bas.end(), source.remapping);
+				mesh->clearBoneAssignments();
+				for (const auto& boneAssignment : newList)
+					mesh->addBoneAssignment (boneAssignment.second);
+			}
 		}
-
-
 	}
 
 }
@@ -66,7 +66,7 @@ namespace meshmagick
         StringVector outFileNames = outFileNamesArg.empty() ? inFileNames : outFileNamesArg;
 
         // Process the meshes
-        for (size_t i = 0, end = inFileNames.size(); i < end; ++i)
+        forEachFile(inFileNames.size(), [&](size_t i)
         {
             if (StringUtil::endsWith(inFileNames[i], ".mesh", true))
             {
@@ -81,7 +81,7 @@ namespace meshmagick
                 warn("unrecognised name ending for file " + inFileNames[i]);
                 warn("file skipped.");
             }
-        }
+        });
     }
 
     void TransformTool::processSkeletonFile(String inFile, String outFile, bool calcTransform)
@@ -89,6 +89,12 @@ namespace meshmagick
         StatefulSkeletonSerializer* skeletonSerializer =
             OgreEnvironment::getSingleton().getSkeletonSerializer();
 
+        // Skeletons shared by several meshes of the batch are only transformed once.
+        if (isSkeletonProcessed(inFile, outFile))
+        {
+            return;
+        }
+
         print("Loading skeleton " + inFile + "...");
         SkeletonPtr skeleton;
         try
@@ -108,8 +114,15 @@ namespace meshmagick
             calculateTransform();
         }
         processSkeleton(skeleton);
-        skeletonSerializer->saveSkeleton(outFile, true);
-        print("Skeleton saved as " + outFile + ".");
+        if (skeletonSerializer->saveSkeleton(outFile, true))
+        {
+            print("Skeleton saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Skeleton " + outFile + " unchanged, not written.");
+        }
+        setSkeletonProcessed(inFile, outFile);
     }
 
     void TransformTool::processMeshFile(Ogre::String inFile, Ogre::String outFile)
@@ -133,8 +146,14 @@ namespace meshmagick
         print("Processing mesh...");
         calculateTransform(mesh);
         processMesh(mesh);
-        meshSerializer->saveMesh(outFile, true);
-        print("Mesh saved as " + outFile + ".");
+        if (meshSerializer->saveMesh(outFile, true))
+        {
+            print("Mesh saved as " + outFile + ".");
+        }
+        else
+        {
+            print("Mesh " + outFile + " unchanged, not written.");
+        }
 
         if (mFollowSkeletonLink && mesh->hasSkeleton ())
         {
@@ -423,9 +442,19 @@ namespace meshmagick
     void TransformTool::processDirectionElement(VertexData* vertexData,
         const VertexElement* vertexElem)
     {
-        // We only want to apply rotation to normal, binormal and tangent, so extract it.
-        Quaternion rotation (mTransform.linear());
-        rotation.normalise();
+        // Binormals and tangents lie in the surface and are transformed like positions,
+        // without translation. Normals have to stay perpendicular to the surface, which
+        // takes the inverse transpose under scaling.
+        const Matrix3 linear = mTransform.linear();
+        Matrix3 directionTransform = linear;
+        if (vertexElem->getSemantic() == VES_NORMAL)
+        {
+            linear.Inverse(directionTransform);
+            directionTransform = directionTransform.Transpose();
+        }
+        // Mirroring reverses the handedness of the tangent space.
+        const bool flipHandedness = vertexElem->getSemantic() == VES_TANGENT
+            && vertexElem->getType() == VET_FLOAT4 && linear.Determinant() < 0;
 
         Ogre::HardwareVertexBufferSharedPtr buffer =
             vertexData->vertexBufferBinding->getBuffer(vertexElem->getSource());
@@ -438,7 +467,7 @@ namespace meshmagick
             vertexElem->baseVertexPointerToElement(data, &ptr);
 
             Vector3 vertex(ptr);
-            vertex = rotation * vertex;
+            vertex = directionTransform * vertex;
             if (mNormaliseNormals)
             {
                 vertex.normalise();
@@ -446,6 +475,10 @@ namespace meshmagick
             ptr[0] = vertex.x;
             ptr[1] = vertex.y;
             ptr[2] = vertex.z;
+            if (flipHandedness)
+            {
+                ptr[3] = -ptr[3];
+            }
 
             data += buffer->getVertexSize();
         }
@@ -0,0 +1,319 @@
+/*
+This file is part of MeshMagick - An Ogre mesh file manipulation tool.
+Copyright (C) 2007-2010 Daniel Wickert
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "MmVertexWelder.h"
+
+#include <OgreHardwareBufferManager.h>
+#include <OgreKeyFrame.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+using namespace Ogre;
+
+namespace
+{
+    typedef std::vector<std::pair<unsigned short, Real> > BoneWeightList;
+
+    uint64 getCellKey(long long x, long long y, long long z)
+    {
+        // Colliding cells only add candidates, they are compared in full anyway.
+        return static_cast<uint64>(x) * 73856093ULL
+            ^ static_cast<uint64>(y) * 19349663ULL
+            ^ static_cast<uint64>(z) * 83492791ULL;
+    }
+}
+
+namespace meshmagick
+{
+    VertexWelder::VertexWelder(Real posTolerance, Real normTolerance, Real uvTolerance)
+    {
+        mLess.pos_tolerance = posTolerance;
+        mLess.norm_tolerance = normTolerance;
+        mLess.uv_tolerance = uvTolerance;
+        mLess.uvSets = 0;
+    }
+
+    size_t VertexWelder::weld(VertexData* vd, const std::vector<IndexData*>& indexDatas,
+        Mesh::VertexBoneAssignmentList& boneAssignments,
+        const std::vector<VertexAnimationTrack*>& morphTracks) const
+    {
+        const size_t numVertices = vd->vertexCount;
+        if (numVertices < 2 || vd->vertexDeclaration->findElementBySemantic(VES_POSITION) == NULL)
+        {
+            return 0;
+        }
+
+        // Read all vertices. Elements UniqueVertex ignores are compared byte-wise.
+        std::vector<UniqueVertex> vertices(numVertices);
+        std::vector<String> otherElements(numVertices);
+        UniqueVertexLess less = mLess;
+        {
+            const VertexBufferBinding::VertexBufferBindingMap& bindings =
+                vd->vertexBufferBinding->getBindings();
+            std::vector<char*> bufferLocks(vd->vertexBufferBinding->getLastBoundIndex() + 1);
+            for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+                it != bindings.end(); ++it)
+            {
+                bufferLocks[it->first] = static_cast<char*>(
+                    it->second->lock(HardwareBuffer::HBL_READ_ONLY))
+                    + vd->vertexStart * it->second->getVertexSize();
+            }
+
+            const VertexDeclaration::VertexElementList& elements =
+                vd->vertexDeclaration->getElements();
+            for (size_t v = 0; v < numVertices; ++v)
+            {
+                less.uvSets = vertices[v].read(vd->vertexDeclaration, bufferLocks);
+                for (VertexDeclaration::VertexElementList::const_iterator it = elements.begin();
+                    it != elements.end(); ++it)
+                {
+                    const VertexElementSemantic semantic = it->getSemantic();
+                    if (semantic == VES_DIFFUSE || semantic == VES_SPECULAR
+                        || semantic == VES_BLEND_INDICES || semantic == VES_BLEND_WEIGHTS)
+                    {
+                        otherElements[v].append(bufferLocks[it->getSource()] + it->getOffset(),
+                            it->getSize());
+                    }
+                }
+
+                for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+                    it != bindings.end(); ++it)
+                {
+                    bufferLocks[it->first] += it->second->getVertexSize();
+                }
+            }
+
+            for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+                it != bindings.end(); ++it)
+            {
+                it->second->unlock();
+            }
+        }
+
+        std::vector<BoneWeightList> boneWeights(numVertices);
+        for (Mesh::VertexBoneAssignmentList::const_iterator it = boneAssignments.begin();
+            it != boneAssignments.end(); ++it)
+        {
+            if (it->second.vertexIndex < numVertices)
+            {
+                boneWeights[it->second.vertexIndex].push_back(
+                    std::make_pair(it->second.boneIndex, it->second.weight));
+            }
+        }
+        for (size_t v = 0; v < numVertices; ++v)
+        {
+            std::sort(boneWeights[v].begin(), boneWeights[v].end());
+        }
+
+        // Morph key frames store a position (and maybe a normal) per vertex.
+        std::vector<VertexMorphKeyFrame*> keyFrames;
+        for (size_t i = 0; i < morphTracks.size(); ++i)
+        {
+            for (unsigned short k = 0; k < morphTracks[i]->getNumKeyFrames(); ++k)
+            {
+                keyFrames.push_back(morphTracks[i]->getVertexMorphKeyFrame(k));
+            }
+        }
+        size_t numMorphFloats = 0;
+        for (size_t k = 0; k < keyFrames.size(); ++k)
+        {
+            numMorphFloats += keyFrames[k]->getVertexBuffer()->getVertexSize() / sizeof(float);
+        }
+        std::vector<float> morphData(numVertices * numMorphFloats);
+        for (size_t k = 0, offset = 0; k < keyFrames.size(); ++k)
+        {
+            HardwareVertexBufferSharedPtr buffer = keyFrames[k]->getVertexBuffer();
+            const size_t numFloats = buffer->getVertexSize() / sizeof(float);
+            const float* src = static_cast<const float*>(buffer->lock(HardwareBuffer::HBL_READ_ONLY));
+            for (size_t v = 0; v < numVertices && v < buffer->getNumVertices(); ++v)
+            {
+                std::copy(src + v * numFloats, src + (v + 1) * numFloats,
+                    morphData.begin() + v * numMorphFloats + offset);
+            }
+            buffer->unlock();
+            offset += numFloats;
+        }
+
+        // Find the vertex each vertex collapses onto.
+        const Real cellSize = std::max(mLess.pos_tolerance, Real(1e-6));
+        std::unordered_map<uint64, std::vector<uint32> > cells;
+        std::vector<uint32> uniqueVertices;
+        std::vector<uint32> remap(numVertices);
+        for (size_t v = 0; v < numVertices; ++v)
+        {
+            const Vector3& p = vertices[v].position;
+            const long long x = static_cast<long long>(std::floor(p.x / cellSize));
+            const long long y = static_cast<long long>(std::floor(p.y / cellSize));
+            const long long z = static_cast<long long>(std::floor(p.z / cellSize));
+
+            uint32 found = std::numeric_limits<uint32>::max();
+            for (int i = 0; i < 27 && found == std::numeric_limits<uint32>::max(); ++i)
+            {
+                std::unordered_map<uint64, std::vector<uint32> >::const_iterator cell =
+                    cells.find(getCellKey(x + i % 3 - 1, y + i / 3 % 3 - 1, z + i / 9 - 1));
+                if (cell == cells.end())
+                {
+                    continue;
+                }
+                for (size_t c = 0; c < cell->second.size(); ++c)
+                {
+                    const uint32 u = uniqueVertices[cell->second[c]];
+                    if (less(vertices[v], vertices[u]) || less(vertices[u], vertices[v])
+                        || otherElements[v] != otherElements[u]
+                        || boneWeights[v].size() != boneWeights[u].size())
+                    {
+                        continue;
+                    }
+                    bool equal = true;
+                    for (size_t b = 0; b < boneWeights[v].size() && equal; ++b)
+                    {
+                        equal = boneWeights[v][b].first == boneWeights[u][b].first
+                            && Math::RealEqual(boneWeights[v][b].second,
+                                boneWeights[u][b].second, mLess.norm_tolerance);
+                    }
+                    for (size_t f = 0; f < numMorphFloats && equal; ++f)
+                    {
+                        equal = Math::RealEqual(morphData[v * numMorphFloats + f],
+                            morphData[u * numMorphFloats + f], mLess.pos_tolerance);
+                    }
+                    if (equal)
+                    {
+                        found = cell->second[c];
+                        break;
+                    }
+                }
+            }
+
+            if (found == std::numeric_limits<uint32>::max())
+            {
+                found = static_cast<uint32>(uniqueVertices.size());
+                uniqueVertices.push_back(static_cast<uint32>(v));
+                cells[getCellKey(x, y, z)].push_back(found);
+            }
+            remap[v] = found;
+        }
+
+        const size_t numUnique = uniqueVertices.size();
+        if (numUnique == numVertices)
+        {
+            return 0;
+        }
+
+        // Copy the remaining vertices into new buffers.
+        VertexBufferBinding* newBind =
+            HardwareBufferManager::getSingleton().createVertexBufferBinding();
+        const VertexBufferBinding::VertexBufferBindingMap& bindings =
+            vd->vertexBufferBinding->getBindings();
+        for (VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin();
+            it != bindings.end(); ++it)
+        {
+            const size_t vertexSize = it->second->getVertexSize();
+            HardwareVertexBufferSharedPtr newBuf =
+                HardwareBufferManager::getSingleton().createVertexBuffer(vertexSize, numUnique,
+                    it->second->getUsage(), it->second->hasShadowBuffer());
+            const unsigned char* src = static_cast<const unsigned char*>(
+                it->second->lock(HardwareBuffer::HBL_READ_ONLY))
+                + vd->vertexStart * vertexSize;
+            unsigned char* dest = static_cast<unsigned char*>(
+                newBuf->lock(HardwareBuffer::HBL_DISCARD));
+            for (size_t u = 0; u < numUnique; ++u)
+            {
+                memcpy(dest + u * vertexSize, src + uniqueVertices[u] * vertexSize, vertexSize);
+            }
+            newBuf->unlock();
+            it->second->unlock();
+            newBind->setBinding(it->first, newBuf);
+        }
+        VertexBufferBinding* oldBind = vd->vertexBufferBinding;
+        vd->vertexBufferBinding = newBind;
+        HardwareBufferManager::getSingleton().destroyVertexBufferBinding(oldBind);
+        vd->vertexStart = 0;
+        vd->vertexCount = numUnique;
+
+        for (size_t i = 0; i < indexDatas.size(); ++i)
+        {
+            IndexData* id = indexDatas[i];
+            if (id == NULL || !id->indexBuffer || id->indexCount == 0)
+            {
+                continue;
+            }
+            // Fewer vertices than before, so the index type still fits.
+            const bool is32Bit = id->indexBuffer->getType() == HardwareIndexBuffer::IT_32BIT;
+            void* data = id->indexBuffer->lock(HardwareBuffer::HBL_NORMAL);
+            uint32* p32 = static_cast<uint32*>(data) + id->indexStart;
+            uint16* p16 = static_cast<uint16*>(data) + id->indexStart;
+            for (size_t j = 0; j < id->indexCount; ++j)
+            {
+                if (is32Bit)
+                {
+                    p32[j] = remap[p32[j]];
+                }
+                else
+                {
+                    p16[j] = static_cast<uint16>(remap[p16[j]]);
+                }
+            }
+            id->indexBuffer->unlock();
+        }
+
+        // Keep the assignments of the vertices that remain.
+        Mesh::VertexBoneAssignmentList newAssignments;
+        for (Mesh::VertexBoneAssignmentList::const_iterator it = boneAssignments.begin();
+            it != boneAssignments.end(); ++it)
+        {
+            VertexBoneAssignment vba = it->second;
+            if (vba.vertexIndex < numVertices && uniqueVertices[remap[vba.vertexIndex]] == vba.vertexIndex)
+            {
+                vba.vertexIndex = remap[vba.vertexIndex];
+                newAssignments.insert(Mesh::VertexBoneAssignmentList::value_type(vba.vertexIndex, vba));
+            }
+        }
+        boneAssignments.swap(newAssignments);
+
+        for (size_t k = 0; k < keyFrames.size(); ++k)
+        {
+            HardwareVertexBufferSharedPtr buffer = keyFrames[k]->getVertexBuffer();
+            const size_t vertexSize = buffer->getVertexSize();
+            HardwareVertexBufferSharedPtr newBuf =
+                HardwareBufferManager::getSingleton().createVertexBuffer(vertexSize, numUnique,
+                    buffer->getUsage(), buffer->hasShadowBuffer());
+            const unsigned char* src = static_cast<const unsigned char*>(
+                buffer->lock(HardwareBuffer::HBL_READ_ONLY));
+            unsigned char* dest = static_cast<unsigned char*>(
+                newBuf->lock(HardwareBuffer::HBL_DISCARD));
+            for (size_t u = 0; u < numUnique; ++u)
+            {
+                memcpy(dest + u * vertexSize, src + uniqueVertices[u] * vertexSize, vertexSize);
+            }
+            newBuf->unlock();
+            buffer->unlock();
+            keyFrames[k]->setVertexBuffer(newBuf);
+        }
+
+        return numVertices - numUnique;
+    }
+}
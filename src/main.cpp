@@ -23,12 +23,17 @@ THE SOFTWARE.
 
 #include "MeshMagickPrerequisites.h"
 
+#include "MmBakePoseToolFactory.h"
+#include "MmDedupeToolFactory.h"
 #include "MmMeshMergeToolFactory.h"
 #include "MmInfoToolFactory.h"
 #include "MmOgreEnvironment.h"
 #include "MmOptimiseToolFactory.h"
 #include "MmOptionsParser.h"
 #include "MmRenameToolFactory.h"
+#include "MmReorganiseToolFactory.h"
+#include "MmResampleToolFactory.h"
+#include "MmStripBonesToolFactory.h"
 #include "MmTool.h"
 #include "MmToolManager.h"
 #include "MmTransformToolFactory.h"
@@ -51,8 +56,12 @@ void printHelp(void)
     std::cout << "    -help               = Prints this help text" << std::endl;
     std::cout << "    -help=toolname      = Prints help for the specified tool" << std::endl;
     std::cout << "    -list               = Lists available tools" << std::endl;
+    std::cout << "    -memory-budget[=MB] = Report peak resident memory when done and warn," << std::endl;
+    std::cout << "                          if it exceeds given number of MB." << std::endl;
     std::cout << "    -no-follow-skeleton = Do not follow Skeleton-Link (if applicable)" << std::endl;
     std::cout << "    -quiet              = Supress all messages to cout." << std::endl;
+    std::cout << "    -threads=N          = Number of worker threads used by tools that support it." << std::endl;
+    std::cout << "                          Default is one per hardware thread." << std::endl;
     std::cout << "    -verbose            = Print more detailed messages." << std::endl;
     std::cout << "    -version            = Print meshmagick version." << std::endl;
     std::cout << std::endl;
@@ -174,6 +183,11 @@ int main(int argc, const char** argv)
     manager.registerToolFactory(new MeshMergeToolFactory());
     manager.registerToolFactory(new RenameToolFactory());
 	manager.registerToolFactory(new OptimiseToolFactory());
+    manager.registerToolFactory(new DedupeToolFactory());
+    manager.registerToolFactory(new StripBonesToolFactory());
+    manager.registerToolFactory(new ResampleToolFactory());
+    manager.registerToolFactory(new BakePoseToolFactory());
+    manager.registerToolFactory(new ReorganiseToolFactory());
 #ifdef MESHMAGICK_USE_TOOTLE
 	manager.registerToolFactory(new TootleToolFactory());
 #endif
@@ -187,10 +201,12 @@ int main(int argc, const char** argv)
     OptionDefinitionSet globalOptionDefs = OptionDefinitionSet();
     globalOptionDefs.insert(OptionDefinition("help", OT_STRING, false, false, Any(String())));
     globalOptionDefs.insert(OptionDefinition("list"));
+    globalOptionDefs.insert(OptionDefinition("memory-budget", OT_INT, false, false, Any(0)));
     globalOptionDefs.insert(OptionDefinition("no-follow-skeleton"));
     globalOptionDefs.insert(OptionDefinition("version"));
     globalOptionDefs.insert(OptionDefinition("quiet"));
     globalOptionDefs.insert(OptionDefinition("verbose"));
+    globalOptionDefs.insert(OptionDefinition("threads", OT_INT));
 
 	OptionList globalOptions;
 	try